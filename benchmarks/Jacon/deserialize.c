@@ -0,0 +1,884 @@
+#include "jacon.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Previous three phase parser, the baseline to beat: the input is tokenized
+// into an array, the array validated, then the tree built from the array
+
+#define JACON_TOKENIZER_DEFAULT_CAPACITY 256
+
+typedef enum {
+    JACON_TOKEN_STRING,
+    JACON_TOKEN_INT,
+    JACON_TOKEN_FLOAT,
+    JACON_TOKEN_DOUBLE,
+    JACON_TOKEN_BOOLEAN,
+    JACON_TOKEN_ARRAY_START,
+    JACON_TOKEN_ARRAY_END,
+    JACON_TOKEN_OBJECT_START,
+    JACON_TOKEN_OBJECT_END,
+    JACON_TOKEN_NULL,
+    JACON_TOKEN_COLON,
+    JACON_TOKEN_COMMA,
+} Jacon_TokenType;
+
+typedef struct {
+    Jacon_TokenType type;
+    union {
+        char* string_val;
+        int int_val;
+        float float_val;
+        double double_val;
+        struct {
+            double base;
+            double exponent;
+        } exponential;
+        bool bool_val;
+    };
+} Jacon_Token;
+
+typedef struct {
+    size_t count;
+    size_t capacity;
+    Jacon_Token* tokens;
+    // Arena of the tokens and their strings, NULL for the heap
+    Ju_Arena* arena;
+} Jacon_Tokenizer;
+
+bool
+Jacon_is_hex_digit(char c);
+bool
+Jacon_is_whitespace(char c);
+Jacon_Error
+Jacon_build_content(Jacon_content* content);
+Jacon_Error
+Jacon_arena_append_child(Ju_Arena* arena, Jacon_Node* node, const Jacon_Node* child);
+
+Jacon_Error
+tokens_tokenizer_init(Jacon_Tokenizer* tokenizer)
+{
+    tokenizer->tokens = (Jacon_Token*)Ju_calloc(tokenizer->arena,
+        JACON_TOKENIZER_DEFAULT_CAPACITY, sizeof(Jacon_Token));
+    if (tokenizer->tokens == NULL) {
+        perror("Jacon_append_token array alloc error");
+        return JACON_ERR_MEMORY_ALLOCATION;
+    }
+    tokenizer->capacity = JACON_TOKENIZER_DEFAULT_CAPACITY;
+    tokenizer->count = 0;
+    return JACON_OK;
+}
+
+void
+tokens_free_tokenizer(Jacon_Tokenizer* tokenizer)
+{
+    if (tokenizer->arena != NULL) {
+        tokenizer->tokens = NULL;
+        return;
+    }
+    for (size_t i = 0; i < tokenizer->count; i++)
+    {
+        if (tokenizer->tokens[i].type == JACON_TOKEN_STRING)
+            free(tokenizer->tokens[i].string_val);
+    }
+    if (tokenizer->tokens) {
+        free(tokenizer->tokens);
+        tokenizer->tokens = NULL;
+    }
+}
+
+Jacon_Error
+tokens_append_token(Jacon_Tokenizer* tokenizer, Jacon_Token token)
+{
+    if (tokenizer == NULL) {
+        return JACON_ERR_NULL_PARAM;
+    }
+    if (tokenizer->tokens == NULL) {
+        tokenizer->tokens = (Jacon_Token*)Ju_calloc(tokenizer->arena,
+            JACON_TOKENIZER_DEFAULT_CAPACITY, sizeof(Jacon_Token));
+        if (tokenizer->tokens == NULL) {
+            perror("Jacon_append_token array alloc error");
+            return JACON_ERR_MEMORY_ALLOCATION;
+        }
+        tokenizer->capacity = JACON_TOKENIZER_DEFAULT_CAPACITY;
+    }
+    if (tokenizer->count >= tokenizer->capacity) {
+        size_t new_capacity = tokenizer->capacity * 2;
+        Jacon_Token* new_tokens = Ju_realloc(tokenizer->arena, tokenizer->tokens,
+            tokenizer->capacity * sizeof(Jacon_Token), new_capacity * sizeof(Jacon_Token));
+        if (!new_tokens) {
+            return JACON_ERR_MEMORY_ALLOCATION;
+        }
+        tokenizer->tokens = new_tokens;
+        tokenizer->capacity = new_capacity;
+    }
+
+    tokenizer->tokens[tokenizer->count++] = token;
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_validate_string(const char* str)
+{
+    const char *ptr = str;
+    while (*ptr) {
+        if (*ptr == '\n'
+            || *ptr == '\t') return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+        else if (*ptr == '\\') {
+            ptr++;
+            if (*ptr == 'u') {
+                for (int i = 1; i < 5; ++i) {
+                    if (!Jacon_is_hex_digit(*(ptr + i))) {
+                        return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+                    }
+                }
+                ptr += 4; // Skip valid escape sequence
+            } else if (*ptr == '"' 
+                || *ptr == '\\' 
+                || *ptr == '/' 
+                || *ptr == 'b' 
+                || *ptr == 'f' 
+                || *ptr == 'n' 
+                || *ptr == 'r' 
+                || *ptr == 't') {
+                ptr++;
+            } else {
+                return JACON_ERR_INVALID_ESCAPE_SEQUENCE; // Invalid escape sequence
+            }
+        } else {
+            ptr++; // Move to the next character
+        }
+    }
+    return JACON_OK;
+}
+
+Jacon_Error 
+tokens_parse_token(Ju_Arena* arena, Jacon_Token* token, const char** str) 
+{
+    switch (**str) {
+        case ',':
+            token->type = JACON_TOKEN_COMMA;
+            (*str)++;
+            break;
+        case ':':
+            token->type = JACON_TOKEN_COLON;
+            (*str)++;
+            break;
+        case '{':
+            token->type = JACON_TOKEN_OBJECT_START;
+            (*str)++;
+            break;
+        case '}':
+            token->type = JACON_TOKEN_OBJECT_END;
+            (*str)++;
+            break;
+        case '[':
+            token->type = JACON_TOKEN_ARRAY_START;
+            (*str)++;
+            break;
+        case ']':
+            token->type = JACON_TOKEN_ARRAY_END;
+            (*str)++;
+            break;
+        case '"':
+            (*str)++; // Move past the initial quote
+            const char* string_end = strchr(*str, '"');
+            if (string_end == NULL) return JACON_ERR_CHAR_NOT_FOUND;
+
+            // While the double quote is escaped, find the next one
+            while (string_end[-1] == '\\') {
+                string_end = strchr(string_end + 1, '"');
+                if (string_end == NULL) return JACON_ERR_CHAR_NOT_FOUND;
+            }
+            token->type = JACON_TOKEN_STRING;
+            size_t string_size = string_end - *str;
+            token->string_val = Ju_strndup(arena, *str, string_size);
+            if (token->string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+
+            int ret = tokens_validate_string(token->string_val);
+            if (ret != JACON_OK) {
+                Ju_free(arena, token->string_val);
+                return ret;
+            }
+
+            *str = string_end + 1; // Move past the closing quote
+            break;
+        case('n'):
+            if (strncmp(*str, "null", 4) != 0) return JACON_ERR_INVALID_JSON;
+            token->type = JACON_TOKEN_NULL;
+            (*str) += 4;
+            break;
+        case('t'):
+            if (strncmp(*str, "true", 4) != 0) return JACON_ERR_INVALID_JSON;
+            token->type = JACON_TOKEN_BOOLEAN;
+            token->bool_val = true;
+            (*str) += 4;
+            break;
+        case('f'):
+            if (strncmp(*str, "false", 5) != 0) return JACON_ERR_INVALID_JSON;
+            token->type = JACON_TOKEN_BOOLEAN;
+            token->bool_val = false;
+            (*str) += 5;
+            break;
+        case('\0'):
+            return JACON_END_OF_INPUT;
+        default:
+            // Check if whitespace
+            if(Jacon_is_whitespace(**str)) {
+                (*str)++;
+                return tokens_parse_token(arena, token, str);
+            }
+            // Invalidate hex values
+            else if (**str == '0' && (*str)[1] == 'x') return JACON_ERR_INVALID_JSON;
+            // Invalidate leading 0
+            else if (**str == '0' && (*str)[1] >= '0' && (*str)[1] <= '9') return JACON_ERR_INVALID_JSON;
+            // Check if char is a number or a negative number
+            else if ((**str >= '0' && **str <= '9') 
+                || (**str == '-' && (((*str)[1] >= '0' && (*str)[1] <= '9')))) {
+                if (**str == '-' && (*str)[1] == '0' && ((*str)[2] != '.' || !isdigit((*str)[2]))) {
+                    const char* p = *str + 1;
+                    while (*p == '0') p++;
+                    if (isdigit(*p)) return JACON_ERR_INVALID_JSON;
+                }
+                char* dot = strchr(*str, '.');
+                if (dot) {
+                    // Check for leading 0, if real, check if distance between last '0' and '.' > 1
+                    char* last_zero = strrchr(*str, '0');
+                    if (last_zero && dot - last_zero > 1) return JACON_ERR_INVALID_JSON;
+                    // Check if there is a dot and if so if there are numbers after
+                    char* after_dot = dot + 1;
+                    if (!isdigit(*after_dot)) return JACON_ERR_INVALID_JSON;
+                }
+                
+                char *endptr;
+                // Parse an int
+                int ival = (int)strtol(*str, &endptr, 10);
+                if ((isspace(*endptr) || *endptr == ',' || *endptr == ']' || *endptr == '}' || *endptr == '\0')
+                    && ival >= INT_MIN && ival <= INT_MAX) {
+                    token->int_val = ival;
+                    token->type = JACON_TOKEN_INT;
+                    *str = endptr;
+                    break;
+                }
+
+                double dval = strtod(*str, &endptr);
+    
+                // Ensure the number is followed by valid JSON characters
+                if (!isspace(*endptr) && *endptr != ',' && *endptr != ']' && *endptr != '}' && *endptr != '\0') {
+                    return JACON_ERR_INVALID_JSON;
+                }
+                
+                float fval = (float)dval;
+                double recast = (double)fval;
+                if (dval > recast) {
+                    token->type = JACON_TOKEN_DOUBLE;
+                    token->double_val = dval;
+                } else {
+                    token->type = JACON_TOKEN_FLOAT;
+                    token->float_val = fval;
+                }
+
+                *str = endptr;
+            }
+            else return JACON_ERR_INVALID_JSON;
+    }
+    return JACON_OK;
+}
+
+Jacon_Error 
+tokens_tokenize(Jacon_Tokenizer* tokenizer, const char* str) 
+{
+    Jacon_Error ret;
+
+    while (*str) {
+        Jacon_Token token = {0};
+        ret = tokens_parse_token(tokenizer->arena, &token, &str);
+        if (ret == JACON_END_OF_INPUT) return JACON_OK;
+        if (ret != JACON_OK) return ret;
+        ret = tokens_append_token(tokenizer, token);
+        if (ret != JACON_OK) return ret;
+    }
+
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_current_token(Jacon_Token* token, Jacon_Tokenizer* tokenizer, size_t current_index)
+{
+    if (current_index >= tokenizer->count) return JACON_ERR_INDEX_OUT_OF_BOUND;
+    *token = tokenizer->tokens[current_index];
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_consume_token(Jacon_Token* token, Jacon_Tokenizer* tokenizer, size_t* current_index)
+{
+    if (*current_index >= tokenizer->count) return JACON_ERR_INDEX_OUT_OF_BOUND;
+    *token = tokenizer->tokens[*current_index + 1];
+    *current_index += 1;
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_validate_object(Jacon_Tokenizer* tokenizer, size_t* index);
+Jacon_Error
+tokens_validate_array(Jacon_Tokenizer* tokenizer, size_t* index);
+
+Jacon_Error
+tokens_validate_array(Jacon_Tokenizer* tokenizer, size_t* index)
+{
+    int ret = JACON_OK;
+    Jacon_Token* current = NULL;
+    bool last_value = false;
+    
+    if (*index < tokenizer->count) {
+        current = &tokenizer->tokens[*index];
+    } else {
+        return JACON_ERR_INVALID_JSON;
+    }
+
+    while (current->type != JACON_TOKEN_ARRAY_END) {
+        current = &tokenizer->tokens[*index];
+        switch (current->type) {
+            case JACON_TOKEN_ARRAY_START:
+                (*index)++;
+                ret = tokens_validate_array(tokenizer, index);
+                if (ret != JACON_OK) return ret;
+                last_value = true;
+                break;
+            case JACON_TOKEN_OBJECT_START:
+                (*index)++;
+                ret = tokens_validate_object(tokenizer, index);
+                if (ret != JACON_OK) return ret;
+                last_value = true;
+                break;
+            case JACON_TOKEN_COMMA:
+                if (!last_value) {
+                    return JACON_ERR_INVALID_JSON;
+                }
+                else {
+                    last_value = false;
+                    (*index)++;    
+                }
+                break;
+            case JACON_TOKEN_ARRAY_END:
+                return JACON_ERR_UNREACHABLE_STATEMENT;
+            case JACON_TOKEN_OBJECT_END:
+            case JACON_TOKEN_COLON:
+                return JACON_ERR_INVALID_JSON;
+            case JACON_TOKEN_STRING:
+            case JACON_TOKEN_INT:
+            case JACON_TOKEN_DOUBLE:
+            case JACON_TOKEN_FLOAT:
+            case JACON_TOKEN_BOOLEAN:
+            case JACON_TOKEN_NULL:
+            default:
+                if(last_value) return JACON_ERR_INVALID_JSON;
+                last_value = true;
+                (*index)++;
+                break;
+        }
+        if (*index >= tokenizer->count) {
+            return JACON_ERR_INVALID_JSON;
+        }
+        current = &tokenizer->tokens[*index];
+    }
+    (*index)++;
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_validate_object(Jacon_Tokenizer* tokenizer, size_t* index)
+{
+    int ret = JACON_OK;
+    if (*index >= tokenizer->count) return JACON_ERR_INVALID_JSON;
+    if (*index >= tokenizer->count) {
+        return JACON_ERR_INVALID_JSON;
+    }
+    Jacon_Token* current = &tokenizer->tokens[*index];
+    Jacon_Token* last = NULL;
+    Jacon_HashSet names_set = (Jacon_HashSet){
+        .entries = Ju_calloc(tokenizer->arena, 10, sizeof(Jacon_HashSetEntry*)),
+        .capacity = 10,
+        .arena = tokenizer->arena
+    };
+    if (names_set.entries == NULL) {
+        return JACON_ERR_MEMORY_ALLOCATION;
+    }
+    bool last_value = false;
+    while (current->type != JACON_TOKEN_OBJECT_END) {
+        current = &tokenizer->tokens[*index];
+        switch (current->type) {
+            case JACON_TOKEN_ARRAY_START:
+                if (last == NULL || last->type != JACON_TOKEN_COLON)
+                    return JACON_ERR_INVALID_JSON;
+
+                (*index)++;
+                ret = tokens_validate_array(tokenizer, index);
+                if (ret != JACON_OK) return ret;
+                last_value = true;
+                break;
+            case JACON_TOKEN_OBJECT_START:
+                if (last == NULL || last->type != JACON_TOKEN_COLON)
+                    return JACON_ERR_INVALID_JSON;
+
+                (*index)++;
+                ret = tokens_validate_object(tokenizer, index);
+                if (ret != JACON_OK) return ret;
+                last_value = true;
+                break;
+            case JACON_TOKEN_COMMA:
+                if (last == NULL) return JACON_ERR_INVALID_JSON;
+                else if (!last_value) {
+                    return JACON_ERR_INVALID_JSON;
+                }
+                last = &tokenizer->tokens[*index];
+                (*index)++;
+                last_value = false;
+                break;
+            case JACON_TOKEN_ARRAY_END:
+                return JACON_ERR_INVALID_JSON;
+            case JACON_TOKEN_OBJECT_END:
+                return JACON_ERR_UNREACHABLE_STATEMENT;
+            case JACON_TOKEN_COLON:
+                if (last == NULL) return JACON_ERR_INVALID_JSON;
+                if (last->type != JACON_TOKEN_STRING) return JACON_ERR_INVALID_JSON;
+                last = &tokenizer->tokens[*index];
+                (*index)++;
+                break;
+            case JACON_TOKEN_STRING:
+                if (last == NULL) {
+                    if (Jacon_hs_exists(&names_set, tokenizer->tokens[*index].string_val)) {
+                        Jacon_hs_free(&names_set);
+                        return JACON_ERR_DUPLICATE_NAME;
+                    }
+                    Jacon_hs_put(&names_set, tokenizer->tokens[*index].string_val);
+                    last = &tokenizer->tokens[*index];
+                    (*index)++;
+                }
+                else if (last->type == JACON_TOKEN_COMMA) {
+                    if (Jacon_hs_exists(&names_set, tokenizer->tokens[*index].string_val)) {
+                        Jacon_hs_free(&names_set);
+                        return JACON_ERR_DUPLICATE_NAME;
+                    }
+                    Jacon_hs_put(&names_set, tokenizer->tokens[*index].string_val);
+                    last = &tokenizer->tokens[*index];
+                    (*index)++;
+                    last_value = true;
+                }
+                else if (last->type == JACON_TOKEN_COLON ) {
+                    last = &tokenizer->tokens[*index];
+                    (*index)++;
+                    last_value = true;
+                }
+                else {
+                    return JACON_ERR_UNREACHABLE_STATEMENT;
+                }
+                break;
+            case JACON_TOKEN_INT:
+            case JACON_TOKEN_DOUBLE:
+            case JACON_TOKEN_FLOAT:
+            case JACON_TOKEN_BOOLEAN:
+            case JACON_TOKEN_NULL:
+                if (last == NULL || last->type != JACON_TOKEN_COLON)
+                    return JACON_ERR_INVALID_JSON;
+                last = &tokenizer->tokens[*index];
+                (*index)++;
+                last_value = true;
+                break;
+            default:
+                return JACON_ERR_UNREACHABLE_STATEMENT;
+        }
+        if (*index >= tokenizer->count) {
+            return JACON_ERR_INVALID_JSON;
+        }
+        current = &tokenizer->tokens[*index];
+    }
+    Jacon_hs_free(&names_set);
+    (*index)++;
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_validate_value(Jacon_Token token)
+{
+    switch (token.type) {
+        case JACON_TOKEN_STRING:
+        case JACON_TOKEN_INT:
+        case JACON_TOKEN_DOUBLE:
+        case JACON_TOKEN_FLOAT:
+        case JACON_TOKEN_BOOLEAN:
+        case JACON_TOKEN_NULL:
+            return JACON_OK;
+        case JACON_TOKEN_ARRAY_START:
+        case JACON_TOKEN_ARRAY_END:
+        case JACON_TOKEN_OBJECT_START:
+        case JACON_TOKEN_OBJECT_END:
+        case JACON_TOKEN_COMMA:
+        case JACON_TOKEN_COLON:
+            return JACON_ERR_INVALID_JSON;
+    }
+    return JACON_ERR_UNREACHABLE_STATEMENT;
+}
+
+/**
+ * Validate a Jacon tokenizer result
+ */
+Jacon_Error
+tokens_validate_input(Jacon_Tokenizer* tokenizer)
+{
+    int ret = JACON_OK;
+
+    if (tokenizer->count == 1) {
+        ret = tokens_validate_value(tokenizer->tokens[0]);
+        return ret;
+    }
+
+    Jacon_Token* current = NULL;
+    size_t index = 0;
+    current = &tokenizer->tokens[index];
+    switch (current->type) {
+        case JACON_TOKEN_ARRAY_START:
+            index++;
+            ret = tokens_validate_array(tokenizer, &index);
+            if (ret != JACON_OK) return ret;
+            break;
+        case JACON_TOKEN_OBJECT_START:
+            index++;
+            ret = tokens_validate_object(tokenizer, &index);
+            if (ret != JACON_OK) return ret;
+            break;
+        case JACON_TOKEN_STRING:
+        case JACON_TOKEN_INT:
+        case JACON_TOKEN_DOUBLE:
+        case JACON_TOKEN_FLOAT:
+        case JACON_TOKEN_BOOLEAN:
+        case JACON_TOKEN_NULL:
+        case JACON_TOKEN_ARRAY_END:
+        case JACON_TOKEN_OBJECT_END:
+        case JACON_TOKEN_COMMA:
+        case JACON_TOKEN_COLON:
+        default:
+            return JACON_ERR_UNREACHABLE_STATEMENT;
+    }
+    if (index < tokenizer->count) return JACON_ERR_INVALID_JSON;
+
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_parse_node(Jacon_Node* node, Jacon_Node* parent, Jacon_Tokenizer* tokenizer, size_t* current_index)
+{
+    int ret = JACON_OK;
+    Jacon_Token current_token;
+    ret = tokens_current_token(&current_token, tokenizer, *current_index);
+    if (ret != JACON_OK) return ret;
+    switch (current_token.type) {
+        case JACON_TOKEN_OBJECT_START:
+            node->type = JACON_VALUE_OBJECT;
+
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            while (current_token.type != JACON_TOKEN_OBJECT_END) {
+                Jacon_Node child = {0};
+                ret = tokens_parse_node(&child, node, tokenizer, current_index);
+                if (ret != JACON_OK) return ret;
+
+                ret = Jacon_arena_append_child(tokenizer->arena, node, &child);
+                if (ret != JACON_OK) return ret;
+                ret = tokens_current_token(&current_token, tokenizer, *current_index);
+                if (ret != JACON_OK) return ret;
+            }
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+
+        case JACON_TOKEN_ARRAY_START:
+            node->type = JACON_VALUE_ARRAY;
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            while (current_token.type != JACON_TOKEN_ARRAY_END) {
+                Jacon_Node child = {0};
+                ret = tokens_parse_node(&child, node, tokenizer, current_index);
+                if (ret != JACON_OK) return ret;
+
+                ret = Jacon_arena_append_child(tokenizer->arena, node, &child);
+                if (ret != JACON_OK) return ret;
+                ret = tokens_current_token(&current_token, tokenizer, *current_index);
+                if (ret != JACON_OK) return ret;
+            }
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+
+        case JACON_TOKEN_STRING:
+            if (node->type == JACON_VALUE_STRING) {
+                node->value.string_val = Ju_strdup(tokenizer->arena, current_token.string_val);
+                if (node->value.string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+
+                ret = tokens_consume_token(&current_token, tokenizer, current_index);
+                if (ret != JACON_OK) return ret;
+            }
+            else if (parent != NULL && parent->type == JACON_VALUE_ARRAY) {
+                node->type = JACON_VALUE_STRING;
+                node->value.string_val = Ju_strdup(tokenizer->arena, current_token.string_val);
+                if (node->value.string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+
+                ret = tokens_consume_token(&current_token, tokenizer, current_index);
+                if (ret != JACON_OK) return ret;
+            }
+            else {
+                node->type = JACON_VALUE_STRING;
+                node->name = Ju_strdup(tokenizer->arena, current_token.string_val);
+                if (node->name == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+
+                ret = tokens_consume_token(&current_token, tokenizer, current_index);
+                if (ret != JACON_OK) return ret;
+
+                ret = tokens_parse_node(node, parent, tokenizer, current_index);
+                if (ret != JACON_OK) return ret;
+            }
+            break;
+
+        case JACON_TOKEN_BOOLEAN:
+            node->type = JACON_VALUE_BOOLEAN;
+            node->value.bool_val = current_token.bool_val;
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+
+        case JACON_TOKEN_INT:
+            node->type = JACON_VALUE_INT;
+            node->value.int_val = current_token.int_val;
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+
+        case JACON_TOKEN_FLOAT:
+            node->type = JACON_VALUE_FLOAT;
+            node->value.float_val = current_token.float_val;
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+
+        case JACON_TOKEN_DOUBLE:
+            node->type = JACON_VALUE_DOUBLE;
+            node->value.double_val = current_token.double_val;
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+
+        case JACON_TOKEN_NULL:
+            node->type = JACON_VALUE_NULL;
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            break;
+            
+        case JACON_TOKEN_COLON:
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            return tokens_parse_node(node, parent, tokenizer, current_index);
+        case JACON_TOKEN_COMMA:
+            ret = tokens_consume_token(&current_token, tokenizer, current_index);
+            if (ret != JACON_OK) return ret;
+            return tokens_parse_node(node, parent, tokenizer, current_index);
+        case JACON_TOKEN_OBJECT_END:
+        case JACON_TOKEN_ARRAY_END:
+            // Both of these cases should never happen
+            // We skip this token when we are done parsing an array / object
+        default:
+            return JACON_ERR_UNREACHABLE_STATEMENT;
+    }
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_parse_value(Ju_Arena* arena, Jacon_Node* root, Jacon_Token token)
+{
+    switch (token.type) {
+        case JACON_TOKEN_STRING:
+            root->type = JACON_VALUE_STRING;
+            root->value.string_val = Ju_strdup(arena, token.string_val);
+            if (root->value.string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+            break;
+        case JACON_TOKEN_INT:
+            root->type = JACON_VALUE_INT;
+            root->value.int_val = token.int_val;
+            break;
+        case JACON_TOKEN_DOUBLE:
+            root->type = JACON_VALUE_DOUBLE;
+            root->value.double_val = token.double_val;
+            break;
+        case JACON_TOKEN_FLOAT:
+            root->type = JACON_VALUE_FLOAT;
+            root->value.float_val = token.float_val;
+            break;
+        case JACON_TOKEN_BOOLEAN:
+            root->type = JACON_VALUE_BOOLEAN;
+            root->value.bool_val = token.bool_val;
+            break;
+        case JACON_TOKEN_NULL:
+            root->type = JACON_VALUE_NULL;
+            break;
+        case JACON_TOKEN_ARRAY_START:
+        case JACON_TOKEN_ARRAY_END:
+        case JACON_TOKEN_OBJECT_START:
+        case JACON_TOKEN_OBJECT_END:
+        case JACON_TOKEN_COLON:
+        case JACON_TOKEN_COMMA:
+        default:
+            return JACON_ERR_UNREACHABLE_STATEMENT;
+    }
+    return JACON_OK;
+}
+
+/**
+ * Parse a Jacon tokenizer content into a queryable C variable
+ */
+Jacon_Error
+tokens_parse_tokens(Jacon_Node* root, Jacon_Tokenizer* tokenizer)
+{
+    int ret = JACON_OK;
+    if (tokenizer->count == 1) 
+        return tokens_parse_value(tokenizer->arena, root, tokenizer->tokens[0]);
+    size_t current_index = 0;
+    while(current_index < tokenizer->count) {
+        ret = tokens_parse_node(root, NULL, tokenizer, &current_index);
+        if (ret != JACON_OK && ret != JACON_NO_MORE_TOKENS) return ret;
+    }
+    return JACON_OK;
+}
+
+Jacon_Error
+tokens_deserialize(Jacon_content* content, const char* str)
+{
+    if (content == NULL || str == NULL) return JACON_ERR_NULL_PARAM;
+    size_t len = strlen(str);
+    if (len == 0) return JACON_ERR_EMPTY_INPUT;
+
+    Jacon_Tokenizer tokenizer = { .arena = content->arena };
+    tokens_tokenizer_init(&tokenizer);
+    Jacon_Error ret = tokens_tokenize(&tokenizer, str);
+    if (ret == JACON_OK && tokenizer.count == 0) ret = JACON_ERR_EMPTY_INPUT;
+    if (ret == JACON_OK) ret = tokens_validate_input(&tokenizer);
+    if (ret == JACON_OK) ret = tokens_parse_tokens(content->root, &tokenizer);
+    tokens_free_tokenizer(&tokenizer);
+    if (ret != JACON_OK) return ret;
+    return Jacon_build_content(content);
+}
+
+// Body of a login call, what the server parses most
+const char* small_doc = "{\"login\": \"admin\", \"password\": \"correct horse battery staple\"}";
+
+#define RECORDS 64
+
+/**
+ * Array of records mixing every value type, nested objects and arrays
+ */
+char*
+make_records(void)
+{
+    size_t capacity = RECORDS * 256;
+    char* doc = malloc(capacity);
+    size_t len = snprintf(doc, capacity, "[");
+    for (int i = 0; i < RECORDS; i++) {
+        len += snprintf(doc + len, capacity - len,
+            "%s{\"id\": %d, \"name\": \"user%d\", \"email\": \"user%d@example\", \"active\": %s, "
+            "\"score\": %d.%d, \"tags\": [\"a\", \"b\", \"c\"], "
+            "\"address\": {\"city\": \"Brussels\", \"zip\": \"10%02d\"}, \"manager\": null}",
+            i > 0 ? ", " : "", i, i, i, i % 2 ? "true" : "false", i * 7, i % 10, i);
+    }
+    snprintf(doc + len, capacity - len, "]");
+    return doc;
+}
+
+double
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Bytes handed out by an arena, the memory a parse writes
+ */
+size_t
+arena_used(Ju_Arena* arena)
+{
+    size_t used = 0;
+    for (Ju_Arena_Chunk* chunk = arena->head; chunk != NULL; chunk = chunk->next) used += chunk->used;
+    for (Ju_Arena_Chunk* chunk = arena->large; chunk != NULL; chunk = chunk->next) used += chunk->used;
+    return used;
+}
+
+void
+bench(const char* name, const char* doc, int iterations, Jacon_Error (*deserialize)(Jacon_content*, const char*))
+{
+    // Parsed in a request arena recycled through a pool, as by the server
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    size_t len = strlen(doc);
+    size_t used = 0;
+
+    double start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        Jacon_content content = { .arena = &arena };
+        Jacon_init_content(&content);
+        if (deserialize(&content, doc) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): %s failed to parse\n", __FILE__, __LINE__, name);
+            exit(EXIT_FAILURE);
+        }
+        if (i == 0) used = arena_used(&arena);
+        Ju_arena_reset(&arena);
+    }
+    double elapsed = now_ns() - start;
+
+    printf("%-12s %10.1f ns/doc %8.1f MB/s %8zu arena bytes/doc\n",
+        name, elapsed / iterations, len * iterations / elapsed * 1e3, used);
+    Ju_arena_pool_free(&pool);
+}
+
+/**
+ * Both parsers must build the same tree
+ */
+void
+compare(const char* doc)
+{
+    Jacon_content expected = {0};
+    Jacon_content actual = {0};
+    Jacon_init_content(&expected);
+    Jacon_init_content(&actual);
+    char* expected_str = NULL;
+    char* actual_str = NULL;
+    if (tokens_deserialize(&expected, doc) != JACON_OK
+        || Jacon_deserialize(&actual, doc) != JACON_OK
+        || Jacon_serialize_unformatted(expected.root, NULL, &expected_str) != JACON_OK
+        || Jacon_serialize_unformatted(actual.root, NULL, &actual_str) != JACON_OK
+        || strcmp(expected_str, actual_str) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): parsers disagree\n", __FILE__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+    free(expected_str);
+    free(actual_str);
+}
+
+int main(void) {
+    char* records = make_records();
+    compare(small_doc);
+    compare(records);
+
+    printf("%zu byte login body, 200000 iterations\n", strlen(small_doc));
+    bench("three-phase", small_doc, 200000, tokens_deserialize);
+    bench("single-pass", small_doc, 200000, Jacon_deserialize);
+
+    printf("%zu byte array of %d records, 2000 iterations\n", strlen(records), RECORDS);
+    bench("three-phase", records, 2000, tokens_deserialize);
+    bench("single-pass", records, 2000, Jacon_deserialize);
+
+    free(records);
+    return 0;
+}
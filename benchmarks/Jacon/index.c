@@ -0,0 +1,182 @@
+#include "jacon.h"
+#include "jacon_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Size the generated corpora grow to, files given as arguments are used as is
+#define CORPUS_SIZE (8 * 1024 * 1024)
+// Bytes to go through per measure, whatever the corpus size
+#define BENCH_BYTES (256L * 1024 * 1024)
+
+typedef struct {
+    const char* name;
+    char* doc;
+    size_t len;
+} Corpus;
+
+/**
+ * Append to doc while it is shorter than CORPUS_SIZE, a record at a time
+ */
+char*
+make_corpus(const char* open, const char* close, int (*record)(char* out, size_t size, int i))
+{
+    size_t capacity = CORPUS_SIZE + 4096;
+    char* doc = malloc(capacity);
+    size_t len = snprintf(doc, capacity, "%s", open);
+    for (int i = 0; len < CORPUS_SIZE; i++) {
+        if (i > 0) len += snprintf(doc + len, capacity - len, ",\n");
+        len += record(doc + len, capacity - len, i);
+    }
+    snprintf(doc + len, capacity - len, "%s", close);
+    return doc;
+}
+
+// API objects: short strings, small numbers, nesting
+int
+record_object(char* out, size_t size, int i)
+{
+    return snprintf(out, size,
+        "  {\"id\": %d, \"name\": \"user%d\", \"email\": \"user%d@example\", \"active\": %s, "
+        "\"score\": %d.%d, \"tags\": [\"a\", \"b\", \"c\"], "
+        "\"address\": {\"city\": \"Brussels\", \"zip\": \"10%02d\"}, \"manager\": null}",
+        i, i, i, i % 2 ? "true" : "false", i * 7, i % 10, i % 100);
+}
+
+// Log lines: long strings with escaped quotes, backslashes and unicode
+int
+record_text(char* out, size_t size, int i)
+{
+    return snprintf(out, size,
+        "  {\"level\": \"info\", \"message\": \"request %d served from C:\\\\srv\\\\www in %d ms, "
+        "user agent \\\"Mozilla/5.0 (X11; Linux x86_64)\\\", path \\u002Fapi\\u002Fitems\\u002F%d, "
+        "the quick brown fox jumps over the lazy dog\"}",
+        i, i % 250, i);
+}
+
+// Measurements: numbers only
+int
+record_numbers(char* out, size_t size, int i)
+{
+    return snprintf(out, size, "  [%d, %d.%03d, -%d.%02de-%d, %d]",
+        i, i % 1000, i % 997, i % 89, i % 100, i % 9, i * 31);
+}
+
+double
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Stage 1 alone, indexing the structural characters
+ */
+void
+bench_index(const char* name, Corpus* corpus)
+{
+    Jacon_Index index = {0};
+    long iterations = BENCH_BYTES / corpus->len + 1;
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        if (Jacon_index_build(&index, corpus->doc, corpus->len) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): %s failed to index %s\n", __FILE__, __LINE__, name, corpus->name);
+            exit(EXIT_FAILURE);
+        }
+    }
+    double elapsed = now_ns() - start;
+    printf("  index %-8s %6.2f GB/s %10zu structurals\n",
+        name, corpus->len * iterations / elapsed, index.count);
+    Jacon_index_free(&index);
+}
+
+/**
+ * Both stages, the tree built in an arena recycled through a pool as by the server
+ */
+void
+bench_deserialize(const char* name, Corpus* corpus)
+{
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    long iterations = BENCH_BYTES / 16 / corpus->len + 1;
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        Jacon_content content = { .arena = &arena };
+        Jacon_init_content(&content);
+        if (Jacon_deserialize(&content, corpus->doc) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): %s failed to parse %s\n", __FILE__, __LINE__, name, corpus->name);
+            exit(EXIT_FAILURE);
+        }
+        Ju_arena_reset(&arena);
+    }
+    double elapsed = now_ns() - start;
+    printf("  parse %-8s %6.2f GB/s\n", name, corpus->len * iterations / elapsed);
+    Ju_arena_pool_free(&pool);
+}
+
+char*
+read_file(const char* path, size_t* len)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    *len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* doc = malloc(*len + 1);
+    if (doc != NULL && fread(doc, 1, *len, file) != *len) {
+        free(doc);
+        doc = NULL;
+    }
+    if (doc != NULL) doc[*len] = '\0';
+    fclose(file);
+    return doc;
+}
+
+int main(int argc, char** argv) {
+    Corpus corpora[16];
+    int count = 0;
+    if (argc > 1) {
+        // Local corpora, e.g. twitter.json or citm_catalog.json
+        for (int i = 1; i < argc && count < 16; i++) {
+            size_t len;
+            char* doc = read_file(argv[i], &len);
+            if (doc == NULL) {
+                perror(argv[i]);
+                return EXIT_FAILURE;
+            }
+            corpora[count++] = (Corpus){ argv[i], doc, len };
+        }
+    } else {
+        corpora[count++] = (Corpus){ "objects", make_corpus("[\n", "\n]", record_object), 0 };
+        corpora[count++] = (Corpus){ "text", make_corpus("[\n", "\n]", record_text), 0 };
+        corpora[count++] = (Corpus){ "numbers", make_corpus("[\n", "\n]", record_numbers), 0 };
+        for (int i = 0; i < count; i++) corpora[i].len = strlen(corpora[i].doc);
+    }
+
+    const char* selected = Jacon_index_init();
+    printf("runtime selected: %s\n", selected);
+    Jacon_Index_Masks (*dispatched)(const char*) = Jacon_index_block;
+    for (int i = 0; i < count; i++) {
+        printf("%s, %zu bytes\n", corpora[i].name, corpora[i].len);
+        Jacon_index_block = Jacon_index_block_scalar;
+        bench_index("scalar", &corpora[i]);
+        bench_deserialize("scalar", &corpora[i]);
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("sse4.2")) {
+            Jacon_index_block = Jacon_index_block_sse42;
+            bench_index("sse4.2", &corpora[i]);
+            bench_deserialize("sse4.2", &corpora[i]);
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            Jacon_index_block = Jacon_index_block_avx2;
+            bench_index("avx2", &corpora[i]);
+            bench_deserialize("avx2", &corpora[i]);
+        }
+#endif
+        free(corpora[i].doc);
+    }
+    Jacon_index_block = dispatched;
+    return 0;
+}
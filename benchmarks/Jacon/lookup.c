@@ -0,0 +1,86 @@
+#include "jacon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Records appended after the credentials of the large body
+#define LARGE_RECORDS 20000
+
+double
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+size_t
+arena_used(Ju_Arena* arena)
+{
+    size_t used = 0;
+    for (Ju_Arena_Chunk* chunk = arena->head; chunk != NULL; chunk = chunk->next) used += chunk->used;
+    for (Ju_Arena_Chunk* chunk = arena->large; chunk != NULL; chunk = chunk->next) used += chunk->used;
+    return used;
+}
+
+/**
+ * Read two fields of a body as route_post_login does, from a full tree or a lazy content
+ */
+void
+bench_lookup(const char* name, const char* body, Jacon_Error (*deserialize)(Jacon_content*, const char*), long iterations)
+{
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    size_t arena_bytes = 0;
+    double start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        Jacon_content content = { .arena = &arena };
+        Jacon_init_content(&content);
+        if (deserialize(&content, body) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): %s failed to parse\n", __FILE__, __LINE__, name);
+            exit(EXIT_FAILURE);
+        }
+        char* login = NULL;
+        char* city = NULL;
+        Jacon_get_string_by_name(&content, "login", &login);
+        Jacon_get_string_by_name(&content, "user.address.city", &city);
+        if (login == NULL || city == NULL) {
+            fprintf(stderr, "ERROR(%s:%d): %s did not find the fields\n", __FILE__, __LINE__, name);
+            exit(EXIT_FAILURE);
+        }
+        free(login);
+        free(city);
+        arena_bytes = arena_used(&arena);
+        Jacon_free_content(&content);
+        Ju_arena_reset(&arena);
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-6s %10.0f ns/body %10zu arena bytes\n", name, elapsed / iterations, arena_bytes);
+    Ju_arena_pool_free(&pool);
+}
+
+int main(void) {
+    const char* login = "{\"login\": \"jdoe\", \"password\": \"hunter2\", "
+        "\"user\": {\"address\": {\"city\": \"Brussels\"}}}";
+
+    // Same fields followed by a large array nobody reads
+    size_t capacity = LARGE_RECORDS * 128 + 256;
+    char* large = malloc(capacity);
+    size_t len = snprintf(large, capacity, "{\"login\": \"jdoe\", \"password\": \"hunter2\", "
+        "\"user\": {\"address\": {\"city\": \"Brussels\"}}, \"history\": [");
+    for (int i = 0; i < LARGE_RECORDS; i++) {
+        len += snprintf(large + len, capacity - len, "%s{\"id\": %d, \"at\": %d.%d, \"tags\": [\"a\", \"b\"]}",
+            i > 0 ? ", " : "", i, i * 3, i % 10);
+    }
+    snprintf(large + len, capacity - len, "]}");
+
+    printf("login body, %zu bytes\n", strlen(login));
+    bench_lookup("tree", login, Jacon_deserialize, 200000);
+    bench_lookup("lazy", login, Jacon_deserialize_lazy, 200000);
+    printf("large body, %zu bytes\n", strlen(large));
+    bench_lookup("tree", large, Jacon_deserialize, 100);
+    bench_lookup("lazy", large, Jacon_deserialize_lazy, 100);
+    free(large);
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "jacon.h"
+#include "jacon_number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Numbers in each corpus
+#define NUMBER_COUNT 1000000
+#define ITERATIONS 8
+
+double
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+uint64_t
+next_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Ids and millisecond timestamps, the latter beyond an int
+int
+number_integer(char* out, size_t size, uint64_t random)
+{
+    if (random & 1) return snprintf(out, size, "%d", (int)(random >> 40));
+    return snprintf(out, size, "%llu", 1700000000000ULL + (random >> 24) % 100000000000ULL);
+}
+
+// Prices and measurements with a few decimals
+int
+number_decimal(char* out, size_t size, uint64_t random)
+{
+    return snprintf(out, size, "%d.%02d", (int)(random >> 48) % 10000, (int)(random % 100));
+}
+
+// Doubles printed with every digit needed to read them back
+int
+number_double(char* out, size_t size, uint64_t random)
+{
+    double value = (double)(random >> 11) / (double)(1ULL << 53) * 1e6 - 5e5;
+    return snprintf(out, size, "%.17g", value);
+}
+
+/**
+ * Array of NUMBER_COUNT numbers written by format
+ */
+char*
+make_corpus(int (*format)(char*, size_t, uint64_t))
+{
+    size_t capacity = (size_t)NUMBER_COUNT * 32 + 16;
+    char* doc = malloc(capacity);
+    size_t len = snprintf(doc, capacity, "[");
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < NUMBER_COUNT; i++) {
+        if (i > 0) len += snprintf(doc + len, capacity - len, ", ");
+        len += format(doc + len, capacity - len, next_random(&state));
+    }
+    snprintf(doc + len, capacity - len, "]");
+    return doc;
+}
+
+/**
+ * Convert every number of a corpus as Jacon did before, strtol then strtod
+ */
+void
+bench_libc(const char* doc)
+{
+    double sum = 0;
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        char* end = (char*)doc;
+        while (*end != ']') {
+            const char* ptr = end + (end == doc ? 1 : 2);
+            long lval = strtol(ptr, &end, 10);
+            if (*end == '.' || *end == 'e' || *end == 'E') {
+                sum += strtod(ptr, &end);
+            } else {
+                sum += (double)lval;
+            }
+        }
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-14s %6.1f ns/number %6.2f GB/s (%g)\n", "strtol/strtod",
+        elapsed / ((double)NUMBER_COUNT * ITERATIONS), strlen(doc) * ITERATIONS / elapsed, sum);
+}
+
+void
+bench_jacon(const char* doc)
+{
+    double sum = 0;
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        const char* end = doc;
+        while (*end != ']') {
+            // Past the opening bracket or the comma and space
+            const char* ptr = end + (end == doc ? 1 : 2);
+            Jacon_Number number;
+            end = Jacon_scan_number(ptr, &number);
+            Jacon_ValueType type;
+            Jacon_Value value;
+            Jacon_number_value(ptr, &number, &type, &value);
+            switch (type) {
+                case JACON_VALUE_INT: sum += value.int_val; break;
+                case JACON_VALUE_INT64: sum += (double)value.int64_val; break;
+                case JACON_VALUE_UINT64: sum += (double)value.uint64_val; break;
+                case JACON_VALUE_FLOAT: sum += value.float_val; break;
+                case JACON_VALUE_DOUBLE: sum += value.double_val; break;
+                case JACON_VALUE_OBJECT:
+                case JACON_VALUE_ARRAY:
+                case JACON_VALUE_STRING:
+                case JACON_VALUE_BOOLEAN:
+                case JACON_VALUE_NULL:
+                    break;
+            }
+        }
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-14s %6.1f ns/number %6.2f GB/s (%g)\n", "jacon",
+        elapsed / ((double)NUMBER_COUNT * ITERATIONS), strlen(doc) * ITERATIONS / elapsed, sum);
+}
+
+void
+bench_deserialize(const char* doc)
+{
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        Jacon_content content = { .arena = &arena };
+        Jacon_init_content(&content);
+        if (Jacon_deserialize(&content, doc) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): failed to parse\n", __FILE__, __LINE__);
+            exit(EXIT_FAILURE);
+        }
+        Ju_arena_reset(&arena);
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-14s %6.1f ns/number %6.2f GB/s\n", "deserialize",
+        elapsed / ((double)NUMBER_COUNT * ITERATIONS), strlen(doc) * ITERATIONS / elapsed);
+    Ju_arena_pool_free(&pool);
+}
+
+/**
+ * Serialize the tree of a corpus back, as a response with numbers in it would be
+ */
+void
+bench_serialize(const char* doc)
+{
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    Ju_Arena output = { .pool = &pool };
+    Jacon_content content = { .arena = &arena };
+    Jacon_init_content(&content);
+    if (Jacon_deserialize(&content, doc) != JACON_OK) {
+        fprintf(stderr, "ERROR(%s:%d): failed to parse\n", __FILE__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+    size_t len = 0;
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        char* str = NULL;
+        if (Jacon_serialize_unformatted(content.root, &output, &str) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): failed to serialize\n", __FILE__, __LINE__);
+            exit(EXIT_FAILURE);
+        }
+        len = strlen(str);
+        Ju_arena_reset(&output);
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-14s %6.1f ns/number %6.2f GB/s\n", "serialize",
+        elapsed / ((double)NUMBER_COUNT * ITERATIONS), len * ITERATIONS / elapsed);
+    Ju_arena_pool_free(&pool);
+}
+
+int main(void) {
+    struct { const char* name; int (*format)(char*, size_t, uint64_t); } corpora[] = {
+        { "integers", number_integer },
+        { "decimals", number_decimal },
+        { "doubles", number_double },
+    };
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        char* doc = make_corpus(corpora[i].format);
+        printf("%s, %zu bytes\n", corpora[i].name, strlen(doc));
+        bench_libc(doc);
+        bench_jacon(doc);
+        bench_deserialize(doc);
+        bench_serialize(doc);
+        free(doc);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "jacon.h"
+#include "jacon_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Size the generated corpora grow to
+#define CORPUS_SIZE (8 * 1024 * 1024)
+// Parts the input is fed in, as read from a socket
+#define CHUNK_SIZE (64 * 1024)
+#define ITERATIONS 8
+
+double
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Records of an array, or lines of an ndjson input when separator is a newline
+ */
+char*
+make_corpus(const char* open, const char* separator, const char* close)
+{
+    size_t capacity = CORPUS_SIZE + 4096;
+    char* doc = malloc(capacity);
+    size_t len = snprintf(doc, capacity, "%s", open);
+    for (int i = 0; len < CORPUS_SIZE; i++) {
+        len += snprintf(doc + len, capacity - len,
+            "%s{\"id\": %d, \"name\": \"user%d\", \"active\": %s, \"score\": %d.%d, "
+            "\"tags\": [\"a\", \"b\"], \"address\": {\"city\": \"Brussels\", \"zip\": \"10%02d\"}}",
+            i > 0 ? separator : "", i, i, i % 2 ? "true" : "false", i * 7, i % 10, i % 100);
+    }
+    snprintf(doc + len, capacity - len, "%s", close);
+    return doc;
+}
+
+int
+count_event(void* context, const Jacon_Event* event)
+{
+    (void)event;
+    (*(size_t*)context)++;
+    return 0;
+}
+
+void
+bench_stream(const char* name, const char* doc, bool ndjson)
+{
+    size_t len = strlen(doc);
+    size_t events = 0;
+    size_t token_capacity = 0;
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        events = 0;
+        Jacon_Stream stream;
+        Jacon_stream_init(&stream, count_event, &events);
+        stream.ndjson = ndjson;
+        Jacon_Error ret = JACON_OK;
+        for (size_t offset = 0; offset < len && ret == JACON_OK; offset += CHUNK_SIZE) {
+            ret = Jacon_stream_feed(&stream, doc + offset, len - offset < CHUNK_SIZE ? len - offset : CHUNK_SIZE);
+        }
+        if (ret == JACON_OK) ret = Jacon_stream_finish(&stream);
+        if (ret != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): %s failed at %zu\n", __FILE__, __LINE__, name, stream.offset);
+            exit(EXIT_FAILURE);
+        }
+        token_capacity = stream.token_capacity;
+        Jacon_stream_free(&stream);
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-18s %6.2f GB/s %10zu events %6zu token bytes\n",
+        name, len * ITERATIONS / elapsed, events, token_capacity);
+}
+
+void
+bench_deserialize(const char* name, const char* doc)
+{
+    size_t len = strlen(doc);
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        Jacon_content content = { .arena = &arena };
+        Jacon_init_content(&content);
+        if (Jacon_deserialize(&content, doc) != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): %s failed to parse\n", __FILE__, __LINE__, name);
+            exit(EXIT_FAILURE);
+        }
+        Ju_arena_reset(&arena);
+    }
+    double elapsed = now_ns() - start;
+    printf("  %-18s %6.2f GB/s\n", name, len * ITERATIONS / elapsed);
+    Ju_arena_pool_free(&pool);
+}
+
+int main(void) {
+    char* array = make_corpus("[\n", ",\n", "\n]");
+    char* lines = make_corpus("", "\n", "\n");
+    printf("array, %zu bytes in %d byte parts\n", strlen(array), CHUNK_SIZE);
+    bench_deserialize("deserialize", array);
+    bench_stream("stream", array, false);
+    printf("ndjson, %zu bytes in %d byte parts\n", strlen(lines), CHUNK_SIZE);
+    bench_stream("stream", lines, true);
+    free(array);
+    free(lines);
+    return 0;
+}
@@ -1,6 +1,7 @@
 #ifndef BASE64_H
 #define BASE64_H
 
+#include "jutils.h"
 #include <stddef.h>
 
 typedef enum {
@@ -23,17 +24,21 @@ Base64_char_to_value(char c);
 Base64_Error
 Base64_is_valid(const char* str);
 
+/**
+ * Encoding and decoding functions allocate their output in arena,
+ *  or on the heap if arena is NULL
+ */
 Base64_Error
-Base64_encode(const unsigned char* data, size_t input_length, char** output);
+Base64_encode(const unsigned char* data, size_t input_length, Ju_Arena* arena, char** output);
 
 Base64_Error
-Base64_decode(const char* encoded, size_t* output_length, unsigned char** output);
+Base64_decode(const char* encoded, size_t* output_length, Ju_Arena* arena, unsigned char** output);
 
 Base64_Error
-Base64Url_encode(const unsigned char* data, size_t input_length, char** output);
+Base64Url_encode(const unsigned char* data, size_t input_length, Ju_Arena* arena, char** output);
 
 Base64_Error
-Base64Url_decode(const char* encoded, size_t* output_length, unsigned char** output);
+Base64Url_decode(const char* encoded, size_t* output_length, Ju_Arena* arena, unsigned char** output);
 
 static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 static const char base64url_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
@@ -0,0 +1,198 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include "server.h"
+#include "http.h"
+#include "jutils.h"
+#include "timer.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Framing state of the first request buffered on a connection
+ */
+typedef enum {
+    WS_REQUEST_INCOMPLETE,
+    WS_REQUEST_COMPLETE,
+    // The states below refuse the request, the connection is closed once it is answered
+    // Headers and body would not fit max_req_size
+    WS_REQUEST_TOO_LARGE,
+    // Conflicting or malformed Content-Length, or Transfer-Encoding along with it
+    WS_REQUEST_BAD_FRAMING,
+    // Body framed by Transfer-Encoding, which requests can't use
+    WS_REQUEST_UNSUPPORTED_FRAMING,
+} Ws_Request_State;
+
+// Defined in worker.h, which needs Ws_Timeout
+typedef struct Ws_Worker Ws_Worker;
+
+/**
+ * What a connection is waiting for, each has its own deadline
+ */
+typedef enum {
+    WS_TIMEOUT_NONE,
+    // Request line and headers, from the first byte awaited to the blank line
+    WS_TIMEOUT_HEADER,
+    // Next bytes of a request body
+    WS_TIMEOUT_BODY,
+    // First byte of the next request of a kept-alive connection
+    WS_TIMEOUT_IDLE,
+    // Peer reading the response
+    WS_TIMEOUT_WRITE,
+    // A deadline passed, the engine is closing the connection
+    WS_TIMEOUT_EXPIRED,
+} Ws_Timeout;
+
+/**
+ * Connection struct containing the state of a client connection
+ * while it is owned by an event loop engine
+ */
+typedef struct Ws_Connection {
+    int fd;
+    Http_Request request;
+    // Requests already answered on this connection
+    int requests;
+    // Input buffer, grown on demand up to max_req_size and NUL terminated
+    char* buffer;
+    size_t capacity;
+    size_t count;
+    // Resumable framing of the first request: bytes already searched for
+    // the header terminator, then headers length (0 until found) and body length
+    size_t scanned;
+    size_t headers_length;
+    size_t content_length;
+    // Route receiving the body of the first request as it arrives, NULL while it is buffered.
+    // Its parts are dropped from the buffer once handed over, the headers stay in front
+    Route* body_route;
+    size_t body_received;
+    // Response of a streamed request, from its head to its end
+    Http_Response body_response;
+    // The streamed request was answered before the end of its body, which is not read
+    bool body_answered;
+    // Response queued through the engine's sink, for engines writing asynchronously
+    StringBuilder output;
+    // Bytes of output already sent
+    size_t output_sent;
+    // Whether the connection stays open once the queued response is sent
+    bool keep_alive;
+    // File sent behind output, -1 if none
+    int file_fd;
+    size_t file_size;
+    size_t file_sent;
+    // Pipe used to splice file bodies to the socket, -1 until needed,
+    // and bytes of the file moved into it
+    int pipe_fds[2];
+    size_t file_piped;
+    // Operations of the response chain still in flight, and whether one of them failed
+    int in_flight;
+    bool send_failed;
+    // Deadline of what the connection waits for, in the wheel of its worker
+    Ws_Timer timer;
+    Ws_Timeout timeout;
+} Ws_Connection;
+
+/**
+ * Allocate a connection for an accepted socket and start timing its request
+ */
+Ws_Connection*
+Ws_connection_create(int fd);
+
+/**
+ * Free a connection and the resources it still owns
+ *  The client socket itself is closed by the engine
+ */
+void
+Ws_connection_free(Ws_Connection* conn);
+
+/**
+ * Make room in the input buffer for wanted more bytes, within max_req_size
+ *  While a body is streamed the buffer keeps its size, one read past the headers.
+ *  Returns the free space, which can be less than wanted and 0 at the limit
+ */
+size_t
+Ws_connection_reserve(Ws_Server* server, Ws_Connection* conn, size_t wanted);
+
+/**
+ * Frame the first buffered request, resuming from the previous call
+ *  A request is its headers plus Content-Length bytes of body,
+ *  len is set to its length once it is complete.
+ *  Requests framed by Transfer-Encoding or by a malformed or conflicting
+ *  Content-Length are refused.
+ *  The body of a streamed route is handed to it as it is framed, len then
+ *  only covers the headers, or the whole buffer if the request was answered early
+ */
+Ws_Request_State
+Ws_connection_parse(Ws_Server* server, Ws_Connection* conn, size_t* len);
+
+/**
+ * Process the first len bytes of the buffer as a request, then shift the
+ *  pipelined bytes following it to the start of the buffer
+ *  Returns true if the connection stays open for another request
+ */
+bool
+Ws_connection_serve(Ws_Server* server, Ws_Connection* conn, size_t len, bool complete);
+
+/**
+ * Answer a request refused while it was framed, the connection must then be closed
+ */
+void
+Ws_connection_reject(Ws_Server* server, Ws_Connection* conn, Ws_Request_State state);
+
+/**
+ * Drop the response queued through the sink once it is sent
+ */
+void
+Ws_connection_reset_output(Ws_Connection* conn);
+
+/**
+ * Send what is sent on conn's socket right away until Ws_set_sink(NULL),
+ *  queuing on the connection what the socket does not take
+ *  The socket must be non-blocking, Ws_connection_flush sends the rest
+ *  once it is writable again. Nothing can be sent behind a queued file
+ */
+void
+Ws_connection_set_sink(Ws_Sink* sink, Ws_Connection* conn);
+
+/**
+ * Send the response queued on conn without waiting for its socket
+ *  Returns 1 once it is all sent, 0 if the socket is full and -1 on error
+ */
+int
+Ws_connection_flush(Ws_Connection* conn);
+
+/**
+ * Whether part of a response is queued on conn
+ */
+bool
+Ws_connection_pending(Ws_Connection* conn);
+
+/**
+ * Wait for conn's socket to be writable, for at most what is left of its deadline
+ *  Returns false once the deadline passed, the socket is then shut down
+ *  for its engine to close the connection
+ */
+bool
+Ws_connection_wait_writable(Ws_Connection* conn);
+
+/**
+ * What a connection reading its next request waits for
+ */
+Ws_Timeout
+Ws_connection_read_timeout(Ws_Connection* conn);
+
+/**
+ * Arm the deadline of what conn waits for in the wheel of its worker
+ *  The header and idle deadlines keep running while they stay the same,
+ *  a client trickling bytes can't push them back. Body and write deadlines
+ *  are pushed back each time they are armed again, on every progress
+ */
+void
+Ws_connection_arm_timeout(Ws_Worker* worker, Ws_Connection* conn, Ws_Timeout timeout);
+
+/**
+ * Monotonic clock in milliseconds, for connection deadlines
+ */
+long
+Ws_now_ms(void);
+
+#endif // CONNECTION_H
@@ -0,0 +1,73 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include "router.h"
+#include <stdbool.h>
+
+/**
+ * Cached response of a file route in one worker
+ */
+typedef struct Ws_File_Cache_Entry {
+    char* buffer;
+    size_t size;
+    struct stat stat;
+    // False while buffer is the route's own render, shared by every worker
+    bool owned;
+} Ws_File_Cache_Entry;
+
+/**
+ * File routes' responses as seen by one worker
+ *  Workers start from the renders made when the routes were added and
+ *  only replace their own entries when a file changes, so a reload
+ *  never touches memory another worker is reading
+ */
+typedef struct Ws_File_Cache {
+    // Indexed like router->files
+    Ws_File_Cache_Entry* entries;
+    size_t count;
+    // Inotify fd to poll for reads, -1 if not watched
+    int watch_fd;
+} Ws_File_Cache;
+
+/**
+ * Add a GET route answering with the content of a file
+ *  The file's headers and body are rendered in memory when the route is added,
+ *  each request is then answered with a single writev.
+ *  The file path is not copied and must outlive the router
+ */
+Route*
+Ws_router_handle_file(Ws_Router* router, char* path, char* filepath, Ws_Handler middleware);
+
+/**
+ * Render the end of a file route's response: its headers, the blank line and the file
+ *  Returns false if the file can't be read
+ */
+bool
+Ws_file_render(const char* filepath, char** buffer, size_t* size, struct stat* stat_buf);
+
+/**
+ * Set up the cache of a worker and watch the files of the router's file routes
+ *  Inotify watches belong to the worker that created them, it polls
+ *  cache->watch_fd for reads and then calls Ws_file_cache_refresh.
+ *  Files changed since their route was rendered are reloaded right away
+ */
+void
+Ws_file_cache_init(Ws_File_Cache* cache, Ws_Router* router);
+
+/**
+ * Reload the files changed since the last call, does not block
+ */
+void
+Ws_file_cache_refresh(Ws_File_Cache* cache, Ws_Router* router);
+
+void
+Ws_file_cache_free(Ws_File_Cache* cache);
+
+/**
+ * Handler of file routes, answers from the current worker's cache
+ *  and falls back to reading the file when it could not be cached
+ */
+int
+Ws_serve_file(Route* route, Http_Request* req, Http_Response* res);
+
+#endif // FILE_CACHE_H
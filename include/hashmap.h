@@ -3,39 +3,56 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 typedef enum {
     HM_OK,
     HM_ERR_INVALID_SIZE,
     HM_ERR_MEMORY_ALLOCATION,
+    HM_ERR_NULL_PARAM,
 } Hm_Error;
 
 #define HM_DEFAULT_SIZE 10
 #define HM_RESIZE_FACTOR 2
+// Entries allowed per 100 slots before the map grows
+#define HM_MAX_LOAD_PERCENT 75
 typedef struct HashMap HashMap;
 typedef struct HashMapEntry HashMapEntry;
 
+/**
+ * Slot of a map, empty when key is NULL
+ */
 struct HashMapEntry {
     char* key;
     void* value;
-    // Next entry in the linked list, 
-    // NULL by default or if last entry in list
-    HashMapEntry* next_entry;
+    // Hash of the key, kept to skip most key compares and to resize without rehashing
+    uint64_t hash;
 };
 
+/**
+ * Case-insensitive string keyed map
+ *  Open addressing with Robin Hood linear probing: an entry never sits
+ *  further from its home slot than the entries it passed, so a lookup
+ *  stops as soon as it meets an entry closer to home than the key would be.
+ *  Lookups do not allocate, keys are copied once when put
+ */
 struct HashMap {
+    // Number of slots, a power of two
     size_t size;
     size_t entries_count;
-    HashMapEntry** entries;
+    HashMapEntry* entries;
 };
 
+/**
+ * Create a map with room for at least size entries
+ */
 HashMap
 hm_create(size_t size);
 
 /**
  * Get value for a specific key
- * Returns 
+ * Returns
  *  - The stored value associated to the key
  *  - NULL if the key is not present, or the map is is NULL allocated
  */
@@ -44,24 +61,25 @@ hm_get(HashMap* map, const char* key);
 
 /**
  * Put the key, value pair in the hashmap
+ *  The map owns its values, a value replaced by another one is freed
  * Returns
- *  - 0 if the key, value pair was successfully added
- *  - -1 if the map is NULL allocated
+ *  - HM_OK if the key, value pair was successfully added
+ *  - an error if the map is NULL allocated or could not grow
  */
 Hm_Error
 hm_put(HashMap* map, const char* key, void* value);
 
 /**
  * Remove a key, value pair from the hashtable
- * Returns 
- *  - The removed value associated to the key
+ * Returns
+ *  - The removed value associated to the key, now owned by the caller
  *  - NULL if the key is not present, or the map is is NULL allocated
  */
 void*
 hm_remove(HashMap* map, const char* key);
 
 /**
- * Free the memory allocated for the map
+ * Free the memory allocated for the map, values included
  */
 void
 hm_free(HashMap* map);
@@ -77,4 +95,12 @@ hm_isempty(HashMap map);
 bool
 hm_exists(HashMap* map, const  char* key);
 
-#endif // HASHMAP_H
\ No newline at end of file
+/**
+ * Get the next entry of a map, in no particular order
+ *  *iterator must be 0 for the first call, returns false once every
+ *  entry was visited. The map must not be modified while iterating
+ */
+bool
+hm_next(HashMap* map, size_t* iterator, const char** key, void** value);
+
+#endif // HASHMAP_H
@@ -1,12 +1,17 @@
 #ifndef HMAC_H
 #define HMAC_H
 
+#include "jutils.h"
 #include <stdint.h>
 #include <stddef.h>
 
+/**
+ * Compute the HMAC of message with key
+ *  The digest is allocated in arena, or on the heap if arena is NULL
+ */
 char*
 hmac(char* message, const char* key, 
     int (*hash)(uint8_t *output, const uint8_t *input, size_t input_len), 
-    size_t blocksize, size_t output_size);
+    size_t blocksize, size_t output_size, Ju_Arena* arena);
 
 #endif // HMAC_H
\ No newline at end of file
@@ -15,6 +15,7 @@ typedef enum {
     HTTP_UNSUPPORTED_VERSION,
     HTTP_ERR_NULL_PARAM,
     HTTP_ERR_MEMORY_ALLOCATION,
+    HTTP_ERR_TOO_MANY_HEADERS,
 } Http_Error;
 
 #define HTTP_VERSION "HTTP/1.1"
@@ -26,8 +27,10 @@ typedef enum {
 #define HTTP_HEADER_FORBIDDEN "HTTP/1.1 403 Forbidden"
 #define HTTP_HEADER_NOT_FOUND "HTTP/1.1 404 Not Found"
 #define HTTP_HEADER_NOT_ALLOWED "HTTP/1.1 405 Not Allowed"
+#define HTTP_HEADER_PAYLOAD_TOO_LARGE "HTTP/1.1 413 Payload Too Large"
 #define HTTP_HEADER_INTERNAL_SERVER_ERROR "HTTP/1.1 500 Internal Server Error"
 #define HTTP_HEADER_NOT_IMPLEMENTED "HTTP/1.1 501 Not Implemented"
+#define HTTP_HEADER_VERSION_NOT_SUPPORTED "HTTP/1.1 505 HTTP Version Not Supported"
 
 #define HTTP_RES_OK \
     (Response) { .status = HTTP_OK, .header = HTTP_HEADER_OK }
@@ -59,11 +62,14 @@ typedef enum {
     HTTP_STATUS_FORBIDDEN = 403,
     HTTP_STATUS_NOT_FOUND = 404,
     HTTP_STATUS_NOT_ALLOWED = 405,
+    HTTP_STATUS_PAYLOAD_TOO_LARGE = 413,
     HTTP_STATUS_INTERNAL_SERVER_ERROR = 500,
-    HTTP_STATUS_NOT_IMPLEMENTED = 501
+    HTTP_STATUS_NOT_IMPLEMENTED = 501,
+    HTTP_STATUS_VERSION_NOT_SUPPORTED = 505
 } Http_Status;
 
 typedef enum {
+    HTTP_VERSION_1_0,
     HTTP_VERSION_1_1,
     HTTP_VERSION_INVALID
 } Http_Version;
@@ -73,7 +79,42 @@ typedef enum {
     HTTP_CONTENTTYPE_UNSUPPORTED,
 } Http_ContentType;
 
-typedef struct HashMap Http_Headers;
+#define HTTP_MAX_HEADERS 64
+
+/**
+ * Slice of a request buffer
+ *  Header values are also NUL terminated in place and can be used as strings
+ */
+typedef struct Http_Slice {
+    const char* ptr;
+    size_t len;
+} Http_Slice;
+
+typedef struct Http_Header {
+    Http_Slice key;
+    Http_Slice value;
+} Http_Header;
+
+#define HTTP_MAX_PARAMS 8
+
+/**
+ * Path parameter captured by the router, the name points into the route
+ *  pattern and the value into the request path, neither is NUL terminated
+ */
+typedef struct Http_Param {
+    Http_Slice name;
+    Http_Slice value;
+} Http_Param;
+
+/**
+ * Headers of a request, in the order they were received
+ */
+typedef struct Http_Headers {
+    Http_Header entries[HTTP_MAX_HEADERS];
+    size_t count;
+} Http_Headers;
+
+#define HTTP_MAX_RESPONSE_HEADERS 16
 
 /**
  * Response struct conataining the informations about a Response
@@ -81,6 +122,12 @@ typedef struct HashMap Http_Headers;
 typedef struct Http_Response {
     Http_Status status;
     char* content;
+    // Connection stays open for another request once the response is sent
+    bool keep_alive;
+    // Headers set with Http_set_header, in the order they were first set.
+    // Content-Length and Connection are added when the response is sent
+    Http_Header headers[HTTP_MAX_RESPONSE_HEADERS];
+    size_t headers_count;
 } Http_Response;
 
 /**
@@ -88,13 +135,22 @@ typedef struct Http_Response {
  */
 typedef struct Http_Request {
     Http_Method method;
+    // Points into the request buffer, NUL terminated in place
     char* path;
     Http_Version version;
     Http_Headers headers;
+    // ":name" and "*name" segments of the matched route
+    Http_Param params[HTTP_MAX_PARAMS];
+    size_t params_count;
     union {
         Jacon_content body;
     };
+    // Memory of everything built while handling the request,
+    // released at once by Http_free_request
+    Ju_Arena arena;
     int client_fd;
+    // State a streamed route keeps between the parts of the body, NULL until it sets it
+    void* context;
     struct timeval start;
     struct timeval end;
     double request_timing;
@@ -106,12 +162,69 @@ typedef struct Http_Request {
 Http_Error
 Http_parse_request(Http_Request* req, const char* reqstr, const size_t header_len);
 
+/**
+ * Parse the request line and the headers, leaving the body alone
+ *  body is set to the first byte after the blank line, NULL if there is none
+ */
+Http_Error
+Http_parse_head(Http_Request* req, const char* reqstr, const size_t header_len, char** body);
+
 /**
  * Parse a request's headers
+ *  Keys and values point into headers_str, nothing is allocated
  */
 Http_Error
 Http_parse_headers(Http_Headers* headers, const char* headers_str, char** headers_last, const size_t header_len);
 
+/**
+ * Get a header value by case-insensitive name, NULL if it was not sent
+ */
+const char*
+Http_get_header(Http_Request* req, const char* key);
+
+/**
+ * Get a path parameter of the matched route by name,
+ *  the returned slice has a NULL ptr if the route has no such parameter
+ */
+Http_Slice
+Http_get_param(Http_Request* req, const char* name);
+
+/**
+ * Set a response header, replacing the value of a header with the same
+ *  case-insensitive name. Neither string is copied, both must live
+ *  until the response is sent
+ */
+Http_Error
+Http_set_header(Http_Response* res, const char* key, const char* value);
+
+/**
+ * Get a response header value by case-insensitive name, NULL if it is not set
+ */
+const char*
+Http_get_response_header(Http_Response* res, const char* key);
+
+/**
+ * Write the headers of a response to buf as "Key: value\r\n" lines
+ *  Returns the number of bytes written, or size + 1 if they don't fit in size bytes
+ */
+size_t
+Http_serialize_headers(Http_Response* res, char* buf, size_t size);
+
+/**
+ * Get the MIME type of a file from its extension,
+ *  application/octet-stream if the extension is unknown
+ */
+const char*
+Http_get_mime_type(const char* path);
+
+/**
+ * Returns true if the client accepts to keep the connection open
+ *  HTTP/1.1 connections are persistent unless "Connection: close" was sent,
+ *  HTTP/1.0 ones are closed after the response
+ */
+bool
+Http_keep_alive(Http_Request* req);
+
 /**
  * Validate a user input path
  */
@@ -0,0 +1,79 @@
+#ifndef HTTP_SCAN_H
+#define HTTP_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP_SCAN_BLOCK_SIZE 64
+
+/**
+ * Delimiters of a block, bit i is set if block[i] is one
+ */
+typedef struct Http_Scan_Masks {
+    // '\r', line ends
+    uint64_t cr;
+    // ':' and ' ', separators inside a line
+    uint64_t sep;
+} Http_Scan_Masks;
+
+/**
+ * Single pass scanner over the structural delimiters of a request head
+ *  The head is classified 64 bytes at a time into bitmasks, with SIMD
+ *  when the CPU supports it, and delimiters are then popped from the masks
+ */
+typedef struct Http_Scanner {
+    const char* buf;
+    size_t len;
+    // Offset of the block held in masks
+    size_t block;
+    // Delimiters of the block not returned yet
+    Http_Scan_Masks masks;
+} Http_Scanner;
+
+/**
+ * Block classifier picked for this CPU by Http_scan_init
+ */
+extern Http_Scan_Masks (*Http_scan_block)(const char* block);
+
+Http_Scan_Masks
+Http_scan_block_scalar(const char* block);
+
+Http_Scan_Masks
+Http_scan_block_sse42(const char* block);
+
+Http_Scan_Masks
+Http_scan_block_avx2(const char* block);
+
+/**
+ * Select the fastest block classifier supported by the CPU
+ *  Done on the first scanner init, returns the name of the selected one
+ */
+const char*
+Http_scan_init(void);
+
+/**
+ * Start scanning len bytes of buf
+ */
+void
+Http_scanner_init(Http_Scanner* scanner, const char* buf, size_t len);
+
+/**
+ * Get the offset of the next delimiter of any kind, len once there are no more
+ */
+size_t
+Http_scanner_next(Http_Scanner* scanner);
+
+/**
+ * Get the offset of the next '\r', skipping the separators before it
+ */
+size_t
+Http_scanner_next_line(Http_Scanner* scanner);
+
+/**
+ * Get the offset of the next ' ' or '\r', skipping colons
+ *  The request line is only split on spaces, its target can hold colons
+ */
+size_t
+Http_scanner_next_space(Http_Scanner* scanner);
+
+#endif // HTTP_SCAN_H
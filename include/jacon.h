@@ -3,7 +3,9 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include "jutils.h"
 
 // Error codes
 typedef enum {
@@ -23,6 +25,7 @@ typedef enum {
     JACON_ERR_KEY_NOT_FOUND,
     JACON_ERR_UNREACHABLE_STATEMENT,
     JACON_ERR_DUPLICATE_NAME,
+    JACON_ERR_HANDLER_FAILED,
 } Jacon_Error;
 
 typedef struct Jacon_StringBuilder Jacon_StringBuilder;
@@ -31,6 +34,8 @@ struct Jacon_StringBuilder {
     char* string;
     size_t count;
     size_t capacity;
+    // Arena the string grows in, NULL for the heap
+    Ju_Arena* arena;
 };
 
 #define JACON_MAP_DEFAULT_SIZE 10
@@ -51,6 +56,9 @@ struct Jacon_HashMap {
     size_t size;
     size_t entries_count;
     Jacon_HashMapEntry** entries;
+    // Arena of the entries, NULL if they are on the heap
+    // Values of an arena map are not owned by the map
+    Ju_Arena* arena;
 };
 
 Jacon_Error
@@ -104,6 +112,8 @@ typedef struct Jacon_HashSet {
     size_t count;
     size_t capacity;
     Jacon_HashSetEntry** entries;
+    // Arena of the entries, NULL if they are on the heap
+    Ju_Arena* arena;
 } Jacon_HashSet;
 
 bool
@@ -118,9 +128,13 @@ Jacon_hs_free(Jacon_HashSet *set);
 Jacon_Error
 Jacon_hs_remove(Jacon_HashSet *set, const char* key);
 
-#define JACON_TOKENIZER_DEFAULT_CAPACITY 256
-#define JACON_TOKENIZER_DEFAULT_RESIZE_FACTOR 2
-#define JACON_NODE_DEFAULT_CHILD_CAPACITY 1
+// Nesting allowed in a parsed input, deeper documents are invalid
+#define JACON_PARSER_MAX_DEPTH 512
+// Members an object can have before its names are checked for duplicates through a set
+#define JACON_PARSER_NAMES_SET_MIN 8
+// Initial capacity of the parser's node stack
+#define JACON_PARSER_DEFAULT_CAPACITY 16
+#define JACON_NODE_DEFAULT_CHILD_CAPACITY 4
 #define JACON_NODE_DEFAULT_RESIZE_FACTOR 2
 
 // Value types
@@ -129,6 +143,9 @@ typedef enum {
     JACON_VALUE_ARRAY,
     JACON_VALUE_STRING,
     JACON_VALUE_INT,
+    // Integers beyond an int
+    JACON_VALUE_INT64,
+    JACON_VALUE_UINT64,
     JACON_VALUE_FLOAT,
     JACON_VALUE_DOUBLE,
     JACON_VALUE_BOOLEAN,
@@ -140,6 +157,8 @@ typedef struct {
         char* string_val;
         union {
             int int_val;
+            int64_t int64_val;
+            uint64_t uint64_val;
             float float_val;
             double double_val;
         };
@@ -148,99 +167,138 @@ typedef struct {
 } Jacon_Value;
 
 struct Jacon_Node {
-    Jacon_Node* parent;
     char* name;
     Jacon_ValueType type;
     Jacon_Value value;
-    Jacon_Node** childs;
+    // Childs of an object or array, laid out contiguously
+    Jacon_Node* childs;
     size_t child_count;
+    // 0 when the childs are a range of a parsed content's nodes, not owned by the node
     size_t child_capacity;
 };
 
+/**
+ * Whether c is one of the whitespace characters allowed between tokens
+ */
+bool
+Jacon_is_whitespace(char c);
+
 typedef struct Jacon_content {
     Jacon_Node* root;
+    // Every node of the parsed tree but the root, the childs of a node are a range of it
+    Jacon_Node* nodes;
+    size_t node_count;
     // Dictionary for efficient value retrieving
     Jacon_HashMap entries;
+    // Input of a lazy content, copied in the arena, and the offsets of its structural characters
+    // Values are only built when looked up, root and entries are left empty
+    char* input;
+    size_t len;
+    uint32_t* structurals;
+    size_t structural_count;
+    // Index of the structural character closing each object or array, at the index of its
+    // opening one, for skipping them when looking up, allocated in the arena
+    uint32_t* ends;
+    // Arena the content is built in
+    // Set it before Jacon_init_content, the content is then released with the arena,
+    // otherwise Jacon_init_content creates one that Jacon_free_content releases
+    Ju_Arena* arena;
+    bool owns_arena;
 } Jacon_content;
 
-// Tokenizer
-typedef enum {
-    JACON_TOKEN_STRING,
-    JACON_TOKEN_INT,
-    JACON_TOKEN_FLOAT,
-    JACON_TOKEN_DOUBLE,
-    JACON_TOKEN_BOOLEAN,
-    JACON_TOKEN_ARRAY_START,
-    JACON_TOKEN_ARRAY_END,
-    JACON_TOKEN_OBJECT_START,
-    JACON_TOKEN_OBJECT_END,
-    JACON_TOKEN_NULL,
-    JACON_TOKEN_COLON,
-    JACON_TOKEN_COMMA,
-} Jacon_TokenType;
-
-typedef struct {
-    Jacon_TokenType type;
-    union {
-        char* string_val;
-        int int_val;
-        float float_val;
-        double double_val;
-        struct {
-            double base;
-            double exponent;
-        } exponential;
-        bool bool_val;
-    };
-} Jacon_Token;
-
-typedef struct {
-    size_t count;
-    size_t capacity;
-    Jacon_Token* tokens;
-} Jacon_Tokenizer;
-
 /**
- * Validate a Json string input
- * Returns:
- * - JACON_OK if valid
- * - According error code otherwise
+ * State of the parser
+ *  The structural characters of the input are indexed first (see jacon_index.h),
+ *  values are then validated and built into nodes going from one to the next.
+ *  The input is parsed from a copy in the arena, strings are terminated in
+ *  place and point into it.
  */
-Jacon_Error
-Jacon_validate_input(Jacon_Tokenizer* tokenizer);
+typedef struct {
+    char* input;
+    size_t len;
+    // Offsets of the structural characters of the input, and the next one to visit
+    const uint32_t* structurals;
+    size_t structural_count;
+    size_t next;
+    // Index of the structural character closing each object or array, by the index of its opening one
+    // Filled by the validation of a lazy content, NULL otherwise
+    uint32_t* ends;
+    // Structural character being parsed, the input's end once there are no more
+    char* cursor;
+    // Arena the copy of the input and the nodes are allocated in
+    Ju_Arena* arena;
+    // Objects and arrays the cursor is in
+    size_t depth;
+    // Parsed values of the open objects and arrays, the childs of the innermost on top
+    Jacon_Node* stack;
+    size_t stack_count;
+    size_t stack_capacity;
+    // Childs of the closed objects and arrays, moved there contiguously from the stack
+    // Allocated once in the arena for the values counted from the structural characters
+    Jacon_Node* nodes;
+    size_t node_count;
+    size_t node_capacity;
+} Jacon_Parser;
 
 /**
  * Append a node to another node's childs
+ *  The child is copied, the node takes over its name and value
  */
 Jacon_Error
 Jacon_append_child(Jacon_Node* node, Jacon_Node* child);
 
 /**
  * Parse a Json string input into a queryable object
+ *  The input is validated and its tree built in a single pass
  */
 Jacon_Error
 Jacon_deserialize(Jacon_content* content, const char* str);
 
+/**
+ * Validate a Json string input, its values are only built when looked up
+ *  The getters by name walk the input from its root to the value of the path,
+ *  skipping the rest, for reading a few values out of a large input.
+ *  Duplicate names are only reported for the members a path goes through.
+ */
+Jacon_Error
+Jacon_deserialize_lazy(Jacon_content* content, const char* str);
+
+/**
+ * Build the value at a path of a content into node, in the content's arena
+ *  Names of the path are separated by dots, the root is found at an empty path.
+ *  Only that value is built from a lazy content, otherwise node is a shallow copy
+ *  of the value's node in the tree.
+ * Returns:
+ * - JACON_OK if found
+ * - JACON_ERR_KEY_NOT_FOUND if nothing is at that path
+ * - JACON_ERR_DUPLICATE_NAME if an object of the path has the name twice
+ */
+Jacon_Error
+Jacon_find(Jacon_content* content, const char* path, Jacon_Node* node);
+
 /**
  * Parse a node into its Json representation
+ *  str is allocated in arena, or on the heap if arena is NULL
  */
 Jacon_Error
-Jacon_serialize(Jacon_Node* node, char** str);
+Jacon_serialize(Jacon_Node* node, Ju_Arena* arena, char** str);
 
 /**
  * Parse a node into its unformatted (compact) Json representation
+ *  str is allocated in arena, or on the heap if arena is NULL
  */
 Jacon_Error
-Jacon_serialize_unformatted(Jacon_Node* node, char** str);
+Jacon_serialize_unformatted(Jacon_Node* node, Ju_Arena* arena, char** str);
 
 /**
- * Duplicate a node
+ * Duplicate a node on the heap, with its childs
  */
 Jacon_Node* 
 Jacon_duplicate_node(const Jacon_Node* node);
 
 /**
- * Free a node's content
+ * Free a node's content, its name, value and childs, built on the heap
+ *  The node itself is not freed
  */
 void
 Jacon_free_node(Jacon_Node* node);
@@ -263,6 +321,16 @@ Jacon_free_content(Jacon_content* content);
     .type = JACON_VALUE_INT , \
     .value.int_val = node_value }
 
+#define Jacon_int64_prop(node_name, node_value) (Jacon_Node){ \
+    .name = strdup(node_name), \
+    .type = JACON_VALUE_INT64 , \
+    .value.int64_val = node_value }
+
+#define Jacon_uint64_prop(node_name, node_value) (Jacon_Node){ \
+    .name = strdup(node_name), \
+    .type = JACON_VALUE_UINT64 , \
+    .value.uint64_val = node_value }
+
 #define Jacon_float_prop(node_name, node_value) (Jacon_Node){ \
     .name = strdup(node_name), \
     .type = JACON_VALUE_FLOAT , \
@@ -301,6 +369,14 @@ Jacon_free_content(Jacon_content* content);
     .type = JACON_VALUE_INT , \
     .value.int_val = node_value }
 
+#define Jacon_int64(node_value) (Jacon_Node){ \
+    .type = JACON_VALUE_INT64 , \
+    .value.int64_val = node_value }
+
+#define Jacon_uint64(node_value) (Jacon_Node){ \
+    .type = JACON_VALUE_UINT64 , \
+    .value.uint64_val = node_value }
+
 #define Jacon_float(node_value) (Jacon_Node){ \
     .type = JACON_VALUE_FLOAT , \
     .value.float_val = node_value }
@@ -328,11 +404,27 @@ Jacon_get_string_by_name(Jacon_content* content, const char* name, char** value)
 Jacon_Error
 Jacon_get_int_by_name(Jacon_content* content, const char* name, int* value);
 
+/**
+ * Get an int64 value, ints are widened
+ */
+Jacon_Error
+Jacon_get_int64_by_name(Jacon_content* content, const char* name, int64_t* value);
+
+/**
+ * Get a uint64 value, non-negative ints and int64s are converted
+ */
+Jacon_Error
+Jacon_get_uint64_by_name(Jacon_content* content, const char* name, uint64_t* value);
+
 Jacon_Error
 Jacon_get_float_by_name(Jacon_content* content, const char* name, float* value);
 
+/**
+ * Get a double value, floats are widened
+ */
 Jacon_Error
 Jacon_get_double_by_name(Jacon_content* content, const char* name, double* value);
+
 Jacon_Error
 Jacon_get_bool_by_name(Jacon_content* content, const char* name, bool* value);
 
@@ -348,6 +440,18 @@ Jacon_get_string(Jacon_content* content, char** value);
 Jacon_Error
 Jacon_get_int(Jacon_content* content, int* value);
 
+/**
+ * Get single int64 value, an int is widened
+ */
+Jacon_Error
+Jacon_get_int64(Jacon_content* content, int64_t* value);
+
+/**
+ * Get single uint64 value, a non-negative int or int64 is converted
+ */
+Jacon_Error
+Jacon_get_uint64(Jacon_content* content, uint64_t* value);
+
 /**
  * Get single float value
  */
@@ -355,7 +459,7 @@ Jacon_Error
 Jacon_get_float(Jacon_content* content, float* value);
 
 /**
- * Get single double value
+ * Get single double value, a float is widened
  */
 Jacon_Error
 Jacon_get_double(Jacon_content* content, double* value);
@@ -381,6 +485,18 @@ Jacon_exist_string_by_name(Jacon_content* content, const char* name);
 Jacon_Error
 Jacon_exist_int_by_name(Jacon_content* content, const char* name);
 
+/**
+ * Verify the existence of a single int64 value
+ */
+Jacon_Error
+Jacon_exist_int64_by_name(Jacon_content* content, const char* name);
+
+/**
+ * Verify the existence of a single uint64 value
+ */
+Jacon_Error
+Jacon_exist_uint64_by_name(Jacon_content* content, const char* name);
+
 /**
  * Verify the existence of a single float value
  */
@@ -423,6 +539,18 @@ Jacon_exist_string(Jacon_content* content);
 Jacon_Error
 Jacon_exist_int(Jacon_content* content);
 
+/**
+ * Verify the existence of a single int64 value
+ */
+Jacon_Error
+Jacon_exist_int64(Jacon_content* content);
+
+/**
+ * Verify the existence of a single uint64 value
+ */
+Jacon_Error
+Jacon_exist_uint64(Jacon_content* content);
+
 /**
  * Verify the existence of a single float value
  */
@@ -0,0 +1,89 @@
+#ifndef JACON_INDEX_H
+#define JACON_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "jacon.h"
+
+#define JACON_INDEX_BLOCK_SIZE 64
+
+/**
+ * Characters of a block, bit i is set if block[i] is one
+ */
+typedef struct Jacon_Index_Masks {
+    uint64_t quote;
+    uint64_t backslash;
+    // '{', '}', '[', ']', ':' and ','
+    uint64_t op;
+    // ' ', '\t', '\n' and '\r'
+    uint64_t whitespace;
+    // Bytes below 0x20, not allowed unescaped in strings
+    uint64_t control;
+} Jacon_Index_Masks;
+
+/**
+ * Offsets of the structural characters of an input, in order
+ *  Structural characters are the operators outside strings, the opening
+ *  and closing quotes of strings, and the first character of numbers and
+ *  literals. The input is classified 64 bytes at a time into bitmasks,
+ *  with SIMD when the CPU supports it, and the offsets popped from them.
+ */
+typedef struct Jacon_Index {
+    uint32_t* offsets;
+    size_t count;
+    size_t capacity;
+} Jacon_Index;
+
+/**
+ * State carried from a block to the next
+ */
+typedef struct Jacon_Indexer {
+    // Bit 0 set if the first character of the block is escaped
+    uint64_t escaped;
+    // All ones if the block starts inside a string
+    uint64_t in_string;
+    // Bit 0 set if the last character of the previous block was part of a number or literal
+    uint64_t scalar;
+    // Unescaped control characters found in strings
+    uint64_t control;
+} Jacon_Indexer;
+
+/**
+ * Block classifier picked for this CPU by Jacon_index_init
+ */
+extern Jacon_Index_Masks (*Jacon_index_block)(const char* block);
+
+Jacon_Index_Masks
+Jacon_index_block_scalar(const char* block);
+
+Jacon_Index_Masks
+Jacon_index_block_sse42(const char* block);
+
+Jacon_Index_Masks
+Jacon_index_block_avx2(const char* block);
+
+/**
+ * Select the fastest block classifier supported by the CPU
+ *  Done on the first index build, returns the name of the selected one
+ */
+const char*
+Jacon_index_init(void);
+
+/**
+ * Index the structural characters of len bytes of input
+ * Returns:
+ * - JACON_OK if indexed
+ * - JACON_ERR_CHAR_NOT_FOUND if a string is not closed
+ * - JACON_ERR_INVALID_ESCAPE_SEQUENCE if a string holds a control character
+ * - JACON_ERR_INVALID_SIZE if the input is too large for 32 bit offsets
+ */
+Jacon_Error
+Jacon_index_build(Jacon_Index* index, const char* input, size_t len);
+
+/**
+ * Free the offsets of an index, it can then be built again
+ */
+void
+Jacon_index_free(Jacon_Index* index);
+
+#endif // JACON_INDEX_H
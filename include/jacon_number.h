@@ -0,0 +1,77 @@
+#ifndef JACON_NUMBER_H
+#define JACON_NUMBER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "jacon.h"
+
+// Digits a mantissa always holds, 10^19 - 1 < 2^64
+#define JACON_NUMBER_MAX_DIGITS 19
+// Powers of ten converted without rounding, powers of five of the table beyond
+#define JACON_NUMBER_EXACT_POWER 22
+#define JACON_NUMBER_SMALLEST_POWER -342
+#define JACON_NUMBER_LARGEST_POWER 308
+// Longest number the Jacon_format functions write, without a NUL terminator
+#define JACON_NUMBER_MAX_LENGTH 32
+
+/**
+ * Number as read by Jacon_scan_number, its value is mantissa * 10^exponent
+ */
+typedef struct Jacon_Number {
+    uint64_t mantissa;
+    int64_t exponent;
+    bool negative;
+    // Neither a fraction nor an exponent
+    bool integer;
+    // More than JACON_NUMBER_MAX_DIGITS significant digits, the mantissa only has the first ones
+    bool truncated;
+} Jacon_Number;
+
+/**
+ * Scan a number, returns the character after it or NULL if it is not one
+ *  Its digits are accumulated into number as they are checked
+ */
+const char*
+Jacon_scan_number(const char* ptr, Jacon_Number* number);
+
+/**
+ * Convert a number scanned by Jacon_scan_number at str
+ *  Integers into an int, or an int64 or uint64 when they need one, the others
+ *  into a float when it fits one exactly, or a double. str is only read again
+ *  by strtod and strtoull for numbers the fast paths cannot round exactly.
+ */
+void
+Jacon_number_value(const char* str, const Jacon_Number* number, Jacon_ValueType* type, Jacon_Value* value);
+
+/**
+ * Round a number to the nearest double
+ *  Returns false if it has too many digits, is subnormal or overflows, strtod gives those
+ */
+bool
+Jacon_number_to_double(const Jacon_Number* number, double* value);
+
+/**
+ * Write the digits of value into out, returns how many were written
+ */
+size_t
+Jacon_format_uint64(char* out, uint64_t value);
+
+size_t
+Jacon_format_int64(char* out, int64_t value);
+
+/**
+ * Write the shortest number reading back as value, returns how many characters were written
+ *  Plain notation from 1e-6 up to 1e21 and an exponent beyond, integral
+ *  values keep a ".0". Infinities and NaN are written as null.
+ */
+size_t
+Jacon_format_double(char* out, double value);
+
+/**
+ * Same as Jacon_format_double with the shortest digits reading back as the float
+ */
+size_t
+Jacon_format_float(char* out, float value);
+
+#endif // JACON_NUMBER_H
@@ -0,0 +1,132 @@
+#ifndef JACON_STREAM_H
+#define JACON_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "jacon.h"
+
+// Longest string, number or literal a stream buffers by default
+#define JACON_STREAM_DEFAULT_MAX_TOKEN (64 * 1024)
+#define JACON_STREAM_DEFAULT_TOKEN_CAPACITY 256
+
+typedef enum {
+    JACON_EVENT_OBJECT_START,
+    JACON_EVENT_OBJECT_END,
+    JACON_EVENT_ARRAY_START,
+    JACON_EVENT_ARRAY_END,
+    // Name of the next member of an object
+    JACON_EVENT_KEY,
+    // String, number, boolean or null
+    JACON_EVENT_VALUE,
+    // A top level value is complete, after its last event
+    JACON_EVENT_DOCUMENT_END,
+} Jacon_EventType;
+
+typedef struct Jacon_Event {
+    Jacon_EventType type;
+    // Type and value of a JACON_EVENT_VALUE, a JACON_EVENT_KEY is a string
+    // Strings keep their escape sequences and only live until the handler returns
+    Jacon_ValueType value_type;
+    Jacon_Value value;
+    // Objects and arrays the event is in
+    size_t depth;
+} Jacon_Event;
+
+/**
+ * Handler of the events of a stream, called as soon as they are parsed
+ *  Returns < 0 to stop the stream, Jacon_stream_feed then returns JACON_ERR_HANDLER_FAILED
+ */
+typedef int (*Jacon_Event_Handler)(void* context, const Jacon_Event* event);
+
+typedef enum {
+    // Before a value, or the closing bracket of an empty array
+    JACON_STREAM_VALUE,
+    // Before the name of a member, or the closing brace of an empty object
+    JACON_STREAM_NAME,
+    JACON_STREAM_COLON,
+    // After a value, before a comma or a closing bracket or brace
+    JACON_STREAM_NEXT,
+    JACON_STREAM_STRING,
+    // Number or literal
+    JACON_STREAM_SCALAR,
+    // After a top level value
+    JACON_STREAM_END,
+} Jacon_Stream_State;
+
+/**
+ * Push parser, fed the input in parts of any size as they are received
+ *  Events are emitted as soon as they are parsed, strings, numbers and literals
+ *  cut between two parts are kept in the token buffer until complete. Memory is
+ *  bounded by max_token and JACON_PARSER_MAX_DEPTH, whatever the input size.
+ *  Names are not checked for duplicates, that would mean keeping them all.
+ *
+ *  With ndjson set, the input is any number of values each on its own line,
+ *  every one ending with a JACON_EVENT_DOCUMENT_END.
+ *
+ *  To parse the body of a request as it arrives, add the route with
+ *  Ws_router_handle_stream, keep a stream in request->context and feed
+ *  it from the body handler, finishing it once the whole body is received.
+ */
+typedef struct Jacon_Stream {
+    Jacon_Event_Handler handler;
+    void* context;
+    bool ndjson;
+    // Longest string, number or literal accepted
+    size_t max_token;
+
+    Jacon_Stream_State state;
+    // Error the stream stopped on, every later call returns it
+    Jacon_Error error;
+    // Objects and arrays the stream is in, a bit set per object by depth
+    size_t depth;
+    uint64_t objects[JACON_PARSER_MAX_DEPTH / 64];
+    // The innermost object or array was just opened and may close right away
+    bool first;
+    // The string being read is the name of a member
+    bool name;
+    // Characters left of the escape sequence being read, 5 right after the backslash
+    // until the character following it is known
+    int escape;
+    // String, number or literal being read, NUL terminated once complete
+    char* token;
+    size_t token_count;
+    size_t token_capacity;
+    // Top level values parsed
+    size_t documents;
+    // Bytes fed so far, the offset of the error once stopped
+    size_t offset;
+} Jacon_Stream;
+
+/**
+ * Set up a stream sending its events to handler
+ *  ndjson and max_token can be changed before the first part is fed
+ */
+void
+Jacon_stream_init(Jacon_Stream* stream, Jacon_Event_Handler handler, void* context);
+
+/**
+ * Parse the next len bytes of input
+ * Returns:
+ * - JACON_OK if every byte was parsed, events up to the last complete token were emitted
+ * - JACON_ERR_INVALID_JSON, JACON_ERR_INVALID_ESCAPE_SEQUENCE if the input is invalid
+ * - JACON_ERR_INVALID_SIZE if a token is longer than max_token
+ * - JACON_ERR_HANDLER_FAILED if the handler stopped the stream
+ */
+Jacon_Error
+Jacon_stream_feed(Jacon_Stream* stream, const char* data, size_t len);
+
+/**
+ * End the input, emitting the events of a number or literal it ends with
+ *  Returns JACON_ERR_INVALID_JSON if a value is left incomplete,
+ *  JACON_ERR_EMPTY_INPUT if there was none and ndjson is not set
+ */
+Jacon_Error
+Jacon_stream_finish(Jacon_Stream* stream);
+
+/**
+ * Free the token buffer of a stream
+ */
+void
+Jacon_stream_free(Jacon_Stream* stream);
+
+#endif // JACON_STREAM_H
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <errno.h>
 
 typedef enum {
@@ -20,12 +21,107 @@ typedef enum {
 #define DEBUG(fmt, ...) LOG("DEBUG", fmt, ##__VA_ARGS__)
 #define CHECK(cond, msg) do { if (!(cond)) { LOG("ERROR", "%s", msg); exit(EXIT_FAILURE); } } while (0)
 
+// Size of the chunks arenas bump allocations from
+#define JU_ARENA_CHUNK_SIZE (16 * 1024)
+// Allocations larger than this get a chunk of their own
+#define JU_ARENA_LARGE_SIZE (JU_ARENA_CHUNK_SIZE / 4)
+// Chunks a pool keeps for reuse, the others are given back to the system
+#define JU_ARENA_POOL_MAX_CHUNKS 64
+
+typedef struct Ju_Arena_Chunk Ju_Arena_Chunk;
+
+struct Ju_Arena_Chunk {
+    Ju_Arena_Chunk* next;
+    size_t capacity;
+    size_t used;
+    _Alignas(max_align_t) unsigned char data[];
+};
+
+/**
+ * Free list of arena chunks, shared by the arenas of a single thread
+ */
+typedef struct Ju_Arena_Pool {
+    Ju_Arena_Chunk* chunks;
+    size_t count;
+} Ju_Arena_Pool;
+
+/**
+ * Bump-pointer allocator whose allocations are all released at once
+ *  Allocations are never freed one by one, Ju_arena_reset gives the
+ *  arena's chunks back to its pool in O(1).
+ *  A zeroed arena is empty and valid, without a pool its chunks are
+ *  taken from and given back to malloc
+ */
+typedef struct Ju_Arena {
+    // Chunk allocations are bumped from, followed by the filled ones
+    Ju_Arena_Chunk* head;
+    Ju_Arena_Chunk* tail;
+    size_t count;
+    // Chunks of the allocations over JU_ARENA_LARGE_SIZE, latest first
+    Ju_Arena_Chunk* large;
+    Ju_Arena_Pool* pool;
+} Ju_Arena;
+
+/**
+ * Allocate size bytes aligned for any type, NULL if out of memory
+ */
+void*
+Ju_arena_alloc(Ju_Arena* arena, size_t size);
+
+/**
+ * Resize an allocation of the arena
+ *  The latest allocation grows in place when its chunk has room,
+ *  the others are copied and their old bytes stay unused until reset
+ */
+void*
+Ju_arena_realloc(Ju_Arena* arena, void* ptr, size_t old_size, size_t size);
+
+/**
+ * Copy len bytes of str into the arena, NUL terminated
+ */
+char*
+Ju_arena_strndup(Ju_Arena* arena, const char* str, size_t len);
+
+/**
+ * Release every allocation of the arena
+ */
+void
+Ju_arena_reset(Ju_Arena* arena);
+
+void
+Ju_arena_pool_free(Ju_Arena_Pool* pool);
+
+/**
+ * Allocation functions for code that can work with or without an arena
+ *  With a NULL arena they are malloc, calloc, realloc, strdup and free,
+ *  otherwise they allocate from the arena and Ju_free does nothing
+ */
+void*
+Ju_alloc(Ju_Arena* arena, size_t size);
+
+void*
+Ju_calloc(Ju_Arena* arena, size_t count, size_t size);
+
+void*
+Ju_realloc(Ju_Arena* arena, void* ptr, size_t old_size, size_t size);
+
+char*
+Ju_strdup(Ju_Arena* arena, const char* str);
+
+char*
+Ju_strndup(Ju_Arena* arena, const char* str, size_t len);
+
+void
+Ju_free(Ju_Arena* arena, void* ptr);
+
 typedef struct StringBuilder StringBuilder;
 
 struct StringBuilder {
     char* string;
     size_t count;
     size_t capacity;
+    // Arena the string grows in, NULL for the heap
+    Ju_Arena* arena;
 };
 
 #define Ju_str_append_null(builder, ...) Ju_str_append(builder, __VA_ARGS__, NULL)
@@ -33,11 +129,20 @@ struct StringBuilder {
 Ju_Error 
 Ju_str_append(StringBuilder* builder, ...);
 
+/**
+ * Append len bytes of str, str does not need to be NUL terminated
+ */
+Ju_Error
+Ju_str_append_len(StringBuilder* builder, const char* str, size_t len);
+
 #define Ju_str_append_fmt_null(builder, ...) Ju_str_append_fmt(builder, __VA_ARGS__, NULL)
 
 Ju_Error 
 Ju_str_append_fmt(StringBuilder* builder, const char* fmt, ...);
 
+/**
+ * Free the builder's string, a no-op for arena builders
+ */
 void
 Ju_builder_free(StringBuilder *builder);
 
@@ -0,0 +1,40 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "server.h"
+#include "worker.h"
+#include "connection.h"
+#include <stdbool.h>
+
+#define WS_REACTOR_MAX_EVENTS 256
+
+/**
+ * Event loop state, one per process
+ */
+typedef struct Ws_Reactor {
+    Ws_Worker* worker;
+    int epoll_fd;
+    int connection_count;
+    // True when accepts were stopped because max_conn was reached
+    bool saturated;
+} Ws_Reactor;
+
+/**
+ * Set O_NONBLOCK on a file descriptor
+ */
+int
+Ws_set_nonblocking(int fd);
+
+/**
+ * Run the epoll engine of a worker until SIGINT
+ *  Every connection of the worker is served by its thread through
+ *  non-blocking sockets and an edge-triggered epoll instance.
+ *  What the socket does not take of a response is queued on its connection
+ *  and sent on EPOLLOUT, the next request is only read once it is.
+ *  Connection deadlines live in the worker's timer wheel, epoll_wait
+ *  sleeps until the nearest one and the expired connections are closed
+ */
+int
+Ws_reactor_run(Ws_Server* server, Ws_Worker* worker);
+
+#endif // REACTOR_H
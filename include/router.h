@@ -0,0 +1,125 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include "http.h"
+#include <stddef.h>
+#include <sys/stat.h>
+
+typedef struct Route Route;
+typedef int (*Ws_Handler)(Route* route, Http_Request* request, Http_Response* res);
+/**
+ * Handler of the body of a streamed route, called with each part of it as it is received
+ *  data is not NUL terminated. Called with NULL data and len 0 if the request
+ *  is aborted before the end of its body, nothing can be sent then.
+ *  Returns < 0 to fail the request with a 500
+ */
+typedef int (*Ws_Body_Handler)(Route* route, Http_Request* request, const char* data, size_t len);
+
+/**
+ * Route struct conataining the informations about a Route
+ */
+struct Route {
+    Http_Method method;
+    char* path;
+    Ws_Handler handler;
+    Ws_Handler middleware; // Maybe make it so we can have multiple midllewares
+    // Receives the body as it arrives, NULL to buffer and parse it with the request
+    Ws_Body_Handler body_handler;
+    // File served by a file route, NULL for other routes
+    char* file_path;
+    // Index of a file route in router->files and in the workers' file caches
+    size_t file_index;
+    // End of a file route's response rendered when the route was added:
+    // the headers that only depend on the file, the blank line and the body.
+    // Never changed afterwards, workers reload changed files in their own cache
+    char *file_buffer;
+    size_t file_size;
+    // File the response was rendered from
+    struct stat file_stat;
+};
+
+typedef struct Ws_Route_Node Ws_Route_Node;
+
+/**
+ * Node of a router's radix tree
+ *  Static edges are compressed: a node's prefix is the longest run of path
+ *  shared by every route under it, and siblings never start with the same byte
+ */
+struct Ws_Route_Node {
+    // Label of the edge leading to this node, points into a route pattern
+    const char* prefix;
+    size_t prefix_len;
+    Ws_Route_Node** children;
+    size_t children_count;
+    // ":name" child, matching one path segment
+    Ws_Route_Node* param;
+    // "*name" child, matching the rest of the path
+    Ws_Route_Node* wildcard;
+    // Name of a param or wildcard node, points into a route pattern
+    Http_Slice name;
+    // Route ending at this node, NULL if none
+    Route* route;
+};
+
+/**
+ * Router struct containg the informations about a router
+ *  One radix tree per method, a zeroed router has no routes
+ */
+typedef struct Ws_Router {
+    Ws_Route_Node* trees[HTTP_METHOD_INVALID];
+    size_t routes_count;
+    // Routes with a body handler, requests are only peeked at when there are some
+    size_t streams_count;
+    // File routes, whose cached responses are kept in sync with the disk
+    Route** files;
+    size_t files_count;
+} Ws_Router;
+
+/**
+ * Add a route to handle to a router
+ *  The path can hold ":name" segments and end with a "*name" one,
+ *  it is not copied and must outlive the router
+ *  Returns the added route
+ */
+Route*
+Ws_router_handle(
+    Ws_Router* router,
+    char* path,
+    Http_Method method,
+    Ws_Handler handler,
+    Ws_Handler middleware
+);
+
+/**
+ * Add a route receiving its body as a stream
+ *  The middleware runs as soon as the headers are received, body_handler
+ *  is then called with each part of the body and handler once all of it
+ *  was, to send the response. The body is neither buffered nor parsed and
+ *  max_req_size only limits the headers, the handler keeps what it needs
+ *  of the body in request->context
+ */
+Route*
+Ws_router_handle_stream(
+    Ws_Router* router,
+    char* path,
+    Http_Method method,
+    Ws_Body_Handler body_handler,
+    Ws_Handler handler,
+    Ws_Handler middleware
+);
+
+/**
+ * Find the route of a request and capture its path parameters in req->params
+ *  Static segments win over ":name" ones, which win over "*name" ones,
+ *  so the most specific route is picked. NULL if no route matches
+ */
+Route*
+Ws_router_match(Ws_Router* router, Http_Request* req);
+
+/**
+ * Free a router's trees and routes
+ */
+void
+Ws_router_free(Ws_Router* router);
+
+#endif // ROUTER_H
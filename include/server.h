@@ -3,10 +3,17 @@
 
 #include "jutils.h"
 #include "http.h"
+#include "router.h"
 #include <stddef.h>
-#include <semaphore.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
-#define SEM_NAME "/sem_connection_count"
+#define WS_CACHE_LINE_SIZE 64
+
+// Set by the SIGINT handler, every engine loop stops when it is set
+extern volatile sig_atomic_t stop_server;
 #define WS_BUFFER_MAX_LENGHT 2048
 
 typedef struct Ws_parse_result {
@@ -23,9 +30,65 @@ typedef struct Ws_parse_result {
 #define WS_CONFIG_DEFAULT_PORT 3000
 #define WS_CONFIG_DEFAULT_BACKLOG 10
 #define WS_CONFIG_DEFAULT_MAX_CONNECTIONS 10
+#define WS_CONFIG_DEFAULT_ENGINE WS_ENGINE_FORK
+#define WS_CONFIG_DEFAULT_MAX_REQUEST_SIZE 1048576
+#define WS_CONFIG_DEFAULT_KEEPALIVE_TIMEOUT 5
+#define WS_CONFIG_DEFAULT_KEEPALIVE_REQUESTS 100
+#define WS_CONFIG_DEFAULT_HEADER_TIMEOUT 10
+#define WS_CONFIG_DEFAULT_BODY_TIMEOUT 30
+#define WS_CONFIG_DEFAULT_WRITE_TIMEOUT 10
+// Highest CPU number cpu_list accepts, plus one, as in a cpu_set_t
+#define WS_MAX_CPUS 1024
 
 typedef struct HashMap Ws_Config;
 
+/**
+ * I/O engine used to serve connections
+ *  fork: one child process per accepted connection
+ *  epoll: single process, non-blocking edge-triggered event loop
+ *  io_uring: completion based loop, batched submissions, streamed
+ *  responses are sent from their handler as they are written
+ */
+typedef enum {
+    WS_ENGINE_FORK,
+    WS_ENGINE_EPOLL,
+    WS_ENGINE_URING,
+    WS_ENGINE_INVALID
+} Ws_Engine;
+
+/**
+ * Returns the enum equivalent of an engine name
+ *  WS_ENGINE_INVALID if invalid
+ */
+Ws_Engine
+Ws_parse_engine(const char* str);
+
+/**
+ * How the workers of the epoll and io_uring engines are run
+ *  process: pre-forked processes, a crashed worker is respawned
+ *  thread: one thread per worker in a single process, meant to be
+ *  pinned one per core with cpu_list
+ */
+typedef enum {
+    WS_WORKER_PROCESS,
+    WS_WORKER_THREAD,
+    WS_WORKER_INVALID
+} Ws_Worker_Mode;
+
+/**
+ * Returns the enum equivalent of a worker mode name
+ *  WS_WORKER_INVALID if invalid
+ */
+Ws_Worker_Mode
+Ws_parse_worker_mode(const char* str);
+
+/**
+ * Parse a list of CPUs such as "0-3,8,10-11" into a malloc'ed array
+ *  Returns the number of CPUs, 0 if str is not a valid list
+ */
+int
+Ws_parse_cpu_list(const char* str, int** cpus);
+
 /**
  * Load server configuration from file at given path
  * if path is NULL, loads config from 'WS_CONFIG_FILE_NAME' file
@@ -41,49 +104,52 @@ Ws_load_config_from_file(const char* path);
 void*
 Ws_config_get_value(Ws_Config* config, const char* key);
 
-typedef struct Route Route;
-typedef int (*Ws_Handler)(Route* route, Http_Request* request, Http_Response* res);
-
-/**
- * Route struct conataining the informations about a Route
- */
-struct Route {
-    Http_Method method;
-    char* path;
-    Ws_Handler handler;
-    Ws_Handler middleware; // Maybe make it so we can have multiple midllewares
-    char *file_buffer;
-    size_t file_size;
-};
-
 /**
- * Router struct containg the informations about a router
+ * Get value for an optional property key
+ *  Returns default_value if the key was not found in the config file
  */
-typedef struct Ws_Router {
-    HashMap routes;
-} Ws_Router;
+char*
+Ws_config_get_value_or(Ws_Config* config, const char* key, char* default_value);
 
 /**
- * Add a route to handle to a router
+ * Open connections counter, shared between processes through an anonymous
+ *  mapping and alone on its cache line so that updating it never
+ *  contends with unrelated data
  */
-void 
-Ws_router_handle(
-    Ws_Router* router, 
-    char* path, 
-    Http_Method method, 
-    Ws_Handler handler,
-    Ws_Handler middleware
-);
+typedef struct Ws_Connection_Counter {
+    _Alignas(WS_CACHE_LINE_SIZE) atomic_int count;
+} Ws_Connection_Counter;
 
 /**
  * Server struct containing all informations about the server
+ *  Shared read-only by the workers once set up, the state they
+ *  change while serving lives in their own Ws_Worker
  */
 typedef struct Ws_Server {
-    int* connection_count;
-    int connection_count_shm_id;
-    sem_t* connection_count_sem;
+    Ws_Connection_Counter* connections;
     int sock_fd;
     int max_connections;
+    // Bytes of headers and body a request can use
+    int max_request_size;
+    Ws_Engine engine;
+    // Long-lived workers, unused by the fork engine
+    Ws_Worker_Mode worker_mode;
+    int worker_count;
+    int* worker_fds;
+    pid_t* worker_pids;
+    // CPUs the workers are pinned to in turn, none if cpu_count is 0
+    int* cpu_list;
+    int cpu_count;
+    // Idle seconds before a persistent connection is closed, 0 disables keep-alive
+    int keepalive_timeout;
+    // Requests served on a connection before it is closed
+    int keepalive_requests;
+    // Seconds to receive the headers of a request, 0 for no limit
+    int header_timeout;
+    // Seconds a request body can go without a byte received, 0 for no limit
+    int body_timeout;
+    // Seconds a response can go without the client reading any of it, 0 for no limit
+    int write_timeout;
     bool requests_logging;
     Ws_Config config;
     Ws_Router router;
@@ -107,12 +173,184 @@ Ws_server_enable_logging(Ws_Server* server);
 bool
 Ws_server_disable_logging(Ws_Server* server);
 
+/**
+ * Add a signal handler
+ */
+int
+Ws_handle_signal(int signum, void (*handler)(int signum));
+
 /**
  * Run the server
  */
 int
 Ws_run_server(Ws_Server* server);
 
+/**
+ * Take a connection slot, returns false if max_connections are already open
+ */
+bool
+Ws_acquire_connection(Ws_Server* server);
+
+/**
+ * Give back a connection slot taken by Ws_acquire_connection
+ */
+void
+Ws_release_connection(Ws_Server* server);
+
+/**
+ * Parse, route and answer a request read in buf, then log it
+ *  Shared by every engine, the connection is left open
+ *  Returns true if the connection can be kept alive for another request,
+ *  which is never the case when keep_alive is false
+ */
+bool
+Ws_process_request(Ws_Server* server, Http_Request* req, char* buf, size_t len, bool keep_alive);
+
+/**
+ * Answer a request whose handler failed with a 500 and close the connection after it
+ */
+int
+Ws_send_handler_error(Route* route, Http_Request* req, Http_Response* res);
+
+/**
+ * Find the route of a request whose head is the first headers_len bytes of buf,
+ *  if that route receives its body as a stream
+ *  The head is left as it is. NULL if the body must be buffered
+ */
+Route*
+Ws_body_route(Ws_Server* server, char* buf, size_t headers_len);
+
+/**
+ * Start a request whose body is streamed to its route: parse its head in place,
+ *  then run the middleware
+ *  Returns false if the request was already answered, its body must not be read
+ */
+bool
+Ws_body_begin(Ws_Server* server, Http_Request* req, Route* route, char* buf, size_t headers_len, Http_Response* res, bool keep_alive);
+
+/**
+ * Answer a streamed request once its body was received, unless it already was, then log it
+ *  Returns true if the connection can be kept alive for another request
+ */
+bool
+Ws_body_end(Ws_Server* server, Http_Request* req, Route* route, Http_Response* res, bool answered);
+
+/**
+ * Drop a streamed request whose body will not be received, telling its route
+ */
+void
+Ws_body_abort(Route* route, Http_Request* req);
+
+/**
+ * Time the start of a request
+ */
+void
+Ws_start_request(Http_Request* request);
+
+/**
+ * Output sink of an engine writing responses asynchronously
+ *  While a sink is set, bytes and files sent on sink->fd are handed
+ *  to the sink instead of being written to the socket
+ */
+typedef struct Ws_Sink {
+    int fd;
+    void* ctx;
+    // Takes count buffers of iov, flags are those of sendmsg
+    int (*write)(void* ctx, struct iovec* iov, int count, int flags);
+    // Takes ownership of filefd
+    int (*send_file)(void* ctx, int filefd, size_t size);
+    // Wait until at most limit bytes are left to send
+    int (*drain)(void* ctx, size_t limit);
+} Ws_Sink;
+
+/**
+ * Set the sink of the request being processed, NULL to write directly again
+ *  The sink belongs to the calling thread
+ */
+void
+Ws_set_sink(Ws_Sink* sink);
+
+/**
+ * Write len bytes of buf to fd
+ *  Waits for the socket to be writable if it would block, for at most write_timeout
+ */
+int
+Ws_write_all(int fd, const char* buf, size_t len);
+
+/**
+ * Skip the first len bytes of count buffers of iov
+ *  Returns how many buffers are left, iov is moved to the first of them
+ */
+int
+Ws_iov_advance(struct iovec** iov, int count, size_t len);
+
+#define WS_WRITER_MAX_BUFFERS 8
+#define WS_WRITER_HEAD_SIZE 2048
+
+/**
+ * Response assembled as a list of buffers, flushed with a single writev
+ *  so that a small response leaves in one TCP segment.
+ *  The status line and headers are serialized in place into head,
+ *  body buffers are not copied and must live until the response is sent
+ */
+typedef struct Ws_Response_Writer {
+    char head[WS_WRITER_HEAD_SIZE];
+    size_t head_count;
+    // Set when the headers did not fit in head, the response is not sent
+    bool overflow;
+    // The first buffer is the head
+    struct iovec buffers[WS_WRITER_MAX_BUFFERS];
+    int count;
+} Ws_Response_Writer;
+
+void
+Ws_writer_init(Ws_Response_Writer* writer);
+
+/**
+ * Serialize the status line, the Connection header and the headers of a response
+ */
+void
+Ws_writer_head(Ws_Response_Writer* writer, Http_Response* res);
+
+/**
+ * Serialize Content-Length, left out of 204 responses, and the blank line ending the head
+ */
+void
+Ws_writer_end_head(Ws_Response_Writer* writer, Http_Response* res, size_t content_length);
+
+/**
+ * Append a body buffer
+ */
+void
+Ws_writer_append(Ws_Response_Writer* writer, const char* buf, size_t len);
+
+/**
+ * Send the assembled response
+ */
+int
+Ws_writer_flush(int fd, Ws_Response_Writer* writer);
+
+/**
+ * Send the assembled response followed by size bytes of filefd
+ *  The buffers are sent with MSG_MORE so the kernel holds them back
+ *  and merges them with the first segment of the file, filefd is closed once sent
+ */
+int
+Ws_writer_flush_with_file(int fd, Ws_Response_Writer* writer, int filefd, size_t size);
+
+/**
+ * Send size bytes of filefd to fd, filefd is closed once sent
+ *  Waits for the socket to be writable if it would block
+ */
+int
+Ws_send_file(int fd, int filefd, size_t size);
+
+/**
+ * Get the Connection header line of a response
+ */
+const char*
+Ws_connection_header(Http_Response* res);
+
 /**
  * Send an http response
  */
@@ -125,4 +363,57 @@ Ws_send_response_with_file(int fd, Http_Response* res, const char* filepath);
 int
 Ws_send_response_with_content(int fd, Http_Response* res, Http_ContentType type);
 
+// Body bytes a stream buffers before sending them as one chunk
+#define WS_STREAM_CHUNK_SIZE (16 * 1024)
+// Bytes of a stream an engine's sink keeps for a slow peer before the handler waits for it
+#define WS_STREAM_MAX_QUEUED (64 * WS_STREAM_CHUNK_SIZE)
+
+/**
+ * Response whose body is sent while it is produced, its length unknown
+ *  HTTP/1.1 bodies are sent with Transfer-Encoding: chunked, HTTP/1.0
+ *  ones are sent as they are and delimited by closing the connection.
+ *  Writes are gathered in a buffer and sent as one chunk every
+ *  WS_STREAM_CHUNK_SIZE bytes, larger writes are sent without being copied.
+ *  Through an engine's sink, the chunks the socket does not take are queued
+ *  and the handler waits once WS_STREAM_MAX_QUEUED bytes are left to send.
+ */
+typedef struct Ws_Response_Stream {
+    int fd;
+    // Body written since the last chunk was sent
+    StringBuilder buffer;
+    // Offset in buffer of the size line of the open chunk
+    size_t chunk_start;
+    bool chunk_open;
+    bool chunked;
+    // Sink of the engine the body goes through, NULL when it is written directly
+    Ws_Sink* sink;
+    // A send failed, the rest of the body is dropped
+    bool failed;
+} Ws_Response_Stream;
+
+/**
+ * Start a streamed response with the status and headers of res
+ *  The head is sent along with the first chunk
+ */
+int
+Ws_stream_begin(Ws_Response_Stream* stream, Http_Request* req, Http_Response* res, Http_ContentType type);
+
+/**
+ * Append len bytes to the body
+ */
+int
+Ws_stream_write(Ws_Response_Stream* stream, const char* buf, size_t len);
+
+/**
+ * Send what was written so far without waiting for a full chunk
+ */
+int
+Ws_stream_flush(Ws_Response_Stream* stream);
+
+/**
+ * Send the end of the body, the stream must be ended for the connection to be reused
+ */
+int
+Ws_stream_end(Ws_Response_Stream* stream);
+
 #endif // WEBSERVER_H
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Resolution of the wheel, deadlines never fire early but up to a tick late
+#define WS_TIMER_TICK_MS 10
+#define WS_TIMER_SLOT_BITS 6
+#define WS_TIMER_SLOTS (1 << WS_TIMER_SLOT_BITS)
+#define WS_TIMER_SLOT_MASK (WS_TIMER_SLOTS - 1)
+// Each level spans WS_TIMER_SLOTS slots of the level below, 4 levels of 10ms ticks cover 46 hours
+#define WS_TIMER_LEVELS 4
+
+typedef struct Ws_Timer Ws_Timer;
+
+/**
+ * Deadline embedded in the object it times out, owned by one wheel while armed
+ */
+struct Ws_Timer {
+    Ws_Timer* prev;
+    Ws_Timer* next;
+    // Tick the timer fires at
+    unsigned long expires;
+    // Object the timer belongs to, left for the caller
+    void* data;
+    unsigned char level;
+    unsigned char slot;
+    bool armed;
+};
+
+/**
+ * Hierarchical timing wheel
+ *  Level 0 has one slot per tick, a slot of level n spans the whole of
+ *  level n - 1. A timer is linked in the slot its deadline falls in,
+ *  arming and cancelling it only relink it. The slots of a higher level
+ *  are moved down a level each time the level below wraps around,
+ *  a timer is moved at most WS_TIMER_LEVELS - 1 times before firing
+ */
+typedef struct Ws_Timer_Wheel {
+    Ws_Timer* slots[WS_TIMER_LEVELS][WS_TIMER_SLOTS];
+    // Bit i set when slot i of the level is not empty
+    uint64_t pending[WS_TIMER_LEVELS];
+    // Next tick to fire, every one before it was handled
+    unsigned long tick;
+    // Armed timers
+    unsigned long count;
+} Ws_Timer_Wheel;
+
+/**
+ * Set up an empty wheel, times are Ws_now_ms milliseconds
+ */
+void
+Ws_timer_wheel_init(Ws_Timer_Wheel* wheel, long now);
+
+/**
+ * Arm a timer to fire timeout milliseconds after now, rearming it if it is armed
+ */
+void
+Ws_timer_arm(Ws_Timer_Wheel* wheel, Ws_Timer* timer, long now, long timeout);
+
+/**
+ * Disarm a timer, nothing is done if it is not armed
+ */
+void
+Ws_timer_cancel(Ws_Timer_Wheel* wheel, Ws_Timer* timer);
+
+/**
+ * Disarm and return the next timer due at now, NULL once none is left
+ *  Timers can be armed and cancelled between calls
+ */
+Ws_Timer*
+Ws_timer_expire(Ws_Timer_Wheel* wheel, long now);
+
+/**
+ * Disarm and return any armed timer, NULL once the wheel is empty
+ */
+Ws_Timer*
+Ws_timer_pop(Ws_Timer_Wheel* wheel);
+
+/**
+ * Milliseconds from now until timer is due, -1 if it is not armed
+ */
+int
+Ws_timer_left(Ws_Timer* timer, long now);
+
+/**
+ * Milliseconds from now until Ws_timer_expire must be called again, -1 if no timer is armed
+ */
+int
+Ws_timer_wheel_timeout(Ws_Timer_Wheel* wheel, long now);
+
+#endif // TIMER_H
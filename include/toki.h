@@ -48,17 +48,19 @@ Toki_add_claim(Toki_Token* token, Jacon_Node* claim);
 
 /**
  * Signs a token and sets signed_token to the signed token value
+ *  Every allocation is made in arena, or on the heap if arena is NULL
  */
 Toki_Error
-Toki_sign_token(Toki_Token* token, const char* key, char** signed_token);
+Toki_sign_token(Toki_Token* token, const char* key, Ju_Arena* arena, char** signed_token);
 
 /**
  * Verify a token
  * Based on token signature and optionnal registered claims
  *  (iss, sub, aud, exp, nbf, iat, jti)
+ *  Working memory is taken from arena, or from the heap if arena is NULL
  */
 bool
-Toki_verify_token(const char* token);
+Toki_verify_token(const char* token, Ju_Arena* arena);
 
 /**
  * Free allocated ressources
@@ -0,0 +1,86 @@
+#ifndef URING_H
+#define URING_H
+
+#include "server.h"
+#include "worker.h"
+#include "connection.h"
+#include <stdbool.h>
+#include <linux/io_uring.h>
+
+#define WS_URING_ENTRIES 1024
+#define WS_URING_BUFFER_GROUP 0
+#define WS_URING_BUFFER_COUNT 256
+#define WS_URING_PIPE_SIZE (1 << 20)
+
+// Operation tags stored in the low bits of a completion's user_data,
+// the high bits hold the connection pointer (NULL for listener level ops)
+typedef enum {
+    WS_URING_OP_ACCEPT,
+    WS_URING_OP_RECV,
+    // Links of a response chain, by what they move
+    WS_URING_OP_SEND,
+    WS_URING_OP_SPLICE_IN,
+    WS_URING_OP_SPLICE_OUT,
+    WS_URING_OP_CLOSE,
+    WS_URING_OP_WATCH,
+    WS_URING_OP_IGNORE,
+} Ws_Uring_Op;
+
+#define WS_URING_OP_MASK 0x7
+
+/**
+ * io_uring instance and engine state, one per process
+ */
+typedef struct Ws_Uring {
+    Ws_Worker* worker;
+    int ring_fd;
+    // Submission queue, shared with the kernel
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;
+    struct io_uring_sqe* sqes;
+    // Completion queue, shared with the kernel
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    // Mappings to release on exit
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    size_t sqes_size;
+    // Receive buffers provided to the kernel, picked by recv on completion
+    char* buffers;
+    // Completions of other connections reaped while a handler waited for its stream
+    // to drain, dispatched by the event loop once it runs again
+    struct io_uring_cqe* deferred;
+    size_t deferred_count;
+    size_t deferred_capacity;
+    int connection_count;
+    // Timeout of the current wait for completions
+    struct __kernel_timespec wait_timeout;
+    // io_uring_enter takes the wait timeout itself, kernel 5.11+
+    bool ext_arg;
+    bool accept_armed;
+    bool accept_cancelling;
+    bool accept_multishot;
+} Ws_Uring;
+
+/**
+ * Run the io_uring engine of a worker until SIGINT
+ *  Accepts are multishot, receives use kernel provided buffers and
+ *  responses are submitted as linked send and splice chains, every
+ *  operation of a loop iteration goes to the kernel in one io_uring_enter.
+ *  A handler streaming its response waits on the ring for the sends of
+ *  its connection, the completions of the others are kept for the loop.
+ *  That call also sleeps until the nearest deadline of the worker's timer
+ *  wheel, an expired connection is shut down to fail its pending operation
+ */
+int
+Ws_uring_run(Ws_Server* server, Ws_Worker* worker);
+
+#endif // URING_H
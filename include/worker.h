@@ -0,0 +1,86 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include "server.h"
+#include "file_cache.h"
+#include "connection.h"
+#include "timer.h"
+#include <pthread.h>
+
+/**
+ * Counters of a worker, only ever written by the worker itself
+ */
+typedef struct Ws_Worker_Stats {
+    unsigned long connections;
+    unsigned long requests;
+} Ws_Worker_Stats;
+
+/**
+ * State of one event loop, owned by the process or thread running it
+ *  The server, its config and its router are shared read-only between
+ *  workers, everything a worker changes while serving lives here.
+ *  A worker allocates it once pinned to its CPU, so that it is placed
+ *  on the NUMA node of that CPU by the first touch of its pages
+ */
+typedef struct Ws_Worker {
+    int index;
+    // CPU the worker is pinned to, -1 if it is not
+    int cpu;
+    // Own listener, the kernel balances connections between SO_REUSEPORT listeners
+    int sock_fd;
+    // Share of max_conn
+    int max_connections;
+    Ws_File_Cache files;
+    // Chunks of the request arenas, reused from one request to the next
+    Ju_Arena_Pool arenas;
+    // Deadlines of the worker's connections
+    Ws_Timer_Wheel timers;
+    // Milliseconds allowed for each Ws_Timeout, 0 for no limit
+    long timeouts[WS_TIMEOUT_EXPIRED];
+    Ws_Worker_Stats stats;
+} Ws_Worker;
+
+// Period at which stopping worker threads are signaled until they exit
+#define WS_WORKER_WAKE_INTERVAL_MS 100
+
+/**
+ * Worker thread of the thread mode
+ */
+typedef struct Ws_Worker_Thread {
+    pthread_t id;
+    Ws_Server* server;
+    int index;
+    // Exit status of the worker's event loop
+    int ret;
+} Ws_Worker_Thread;
+
+/**
+ * Get the worker running in the calling thread, NULL outside of a worker
+ */
+Ws_Worker*
+Ws_current_worker(void);
+
+/**
+ * Set up a worker serving from sock_fd and make it the calling thread's worker
+ */
+void
+Ws_worker_init(Ws_Worker* worker, Ws_Server* server, int index, int sock_fd);
+
+void
+Ws_worker_free(Ws_Worker* worker);
+
+/**
+ * Start server->worker_count long-lived workers and supervise them
+ *  Each worker runs the event loop on its own SO_REUSEPORT listener,
+ *  the kernel balances accepts between them without any shared lock.
+ *  With cpu_list set, worker i is pinned to the i-th CPU of the list.
+ *  process mode: pre-forked workers, one killed by a signal is respawned
+ *  on the same listener.
+ *  thread mode: one thread per worker in this process, nothing is shared
+ *  on the request path but the read-only server.
+ *  Returns once SIGINT was received and every worker has exited.
+ */
+int
+Ws_workers_run(Ws_Server* server);
+
+#endif // WORKER_H
@@ -1,23 +1,21 @@
 #include "server.h"
+#include "file_cache.h"
 #include "toki.h"
 
 #include "jwt_middleware.h"
 #include "root_routes.h"
 #include "login_routes.h"
-#include "dashboard_routes.h"
 
 Ws_Router
 setup_router()
 {
     Ws_Router router = {0};
-    // Initialize the map to store routes with a size of 10
-    router.routes = hm_create(HM_DEFAULT_SIZE);
 
-    Ws_router_handle(&router, "/", HTTP_METHOD_GET, route_get_root, NULL);
-    Ws_router_handle(&router, "/index.js", HTTP_METHOD_GET, route_get_root_js, NULL);
-    Ws_router_handle(&router, "/index.css", HTTP_METHOD_GET, route_get_root_css, NULL);
+    Ws_router_handle_file(&router, "/", "static/index.html", NULL);
+    Ws_router_handle_file(&router, "/index.js", "static/index.js", NULL);
+    Ws_router_handle_file(&router, "/index.css", "static/index.css", NULL);
     Ws_router_handle(&router, "/favicon.ico", HTTP_METHOD_GET, route_get_favicon, NULL);
-    Ws_router_handle(&router, "/dashboard", HTTP_METHOD_GET, route_get_dashboard, authorize);
+    Ws_router_handle_file(&router, "/dashboard", "static/dashboard.html", authorize);
     Ws_router_handle(&router, "/api/login", HTTP_METHOD_POST, route_post_login, NULL);
     return router;
 }
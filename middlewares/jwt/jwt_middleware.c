@@ -5,14 +5,14 @@ int
 authorize(Route* route, Http_Request* req, Http_Response* res)
 {
     (void)route;
-    char* auth_header = hm_get(&req->headers, "authorization");
+    const char* auth_header = Http_get_header(req, "Authorization");
     if (auth_header == NULL) {
         res->status = HTTP_STATUS_UNAUTHORIZED;
         Ws_send_response(req->client_fd, res);
         return 1;
     }
 
-    if (!Toki_verify_token(auth_header)) {
+    if (!Toki_verify_token(auth_header, &req->arena)) {
         res->status = HTTP_STATUS_UNAUTHORIZED;
         Ws_send_response(req->client_fd, res);
         return 1;
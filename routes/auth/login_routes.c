@@ -12,20 +12,22 @@ validate_credentials(const char* login, const char* password)
 }
 
 char*
-create_token(const char* login)
+create_token(const char* login, Ju_Arena* arena)
 {
     int ret;
     Toki_Token token = {0};
     Toki_token_init(&token, TOKI_ALG_HS256);
     Jacon_Node iss = Jacon_string_prop("iss", "Conrad");
-    Jacon_Node exp = Jacon_int_prop("exp", (int)time(NULL));
+    Jacon_Node exp = Jacon_int64_prop("exp", (int64_t)time(NULL));
     Jacon_Node login_node = Jacon_string_prop("login", login);
     Toki_add_claim(&token, &iss);
     Toki_add_claim(&token, &exp);
     Toki_add_claim(&token, &login_node);
 
     char* signed_token;
-    ret = Toki_sign_token(&token, getenv("toki_secret"), &signed_token);
+    ret = Toki_sign_token(&token, getenv("toki_secret"), arena, &signed_token);
+    // The claims were handed over to the token
+    Toki_free_token(&token);
     if (ret == TOKI_ERR_UNSUPPORTED_ALGORITHM) {
         return NULL;
     }
@@ -36,18 +38,21 @@ int
 route_post_login(Route* route, Http_Request* req, Http_Response* res)
 {
     (void)route;
-    char* login;
+    char* login = NULL;
     Jacon_get_string_by_name(&req->body, "login", &login);
-    char* password;
+    char* password = NULL;
     Jacon_get_string_by_name(&req->body, "password", &password);
 
     if (!validate_credentials(login, password)) {
+        free(login);
+        free(password);
         res->status = HTTP_STATUS_BAD_REQUEST;
         return Ws_send_response(req->client_fd, res);
     }
     // Do additional credentials work if needed (of course)
 
-    char* signed_token = create_token(login);
+    // Token and response live until the request is freed
+    char* signed_token = create_token(login, &req->arena);
     if (signed_token == NULL) return -1;
 
     Jacon_Node json_object = Jacon_object();
@@ -55,11 +60,13 @@ route_post_login(Route* route, Http_Request* req, Http_Response* res)
     Jacon_append_child(&json_object, &token_node);
 
     res->status = HTTP_STATUS_OK;
-    Jacon_serialize(&json_object, &res->content);
+    // The token must not be kept by the browser or a proxy
+    Http_set_header(res, "Cache-Control", "no-store");
+    Jacon_serialize(&json_object, &req->arena, &res->content);
+    Jacon_free_node(&json_object);
 
     free(login);
     free(password);
-    free(signed_token);
 
     return Ws_send_response_with_content(req->client_fd, res, HTTP_CONTENTTYPE_JSON);
 }
\ No newline at end of file
@@ -85,10 +85,10 @@ Base64Url_is_valid(const char* str)
 }
 
 Base64_Error
-Base64_encode(const unsigned char* data, size_t input_length, char** output)
+Base64_encode(const unsigned char* data, size_t input_length, Ju_Arena* arena, char** output)
 {
     size_t output_length = 4 * ((input_length + 2) / 3);
-    *output = (char*)malloc(output_length + 1);
+    *output = (char*)Ju_alloc(arena, output_length + 1);
     if (*output == NULL) {
         return BASE64_ERR_MEMORY_ALLOCATION;
     }
@@ -115,7 +115,7 @@ Base64_encode(const unsigned char* data, size_t input_length, char** output)
 }
 
 Base64_Error
-Base64_decode(const char* encoded, size_t* output_length, unsigned char** output)
+Base64_decode(const char* encoded, size_t* output_length, Ju_Arena* arena, unsigned char** output)
 {
     size_t input_length = strlen(encoded);
 
@@ -130,7 +130,7 @@ Base64_decode(const char* encoded, size_t* output_length, unsigned char** output
 
     *output_length = (input_length / 4) * 3 - padding;
 
-    *output = (unsigned char*)malloc(*output_length);
+    *output = (unsigned char*)Ju_alloc(arena, *output_length);
     if (*output == NULL) {
         return BASE64_ERR_MEMORY_ALLOCATION;
     }
@@ -151,10 +151,10 @@ Base64_decode(const char* encoded, size_t* output_length, unsigned char** output
 }
 
 Base64_Error
-Base64Url_encode(const unsigned char* data, size_t input_length, char** output)
+Base64Url_encode(const unsigned char* data, size_t input_length, Ju_Arena* arena, char** output)
 {
     size_t output_length = 4 * ((input_length + 2) / 3);
-    *output = (char*)malloc(output_length + 1);
+    *output = (char*)Ju_alloc(arena, output_length + 1);
     if (*output == NULL) {
         return -1;
     }
@@ -181,10 +181,10 @@ Base64Url_encode(const unsigned char* data, size_t input_length, char** output)
 }
 
 Base64_Error
-Base64Url_decode(const char* encoded, size_t* output_length, unsigned char** output)
+Base64Url_decode(const char* encoded, size_t* output_length, Ju_Arena* arena, unsigned char** output)
 {
     size_t input_length = strlen(encoded);
-    *output = (unsigned char*)malloc(input_length * 3 / 4);
+    *output = (unsigned char*)Ju_alloc(arena, input_length * 3 / 4);
     if (*output == NULL) {
         return -1;
     }
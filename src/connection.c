@@ -0,0 +1,452 @@
+#define _GNU_SOURCE
+#include "connection.h"
+#include "worker.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+
+Ws_Connection*
+Ws_connection_create(int fd)
+{
+    Ws_Connection* conn = malloc(sizeof(Ws_Connection));
+    if (conn == NULL) return NULL;
+    conn->buffer = malloc(WS_BUFFER_MAX_LENGHT + 1);
+    if (conn->buffer == NULL) {
+        free(conn);
+        return NULL;
+    }
+    conn->capacity = WS_BUFFER_MAX_LENGHT;
+    conn->fd = fd;
+    conn->requests = 0;
+    conn->count = 0;
+    conn->scanned = 0;
+    conn->headers_length = 0;
+    conn->content_length = 0;
+    conn->body_route = NULL;
+    conn->body_received = 0;
+    conn->body_answered = false;
+    conn->request = (Http_Request){
+        .client_fd = fd,
+        .method = HTTP_METHOD_INVALID
+    };
+    conn->output = (StringBuilder){0};
+    conn->output_sent = 0;
+    conn->keep_alive = false;
+    conn->file_fd = -1;
+    conn->file_size = 0;
+    conn->file_sent = 0;
+    conn->pipe_fds[0] = -1;
+    conn->pipe_fds[1] = -1;
+    conn->file_piped = 0;
+    conn->in_flight = 0;
+    conn->send_failed = false;
+    conn->timer = (Ws_Timer){ .data = conn };
+    conn->timeout = WS_TIMEOUT_NONE;
+    Ws_start_request(&conn->request);
+    return conn;
+}
+
+void
+Ws_connection_free(Ws_Connection* conn)
+{
+    if (conn->body_route != NULL) Ws_body_abort(conn->body_route, &conn->request);
+    if (conn->file_fd != -1) close(conn->file_fd);
+    if (conn->pipe_fds[0] != -1) close(conn->pipe_fds[0]);
+    if (conn->pipe_fds[1] != -1) close(conn->pipe_fds[1]);
+    Ju_builder_free(&conn->output);
+    free(conn->buffer);
+    free(conn);
+}
+
+/**
+ * Grow the input buffer to hold wanted more bytes, doubling it up to limit
+ */
+void
+Ws_connection_grow(Ws_Connection* conn, size_t wanted, size_t limit)
+{
+    if (conn->capacity - conn->count >= wanted || conn->capacity >= limit) return;
+    size_t capacity = conn->capacity * 2;
+    while (capacity < conn->count + wanted) capacity *= 2;
+    if (capacity > limit) capacity = limit;
+    char* buffer = realloc(conn->buffer, capacity + 1);
+    if (buffer != NULL) {
+        conn->buffer = buffer;
+        conn->capacity = capacity;
+    }
+}
+
+size_t
+Ws_connection_reserve(Ws_Server* server, Ws_Connection* conn, size_t wanted)
+{
+    size_t limit = (size_t)server->max_request_size;
+    // The head of a streamed request is parsed in place, the buffer can't move until its end
+    if (conn->body_route != NULL) limit = conn->capacity;
+    Ws_connection_grow(conn, wanted, limit);
+    size_t end = conn->capacity < limit ? conn->capacity : limit;
+    return end > conn->count ? end - conn->count : 0;
+}
+
+/**
+ * Start streaming the body of the request whose headers were just framed, if its route takes it
+ */
+void
+Ws_connection_stream_begin(Ws_Server* server, Ws_Connection* conn)
+{
+    if (server->router.streams_count == 0 || conn->content_length == SIZE_MAX) return;
+    Route* route = Ws_body_route(server, conn->buffer, conn->headers_length);
+    if (route == NULL) return;
+    // Room for the head and one read of the body, the buffer then stays as it is
+    size_t end = conn->headers_length + WS_BUFFER_MAX_LENGHT;
+    if (conn->count < end) Ws_connection_grow(conn, end - conn->count, end);
+    if (conn->capacity < end) return;
+
+    conn->body_route = route;
+    conn->body_received = 0;
+    bool keep_alive = server->keepalive_timeout > 0 && conn->requests + 1 < server->keepalive_requests;
+    conn->body_answered = !Ws_body_begin(server, &conn->request, route, conn->buffer,
+        conn->headers_length, &conn->body_response, keep_alive);
+}
+
+/**
+ * Hand the body bytes buffered after the headers to the route streaming them
+ */
+Ws_Request_State
+Ws_connection_stream(Ws_Connection* conn, size_t* len)
+{
+    size_t available = conn->count - conn->headers_length;
+    size_t left = conn->content_length - conn->body_received;
+    size_t part = available < left ? available : left;
+    if (part > 0 && !conn->body_answered) {
+        Route* route = conn->body_route;
+        char* body = conn->buffer + conn->headers_length;
+        if (route->body_handler(route, &conn->request, body, part) < 0) {
+            Ws_send_handler_error(route, &conn->request, &conn->body_response);
+            conn->body_answered = true;
+        } else {
+            // Only the next request can follow the part, keep it behind the headers
+            conn->body_received += part;
+            conn->count -= part;
+            memmove(body, body + part, conn->count - conn->headers_length);
+            conn->buffer[conn->count] = '\0';
+        }
+    }
+
+    if (conn->body_answered) {
+        // Whatever was read after the headers is dropped with the connection
+        *len = conn->count;
+        return WS_REQUEST_COMPLETE;
+    }
+    if (conn->body_received < conn->content_length) return WS_REQUEST_INCOMPLETE;
+    *len = conn->headers_length;
+    return WS_REQUEST_COMPLETE;
+}
+
+/**
+ * Read the body length out of the headers ending at headers_end
+ *  Transfer-Encoding is refused, as are Content-Length values that are not
+ *  plain digits or that differ from one another.
+ *  Returns WS_REQUEST_INCOMPLETE if the request is acceptable, the refusing state otherwise
+ */
+Ws_Request_State
+Ws_connection_frame(char* buffer, char* headers_end, size_t* content_length)
+{
+    bool has_length = false;
+    bool has_encoding = false;
+    *content_length = 0;
+    for (char* line = strstr(buffer, "\r\n"); line != NULL && line < headers_end; line = strstr(line, "\r\n")) {
+        line += 2;
+        bool encoding = strncasecmp(line, "Transfer-Encoding", 17) == 0;
+        char* value;
+        if (encoding) value = line + 17;
+        else if (strncasecmp(line, "Content-Length", 14) == 0) value = line + 14;
+        else continue;
+        // Whitespace before the colon would hide the header from the parser, not from a proxy
+        if (*value == ' ' || *value == '\t') return WS_REQUEST_BAD_FRAMING;
+        if (*value++ != ':') continue;
+        if (encoding) {
+            has_encoding = true;
+            continue;
+        }
+
+        while (*value == ' ' || *value == '\t') value++;
+        if (*value < '0' || *value > '9') return WS_REQUEST_BAD_FRAMING;
+        char* end;
+        unsigned long long length = strtoull(value, &end, 10);
+        while (*end == ' ' || *end == '\t') end++;
+        if (*end != '\r') return WS_REQUEST_BAD_FRAMING;
+        // An overflow can only be refused, as too large
+        size_t parsed = length >= SIZE_MAX ? SIZE_MAX : length;
+        if (has_length && parsed != *content_length) return WS_REQUEST_BAD_FRAMING;
+        has_length = true;
+        *content_length = parsed;
+    }
+    if (has_encoding) return has_length ? WS_REQUEST_BAD_FRAMING : WS_REQUEST_UNSUPPORTED_FRAMING;
+    return WS_REQUEST_INCOMPLETE;
+}
+
+Ws_Request_State
+Ws_connection_parse(Ws_Server* server, Ws_Connection* conn, size_t* len)
+{
+    size_t limit = (size_t)server->max_request_size;
+    conn->buffer[conn->count] = '\0';
+
+    if (conn->headers_length == 0) {
+        // The terminator may straddle the bytes already searched
+        size_t start = conn->scanned > 3 ? conn->scanned - 3 : 0;
+        char* headers_end = memmem(conn->buffer + start, conn->count - start, "\r\n\r\n", 4);
+        if (headers_end == NULL) {
+            conn->scanned = conn->count;
+            return conn->count >= limit ? WS_REQUEST_TOO_LARGE : WS_REQUEST_INCOMPLETE;
+        }
+        // Left unset on a refusal, framing the same headers again refuses them again
+        Ws_Request_State state = Ws_connection_frame(conn->buffer, headers_end, &conn->content_length);
+        if (state != WS_REQUEST_INCOMPLETE) return state;
+        conn->headers_length = headers_end + 4 - conn->buffer;
+        Ws_connection_stream_begin(server, conn);
+    }
+
+    if (conn->body_route != NULL) return Ws_connection_stream(conn, len);
+    if (conn->content_length > limit - conn->headers_length) return WS_REQUEST_TOO_LARGE;
+    if (conn->headers_length + conn->content_length > conn->count) return WS_REQUEST_INCOMPLETE;
+    *len = conn->headers_length + conn->content_length;
+    return WS_REQUEST_COMPLETE;
+}
+
+bool
+Ws_connection_serve(Ws_Server* server, Ws_Connection* conn, size_t len, bool complete)
+{
+    bool keep_alive = complete
+        && server->keepalive_timeout > 0
+        && conn->requests + 1 < server->keepalive_requests;
+
+    if (conn->body_route != NULL) {
+        Route* route = conn->body_route;
+        conn->body_route = NULL;
+        if (conn->body_answered || conn->body_received == conn->content_length) {
+            if (!complete) conn->body_response.keep_alive = false;
+            keep_alive = Ws_body_end(server, &conn->request, route, &conn->body_response, conn->body_answered);
+        } else {
+            // The peer closed its side before the end of the body
+            Ws_body_abort(route, &conn->request);
+            keep_alive = false;
+        }
+        conn->body_received = 0;
+        conn->body_answered = false;
+    } else {
+        // The parser reads up to a NUL, borrow the first byte of the next request
+        char next = conn->buffer[len];
+        conn->buffer[len] = '\0';
+        keep_alive = Ws_process_request(server, &conn->request, conn->buffer, len, keep_alive);
+        conn->buffer[len] = next;
+    }
+    conn->requests++;
+
+    conn->count -= len;
+    memmove(conn->buffer, conn->buffer + len, conn->count);
+    conn->scanned = 0;
+    conn->headers_length = 0;
+    conn->content_length = 0;
+    // Give back the memory of a large request once it is served
+    if (conn->count < WS_BUFFER_MAX_LENGHT && conn->capacity > WS_BUFFER_MAX_LENGHT) {
+        char* buffer = realloc(conn->buffer, WS_BUFFER_MAX_LENGHT + 1);
+        if (buffer != NULL) {
+            conn->buffer = buffer;
+            conn->capacity = WS_BUFFER_MAX_LENGHT;
+        }
+    }
+    conn->request = (Http_Request){
+        .client_fd = conn->fd,
+        .method = HTTP_METHOD_INVALID
+    };
+    Ws_start_request(&conn->request);
+    // The next request gets deadlines of its own
+    conn->timeout = WS_TIMEOUT_NONE;
+    return keep_alive;
+}
+
+void
+Ws_connection_reject(Ws_Server* server, Ws_Connection* conn, Ws_Request_State state)
+{
+    Http_Response res = {
+        .status = HTTP_STATUS_BAD_REQUEST,
+        .keep_alive = false
+    };
+    if (state == WS_REQUEST_TOO_LARGE) {
+        res.status = HTTP_STATUS_PAYLOAD_TOO_LARGE;
+        if (server->requests_logging) WARN("Request over max_req_size refused");
+    } else if (state == WS_REQUEST_UNSUPPORTED_FRAMING) {
+        res.status = HTTP_STATUS_NOT_IMPLEMENTED;
+        if (server->requests_logging) WARN("Request with a Transfer-Encoding refused");
+    } else {
+        if (server->requests_logging) WARN("Request with a malformed Content-Length refused");
+    }
+    Ws_send_response(conn->fd, &res);
+    conn->keep_alive = false;
+}
+
+void
+Ws_connection_reset_output(Ws_Connection* conn)
+{
+    conn->output.count = 0;
+    conn->output_sent = 0;
+    if (conn->file_fd != -1) close(conn->file_fd);
+    conn->file_fd = -1;
+    conn->file_size = 0;
+    conn->file_sent = 0;
+    conn->file_piped = 0;
+}
+
+int
+Ws_connection_sink_write(void* ctx, struct iovec* iov, int count, int flags)
+{
+    Ws_Connection* conn = ctx;
+    if (conn->file_fd != -1) return -1;
+    while (count > 0 && !Ws_connection_pending(conn)) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = count };
+        ssize_t ret = sendmsg(conn->fd, &msg, flags);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        count = Ws_iov_advance(&iov, count, ret);
+    }
+    if (count == 0) return 0;
+
+    // Drop what was sent of the queue before it grows
+    if (conn->output_sent > 0) {
+        conn->output.count -= conn->output_sent;
+        memmove(conn->output.string, conn->output.string + conn->output_sent, conn->output.count);
+        conn->output_sent = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (Ju_str_append_len(&conn->output, iov[i].iov_base, iov[i].iov_len) != JU_OK) return -1;
+    }
+    return 0;
+}
+
+int
+Ws_connection_sink_send_file(void* ctx, int filefd, size_t size)
+{
+    Ws_Connection* conn = ctx;
+    if (conn->file_fd != -1) {
+        close(filefd);
+        return -1;
+    }
+    conn->file_fd = filefd;
+    conn->file_size = size;
+    conn->file_sent = 0;
+    return Ws_connection_flush(conn) < 0 ? -1 : 0;
+}
+
+/**
+ * Send the queued output until at most limit bytes are left, waiting for the socket
+ */
+int
+Ws_connection_sink_drain(void* ctx, size_t limit)
+{
+    Ws_Connection* conn = ctx;
+    while (conn->output.count - conn->output_sent > limit) {
+        int ret = Ws_connection_flush(conn);
+        if (ret != 0) return ret < 0 ? -1 : 0;
+        // Sent bytes push the deadline back
+        Ws_connection_arm_timeout(Ws_current_worker(), conn, WS_TIMEOUT_WRITE);
+        if (!Ws_connection_wait_writable(conn)) return -1;
+    }
+    return 0;
+}
+
+void
+Ws_connection_set_sink(Ws_Sink* sink, Ws_Connection* conn)
+{
+    *sink = (Ws_Sink){
+        .fd = conn->fd,
+        .ctx = conn,
+        .write = Ws_connection_sink_write,
+        .send_file = Ws_connection_sink_send_file,
+        .drain = Ws_connection_sink_drain
+    };
+    Ws_set_sink(sink);
+}
+
+int
+Ws_connection_flush(Ws_Connection* conn)
+{
+    while (conn->output_sent < conn->output.count) {
+        // Held back to leave in the same segment as the start of the file
+        int flags = conn->file_fd != -1 ? MSG_MORE : 0;
+        ssize_t ret = send(conn->fd, conn->output.string + conn->output_sent,
+            conn->output.count - conn->output_sent, flags);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        conn->output_sent += ret;
+    }
+    while (conn->file_fd != -1 && conn->file_sent < conn->file_size) {
+        off_t offset = conn->file_sent;
+        ssize_t ret = sendfile(conn->fd, conn->file_fd, &offset, conn->file_size - conn->file_sent);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        // The file was truncated, its length was already sent
+        if (ret == 0) return -1;
+        conn->file_sent = offset;
+    }
+    Ws_connection_reset_output(conn);
+    return 1;
+}
+
+bool
+Ws_connection_pending(Ws_Connection* conn)
+{
+    return conn->output_sent < conn->output.count || conn->file_fd != -1;
+}
+
+bool
+Ws_connection_wait_writable(Ws_Connection* conn)
+{
+    struct pollfd pfd = { .fd = conn->fd, .events = POLLOUT };
+    while (!stop_server) {
+        int timeout = Ws_timer_left(&conn->timer, Ws_now_ms());
+        if (timeout == 0) break;
+        int ret = poll(&pfd, 1, timeout);
+        if (ret > 0) return true;
+        if (ret < 0 && errno != EINTR) return false;
+    }
+    shutdown(conn->fd, SHUT_RDWR);
+    return false;
+}
+
+Ws_Timeout
+Ws_connection_read_timeout(Ws_Connection* conn)
+{
+    if (conn->count == 0 && conn->requests > 0) return WS_TIMEOUT_IDLE;
+    return conn->headers_length == 0 ? WS_TIMEOUT_HEADER : WS_TIMEOUT_BODY;
+}
+
+void
+Ws_connection_arm_timeout(Ws_Worker* worker, Ws_Connection* conn, Ws_Timeout timeout)
+{
+    if (timeout == conn->timeout && (timeout == WS_TIMEOUT_HEADER || timeout == WS_TIMEOUT_IDLE)) return;
+    conn->timeout = timeout;
+    long ms = timeout < WS_TIMEOUT_EXPIRED ? worker->timeouts[timeout] : 0;
+    if (ms > 0) Ws_timer_arm(&worker->timers, &conn->timer, Ws_now_ms(), ms);
+    else Ws_timer_cancel(&worker->timers, &conn->timer);
+}
+
+long
+Ws_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
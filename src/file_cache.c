@@ -0,0 +1,211 @@
+#include "file_cache.h"
+#include "server.h"
+#include "worker.h"
+#include "jutils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+// Changes of a watched directory that can alter a cached file
+#define WS_FILE_CACHE_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB)
+
+Route*
+Ws_router_handle_file(Ws_Router* router, char* path, char* filepath, Ws_Handler middleware)
+{
+    CHECK(filepath != NULL, "add file handler null file path");
+    Route* route = Ws_router_handle(router, path, HTTP_METHOD_GET, Ws_serve_file, middleware);
+    route->file_path = filepath;
+    route->file_index = router->files_count;
+
+    Route** files = realloc(router->files, (router->files_count + 1) * sizeof(Route*));
+    CHECK(files != NULL, "file routes alloc error");
+    router->files = files;
+    router->files[router->files_count++] = route;
+
+    if (!Ws_file_render(filepath, &route->file_buffer, &route->file_size, &route->file_stat)) {
+        WARN("Could not cache '%s': %s", filepath, strerror(errno));
+    }
+    return route;
+}
+
+bool
+Ws_file_render(const char* filepath, char** buffer, size_t* size, struct stat* stat_buf)
+{
+    int fd = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    if (fstat(fd, stat_buf) != 0 || !S_ISREG(stat_buf->st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    // Headers that only depend on the file, the status line and the
+    // headers of the response are serialized in front of them per request
+    char head[256];
+    int head_size = snprintf(head, sizeof(head), "Content-Type: %s\r\nContent-Length: %ld\r\n\r\n",
+        Http_get_mime_type(filepath), stat_buf->st_size);
+    size_t total = head_size + stat_buf->st_size;
+    char* rendered = malloc(total);
+    if (rendered == NULL) {
+        close(fd);
+        return false;
+    }
+    memcpy(rendered, head, head_size);
+
+    size_t offset = head_size;
+    while (offset < total) {
+        ssize_t ret = read(fd, rendered + offset, total - offset);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) break;
+        offset += ret;
+    }
+    close(fd);
+    if (offset != total) {
+        // Truncated while being read, the next change event reloads it
+        free(rendered);
+        return false;
+    }
+
+    *buffer = rendered;
+    *size = total;
+    return true;
+}
+
+/**
+ * Drop the response cached in entry, freeing it if the worker owns it
+ */
+void
+Ws_file_cache_drop(Ws_File_Cache_Entry* entry)
+{
+    if (entry->owned) free(entry->buffer);
+    entry->buffer = NULL;
+    entry->size = 0;
+    entry->owned = false;
+}
+
+/**
+ * Reload an entry if its file is not the one it was rendered from anymore
+ */
+void
+Ws_file_cache_revalidate(Ws_File_Cache_Entry* entry, Route* route)
+{
+    struct stat stat_buf;
+    if (stat(route->file_path, &stat_buf) != 0) {
+        if (entry->buffer == NULL) return;
+        INFO("Cached file '%s' removed", route->file_path);
+        Ws_file_cache_drop(entry);
+        return;
+    }
+    if (entry->buffer != NULL
+        && stat_buf.st_ino == entry->stat.st_ino
+        && stat_buf.st_size == entry->stat.st_size
+        && stat_buf.st_mtim.tv_sec == entry->stat.st_mtim.tv_sec
+        && stat_buf.st_mtim.tv_nsec == entry->stat.st_mtim.tv_nsec) {
+        return;
+    }
+
+    Ws_file_cache_drop(entry);
+    if (Ws_file_render(route->file_path, &entry->buffer, &entry->size, &entry->stat)) {
+        entry->owned = true;
+        INFO("Cached file '%s' reloaded", route->file_path);
+    }
+}
+
+void
+Ws_file_cache_init(Ws_File_Cache* cache, Ws_Router* router)
+{
+    cache->watch_fd = -1;
+    cache->count = router->files_count;
+    cache->entries = NULL;
+    if (cache->count == 0) return;
+
+    cache->entries = calloc(cache->count, sizeof(Ws_File_Cache_Entry));
+    CHECK(cache->entries != NULL, "Ws_file_cache_init : entries alloc error");
+    for (size_t i = 0; i < cache->count; i++) {
+        Route* route = router->files[i];
+        cache->entries[i] = (Ws_File_Cache_Entry){
+            .buffer = route->file_buffer,
+            .size = route->file_size,
+            .stat = route->file_stat,
+            .owned = false
+        };
+    }
+
+    cache->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cache->watch_fd < 0) {
+        WARN("File cache not watched, inotify error: %s", strerror(errno));
+        return;
+    }
+    for (size_t i = 0; i < cache->count; i++) {
+        // Watch the directory, editors often replace a file instead of writing it
+        char dir[PATH_MAX];
+        const char* path = router->files[i]->file_path;
+        const char* slash = strrchr(path, '/');
+        if (slash == NULL) {
+            strcpy(dir, ".");
+        } else {
+            size_t len = slash - path;
+            if (len == 0) len = 1;
+            if (len >= sizeof(dir)) continue;
+            memcpy(dir, path, len);
+            dir[len] = '\0';
+        }
+        // Watching a directory twice returns the same watch
+        if (inotify_add_watch(cache->watch_fd, dir, WS_FILE_CACHE_EVENTS) < 0) {
+            WARN("Could not watch '%s': %s", dir, strerror(errno));
+        }
+    }
+
+    // Catch up with the changes made since the routes were rendered
+    for (size_t i = 0; i < cache->count; i++) Ws_file_cache_revalidate(&cache->entries[i], router->files[i]);
+}
+
+void
+Ws_file_cache_refresh(Ws_File_Cache* cache, Ws_Router* router)
+{
+    if (cache->watch_fd < 0) return;
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t ret;
+    // Events only tell that something changed, the files are compared once for the whole batch
+    while ((ret = read(cache->watch_fd, events, sizeof(events))) > 0 || (ret < 0 && errno == EINTR)) {
+        if (ret > 0) changed = true;
+    }
+    if (!changed) return;
+    for (size_t i = 0; i < cache->count; i++) Ws_file_cache_revalidate(&cache->entries[i], router->files[i]);
+}
+
+void
+Ws_file_cache_free(Ws_File_Cache* cache)
+{
+    for (size_t i = 0; i < cache->count; i++) Ws_file_cache_drop(&cache->entries[i]);
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->count = 0;
+    if (cache->watch_fd >= 0) close(cache->watch_fd);
+    cache->watch_fd = -1;
+}
+
+int
+Ws_serve_file(Route* route, Http_Request* req, Http_Response* res)
+{
+    res->status = HTTP_STATUS_OK;
+    const char* buffer = route->file_buffer;
+    size_t size = route->file_size;
+    Ws_Worker* worker = Ws_current_worker();
+    if (worker != NULL && route->file_index < worker->files.count) {
+        buffer = worker->files.entries[route->file_index].buffer;
+        size = worker->files.entries[route->file_index].size;
+    }
+    if (buffer == NULL) return Ws_send_response_with_file(req->client_fd, res, route->file_path);
+
+    Ws_Response_Writer writer;
+    Ws_writer_init(&writer);
+    Ws_writer_head(&writer, res);
+    Ws_writer_append(&writer, buffer, size);
+    return Ws_writer_flush(req->client_fd, &writer);
+}
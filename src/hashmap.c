@@ -1,42 +1,77 @@
 #include "hashmap.h"
-#include "jutils.h"
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
+
+#define HM_FNV_OFFSET 0xcbf29ce484222325ULL
+#define HM_FNV_PRIME 0x100000001b3ULL
 
 /**
- * djb2 algorithm
- * source: https://www.cse.yorku.ca/~oz/hash.html
+ * FNV-1a hash of key with ASCII letters folded to lowercase,
+ *  keys differing only by case hash the same
  */
-unsigned long
-hash(unsigned char *str)
+uint64_t
+hm_hash(const char* key)
 {
-    unsigned long hash = 5381;
-    int c;
-
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-
+    uint64_t hash = HM_FNV_OFFSET;
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        unsigned char c = *p;
+        if (c >= 'A' && c <= 'Z') c |= 0x20;
+        hash = (hash ^ c) * HM_FNV_PRIME;
+    }
     return hash;
 }
 
 /**
- * Create a new entry with the key, value pair
+ * Distance of the entry at index from the slot its hash points to
  */
-HashMapEntry*
-create_entry(const char* key, void* value)
+size_t
+hm_probe_distance(HashMap* map, size_t index)
 {
-    HashMapEntry* entry = calloc(1, sizeof(HashMapEntry));
-    if (entry == NULL) {
-        return NULL;
+    return (index - (map->entries[index].hash & (map->size - 1))) & (map->size - 1);
+}
+
+/**
+ * Place an entry whose key is not in the map yet, the map must have an empty slot
+ */
+void
+hm_insert_entry(HashMap* map, HashMapEntry entry)
+{
+    size_t mask = map->size - 1;
+    size_t index = entry.hash & mask;
+    size_t distance = 0;
+    while (map->entries[index].key != NULL) {
+        // Take the slot from an entry closer to its home, and carry that one on
+        size_t existing = hm_probe_distance(map, index);
+        if (existing < distance) {
+            HashMapEntry tmp = map->entries[index];
+            map->entries[index] = entry;
+            entry = tmp;
+            distance = existing;
+        }
+        index = (index + 1) & mask;
+        distance++;
     }
-    entry->key = strdup(key);
-    if (entry->key == NULL) {
-        free(entry);
-        return NULL;
+    map->entries[index] = entry;
+    map->entries_count++;
+}
+
+/**
+ * Get the slot index of key, -1 if it is not in the map
+ */
+long
+hm_find(HashMap* map, const char* key)
+{
+    if (map == NULL || key == NULL || map->size == 0) return -1;
+    uint64_t hash = hm_hash(key);
+    size_t mask = map->size - 1;
+    size_t index = hash & mask;
+    for (size_t distance = 0;; distance++) {
+        HashMapEntry* entry = &map->entries[index];
+        if (entry->key == NULL || hm_probe_distance(map, index) < distance) return -1;
+        if (entry->hash == hash && strcasecmp(entry->key, key) == 0) return index;
+        index = (index + 1) & mask;
     }
-    entry->value = value;
-    entry->next_entry = NULL;
-    return entry;
 }
 
 HashMap
@@ -46,10 +81,13 @@ hm_create(size_t init_size)
         perror("HashMap Error: illegal initialization size provided");
         exit(EXIT_FAILURE);
     }
+    // Enough slots to hold init_size entries under the max load
+    size_t size = 8;
+    while (size * HM_MAX_LOAD_PERCENT < init_size * 100) size *= HM_RESIZE_FACTOR;
     HashMap map = {
-        .size = init_size,
+        .size = size,
         .entries_count = 0,
-        .entries = calloc(init_size, sizeof(HashMapEntry*))
+        .entries = calloc(size, sizeof(HashMapEntry))
     };
     if(map.entries == NULL) {
         perror("HashMap Error: init map allocation error");
@@ -65,142 +103,98 @@ hm_resize(HashMap* map)
     tmp.size = map->size * HM_RESIZE_FACTOR;
     tmp.entries = calloc(tmp.size, sizeof(HashMapEntry));
     if(tmp.entries == NULL) {
-        return -1;
+        return HM_ERR_MEMORY_ALLOCATION;
     }
 
+    // Entries keep their key and stored hash, nothing is copied or rehashed
     for(size_t i = 0; i < map->size; i++) {
-        if(map->entries[i] != NULL) {
-            hm_put(&tmp, map->entries[i]->key, map->entries[i]->value);
-            HashMapEntry* entry = map->entries[i]->next_entry;
-            while(entry != NULL) {
-                hm_put(&tmp, entry->key, entry->value);
-                entry = entry->next_entry;
-            }
-        }
+        if(map->entries[i].key != NULL) hm_insert_entry(&tmp, map->entries[i]);
     }
-    hm_free(map);
+    free(map->entries);
     *map = tmp;
-    return 0;
+    return HM_OK;
 }
 
 void*
 hm_get(HashMap* map, const char* key)
 {
-    if(map == NULL) {
-        return NULL;
-    }
-
-    char* lower_key = Ju_toLower(key);
-
-    unsigned long hashcode = hash((unsigned char*)lower_key);
-    size_t index = hashcode % map->size;
-
-    HashMapEntry* current = map->entries[index];
-    while (current != NULL) {
-        if (strcmp(current->key, lower_key) == 0) {
-            return current->value;
-        }
-        current = current->next_entry;
-    }
-
-    return NULL;
+    long index = hm_find(map, key);
+    return index >= 0 ? map->entries[index].value : NULL;
 }
 
 Hm_Error
 hm_put(HashMap* map, const char* key, void* value)
 {
-    if(map == NULL) {
-        return -1;
+    if(map == NULL || key == NULL) {
+        return HM_ERR_NULL_PARAM;
     }
-    if(key == NULL) {
-        return -1;
+    if(map->size == 0) {
+        return HM_ERR_INVALID_SIZE;
     }
 
-    int ret;
-    // Resize if map is full
-    // Subject to change to partially full (75%)
-    if(map->size == map->entries_count) {
-        ret = hm_resize(map);
-        if (ret != HM_OK) return ret;
+    long index = hm_find(map, key);
+    if (index >= 0) {
+        // Replace value if same key
+        HashMapEntry* entry = &map->entries[index];
+        if (entry->value != value) free(entry->value);
+        entry->value = value;
+        return HM_OK;
     }
-    char* lower_key = Ju_toLower(key);
-
-    // Hashcode and bucket index
-    unsigned long hashcode = hash((unsigned char*)lower_key);
-    size_t index = hashcode % map->size;
 
-    HashMapEntry* new_entry = create_entry(lower_key, value);
-    if (new_entry == NULL) {
-        return HM_ERR_MEMORY_ALLOCATION;
+    if((map->entries_count + 1) * 100 > map->size * HM_MAX_LOAD_PERCENT) {
+        Hm_Error ret = hm_resize(map);
+        if (ret != HM_OK) return ret;
     }
 
-    if(map->entries[index] == NULL) { // Empty bucket
-        map->entries[index] = new_entry;
-    }
-    else { // Full bucket
-        HashMapEntry* current = map->entries[index];
-        while (current != NULL) {
-            if (strcmp(current->key, lower_key) == 0) {
-                // Replace value if same key
-                current->value = value;
-                free(new_entry->key);
-                free(new_entry);
-                return 0;
-            }
-            current = current->next_entry;
-        }
-        new_entry->next_entry = map->entries[index];
-        map->entries[index] = new_entry;
+    HashMapEntry entry = {
+        .key = strdup(key),
+        .value = value,
+        .hash = hm_hash(key)
+    };
+    if (entry.key == NULL) {
+        return HM_ERR_MEMORY_ALLOCATION;
     }
-    map->entries_count++;
-    return 0;
+    hm_insert_entry(map, entry);
+    return HM_OK;
 }
 
 void*
-hm_remove(HashMap* map, const char* key){
-    if(map == NULL) {
+hm_remove(HashMap* map, const char* key)
+{
+    long found = hm_find(map, key);
+    if (found < 0) {
         return NULL;
     }
 
-    unsigned long hashcode = hash((unsigned char*)key);
-    size_t index = hashcode % map->size;
-
-    HashMapEntry* current = map->entries[index];
-    HashMapEntry* prev = NULL;
-    while (current != NULL) {
-        if (strcmp(current->key, key) == 0) {
-            void* value = current->value;
-            if (prev == NULL) {
-                map->entries[index] = current->next_entry;
-            } else {
-                prev->next_entry = current->next_entry;
-            }
-            free(current->key);
-            free(current);
-            map->entries_count--;
-            return value;
-        }
-        prev = current;
-        current = current->next_entry;
-    }
+    size_t mask = map->size - 1;
+    size_t index = found;
+    void* value = map->entries[index].value;
+    free(map->entries[index].key);
 
-    return NULL;
+    // Shift the following entries of the run back by one, no tombstone is left
+    size_t next = (index + 1) & mask;
+    while (map->entries[next].key != NULL && hm_probe_distance(map, next) > 0) {
+        map->entries[index] = map->entries[next];
+        index = next;
+        next = (next + 1) & mask;
+    }
+    map->entries[index] = (HashMapEntry){0};
+    map->entries_count--;
+    return value;
 }
 
-void 
-hm_free(HashMap* map) 
+void
+hm_free(HashMap* map)
 {
     for (size_t i = 0; i < map->size; i++) {
-        HashMapEntry* entry = map->entries[i];
-        while (entry != NULL) {
-            HashMapEntry* next = entry->next_entry;
-            free(entry->key);
-            free(entry->value);
-            free(entry);
-            entry = next;
-        }
+        if (map->entries[i].key == NULL) continue;
+        free(map->entries[i].key);
+        free(map->entries[i].value);
     }
     free(map->entries);
+    map->entries = NULL;
+    map->size = 0;
+    map->entries_count = 0;
 }
 
 bool
@@ -212,18 +206,19 @@ hm_isempty(HashMap map)
 bool
 hm_exists(HashMap* map, const char* key)
 {
-    char* lower_key = Ju_toLower(key);
-
-    unsigned long hashcode = hash((unsigned char*)lower_key);
-    size_t index = hashcode % map->size;
+    return hm_find(map, key) >= 0;
+}
 
-    HashMapEntry* current = map->entries[index];
-    while (current != NULL) {
-        if (strcmp(current->key, lower_key) == 0) {
-            return true;
-        }
-        current = current->next_entry;
+bool
+hm_next(HashMap* map, size_t* iterator, const char** key, void** value)
+{
+    if (map == NULL) return false;
+    while (*iterator < map->size) {
+        HashMapEntry* entry = &map->entries[(*iterator)++];
+        if (entry->key == NULL) continue;
+        if (key != NULL) *key = entry->key;
+        if (value != NULL) *value = entry->value;
+        return true;
     }
-
     return false;
-}
\ No newline at end of file
+}
@@ -3,88 +3,59 @@
 #include <string.h>
 #include <stdlib.h>
 
-char*
-pad(const char* key, size_t blocksize)
-{
-    char* new_key = calloc(blocksize + 1, 1);
-    memcpy(new_key, key, strlen(key));
-    memset(new_key + strlen(new_key), 0, blocksize - strlen(new_key));
-    new_key[blocksize] = '\0';
-    return new_key;
-}
-
-char*
+/**
+ * Bring a key to the hash's block size, hashed if longer and zero padded
+ */
+uint8_t*
 computeBlockSizedKey(const char* key,
     int (*hash)(uint8_t *output, const uint8_t *input, size_t input_len),
-    size_t blocksize)
+    size_t blocksize, Ju_Arena* arena)
 {
-    char* new_key = NULL;
-    size_t key_len = strlen(key);
-
-    if (strlen(key) > blocksize) {
-        new_key  = calloc(blocksize + 1, 1);
-        uint8_t* output = calloc(blocksize, sizeof(uint8_t));
-        hash(output, (uint8_t*)key, strlen(key));
-        memcpy(new_key, output, blocksize);
-        new_key[blocksize] = '\0';
-        free(output);
-    }
+    uint8_t* new_key = Ju_calloc(arena, blocksize, 1);
+    if (new_key == NULL) return NULL;
 
-    else if (key_len < blocksize) {
-        return pad(key, blocksize);
+    size_t key_len = strlen(key);
+    if (key_len > blocksize) {
+        hash(new_key, (const uint8_t*)key, key_len);
     }
     else {
-        new_key = strdup(key);
+        memcpy(new_key, key, key_len);
     }
-
     return new_key;
 }
 
 char*
 hmac(char* message, const char* key,
     int (*hash)(uint8_t *output, const uint8_t *input, size_t input_len), 
-    size_t blocksize, size_t output_size)
+    size_t blocksize, size_t output_size, Ju_Arena* arena)
 {
-    char* block_sized_key = computeBlockSizedKey(key, hash, blocksize);
-
-    uint8_t* o_key_pad = (uint8_t*)calloc(blocksize, sizeof(uint8_t));
-    uint8_t* i_key_pad = (uint8_t*)calloc(blocksize, sizeof(uint8_t));
+    uint8_t* block_sized_key = computeBlockSizedKey(key, hash, blocksize, arena);
+    size_t message_len = strlen(message);
+    // Inner and outer hash inputs, each starts with its padded key
+    uint8_t* key_pad_msg = Ju_alloc(arena, blocksize + message_len);
+    uint8_t* key_pad_hash = Ju_calloc(arena, blocksize + output_size, sizeof(uint8_t));
+    char* str_hash = Ju_calloc(arena, output_size + 1, sizeof(char));
+    if (block_sized_key == NULL || key_pad_msg == NULL || key_pad_hash == NULL || str_hash == NULL) {
+        Ju_free(arena, block_sized_key);
+        Ju_free(arena, key_pad_msg);
+        Ju_free(arena, key_pad_hash);
+        Ju_free(arena, str_hash);
+        return NULL;
+    }
 
     for (size_t i = 0; i < blocksize; i++) {
-        o_key_pad[i] = block_sized_key[i] ^ 0x5c;
-        i_key_pad[i] = block_sized_key[i] ^ 0x36;
+        key_pad_msg[i] = block_sized_key[i] ^ 0x36;
+        key_pad_hash[i] = block_sized_key[i] ^ 0x5c;
     }
-
-    size_t message_len = strlen(message);
-    uint8_t* key_pad_msg = (uint8_t*)calloc(blocksize + message_len, sizeof(uint8_t));
-    memcpy(key_pad_msg, i_key_pad, blocksize);
     memcpy(key_pad_msg + blocksize, message, message_len);
 
-    size_t key_pad_msg_len = blocksize + message_len;
-
-    uint8_t* hashed = (uint8_t*)calloc(output_size, sizeof(uint8_t));
-    hash(hashed, key_pad_msg, key_pad_msg_len);
-
-    uint8_t* key_pad_hash = (uint8_t*)calloc(blocksize + output_size, sizeof(uint8_t));
-    memcpy(key_pad_hash, o_key_pad, blocksize);
-    memcpy(key_pad_hash + blocksize, hashed, output_size);
-
-    size_t key_pad_hash_len = blocksize + output_size;
-
-    uint8_t* final_hashed = (uint8_t*)calloc(output_size, sizeof(uint8_t));
-    hash(final_hashed, key_pad_hash, key_pad_hash_len);
-
-    char* str_hash = (char*)calloc(output_size + 1, sizeof(char));
-    memcpy(str_hash, final_hashed, output_size);
+    hash(key_pad_hash + blocksize, key_pad_msg, blocksize + message_len);
+    hash((uint8_t*)str_hash, key_pad_hash, blocksize + output_size);
     str_hash[output_size] = '\0';
 
-    free(block_sized_key);
-    free(o_key_pad);
-    free(i_key_pad);
-    free(key_pad_msg);
-    free(hashed);
-    free(key_pad_hash);
-    free(final_hashed);
+    Ju_free(arena, block_sized_key);
+    Ju_free(arena, key_pad_msg);
+    Ju_free(arena, key_pad_hash);
 
     return str_hash;
 }
\ No newline at end of file
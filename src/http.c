@@ -1,31 +1,57 @@
 #include "http.h"
+#include "http_scan.h"
+#include <strings.h>
 
 Http_Error
 Http_parse_request(Http_Request* req, const char* reqstr, const size_t header_len)
+{
+    char* body;
+    int ret = Http_parse_head(req, reqstr, header_len, &body);
+    if (ret != HTTP_OK) return ret;
+
+    if (req->method == HTTP_METHOD_GET) return HTTP_OK;
+
+    const char* ctype = Http_get_header(req, "Content-Type");
+    if (ctype != NULL && body != NULL) {
+        if (strcmp(ctype, "application/json") == 0) {
+            req->body.arena = &req->arena;
+            Jacon_init_content(&req->body);
+            // Routes read a few values out of a body, they are built when looked up
+            Jacon_deserialize_lazy(&req->body, body);
+        }
+    }
+    return HTTP_OK;
+}
+
+Http_Error
+Http_parse_head(Http_Request* req, const char* reqstr, const size_t header_len, char** body)
 {
     int ret;
-    char* method_end = strchr(reqstr, ' ');
-    if (method_end == NULL) {
+    *body = NULL;
+    Http_Scanner scanner;
+    Http_scanner_init(&scanner, reqstr, header_len);
+
+    // Request line: method SP path SP version CRLF, colons only separate header names
+    size_t method_end = Http_scanner_next_space(&scanner);
+    if (method_end >= header_len || reqstr[method_end] != ' ') {
         return HTTP_ERR_MALFORMED_REQ;
     }
-    *method_end = '\0';
-    const char* method_str = reqstr;
-
-    char* path_start = method_end + 1;
-    char* path_end = strchr(path_start, ' ');
-    if (path_end == NULL) {
+    size_t path_end = Http_scanner_next_space(&scanner);
+    if (path_end >= header_len || reqstr[path_end] != ' ') {
         return HTTP_ERR_MALFORMED_REQ;
     }
-    *path_end = '\0';
-    const char* path = path_start;
-
-    char* version_start = path_end + 1;
-    char* version_end = strstr(version_start, "\r\n");
-    if (version_end == NULL) {
+    size_t version_end = Http_scanner_next_space(&scanner);
+    if (version_end + 1 >= header_len || reqstr[version_end] != '\r' || reqstr[version_end + 1] != '\n') {
         return HTTP_ERR_MALFORMED_REQ;
     }
-    *version_end = '\0';
-    const char* version = version_start;
+
+    char* buf = (char*)reqstr;
+    buf[method_end] = '\0';
+    buf[path_end] = '\0';
+    buf[version_end] = '\0';
+    const char* method_str = reqstr;
+    const char* path = reqstr + method_end + 1;
+    const char* version = reqstr + path_end + 1;
 
     req->method = Http_parse_method(method_str);
     if (req->method == HTTP_METHOD_INVALID) {
@@ -35,27 +61,19 @@ Http_parse_request(Http_Request* req, const char* reqstr, const size_t header_le
     if (!Http_validate_path(path)) {
         return HTTP_ERR_INVALID_PATH;
     }
-    req->path = strdup(path);
+    req->path = (char*)path;
 
     req->version = Http_parse_version(version);
     if (req->version == HTTP_VERSION_INVALID) {
         return HTTP_UNSUPPORTED_VERSION;
     }
 
-    req->headers = hm_create(10);
-    char* headers_last; // NULL or at body start after parsing
-    ret = Http_parse_headers(&req->headers, version_end + 2, &headers_last, header_len);
+    req->headers.count = 0;
+    char* headers_last = NULL; // NULL or at body start after parsing
+    size_t headers_start = version_end + 2;
+    ret = Http_parse_headers(&req->headers, reqstr + headers_start, &headers_last, header_len - headers_start);
     if (ret != HTTP_OK) return ret;
-
-    if (req->method == HTTP_METHOD_GET) return HTTP_OK;
-
-    if(hm_exists(&req->headers, "Content-Type")) {
-        char* ctype = hm_get(&req->headers, "Content-Type");
-        if (strcmp(ctype, "application/json") == 0) {
-            Jacon_init_content(&req->body);
-            Jacon_deserialize(&req->body, headers_last);
-        }
-    }
+    *body = headers_last;
     return HTTP_OK;
 }
 
@@ -63,49 +81,49 @@ Http_Error
 Http_parse_headers(Http_Headers* headers, const char* headers_str, char** headers_last, const size_t header_len) {
     if (headers == NULL || headers_last == NULL)
         return HTTP_ERR_NULL_PARAM;
-    if (headers_str == NULL || *headers_str == '\0')
+    if (headers_str == NULL || header_len == 0)
         return HTTP_OK;
 
-    const char *headers_end = headers_str + header_len;
-    const char *line_start = headers_str;
-    const char *line_end;
-
-    while (line_start < headers_end) {
-        line_end = strstr(line_start, "\r\n");
-        if (line_end == NULL || line_end >= headers_end) {
-            return HTTP_ERR_MALFORMED_REQ;
-        }
+    // The head is classified once, lines are split on the scanner's CRs
+    Http_Scanner scanner;
+    Http_scanner_init(&scanner, headers_str, header_len);
+    size_t line_start = 0;
 
-        if (line_start == line_end) {
-            *headers_last = (char*)(line_end + 2);
+    while (line_start < header_len) {
+        if (headers_str[line_start] == '\r') {
+            if (line_start + 1 >= header_len || headers_str[line_start + 1] != '\n') {
+                return HTTP_ERR_MALFORMED_REQ;
+            }
+            *headers_last = (char*)(headers_str + line_start + 2);
             return HTTP_OK;
         }
 
-        const char* sep = memchr(line_start, ':', line_end - line_start);
-        if (sep == NULL) {
+        size_t sep = Http_scanner_next(&scanner);
+        while (sep < header_len && headers_str[sep] == ' ') sep = Http_scanner_next(&scanner);
+        if (sep >= header_len || headers_str[sep] != ':') {
             return HTTP_ERR_MALFORMED_REQ;
         }
 
-        char* key = strndup(line_start, sep - line_start);
-        if (key == NULL) {
-            return HTTP_ERR_MEMORY_ALLOCATION;
+        // Spaces and colons of the value are skipped up to the CR
+        size_t line_end = Http_scanner_next_line(&scanner);
+        if (line_end + 1 >= header_len || headers_str[line_end + 1] != '\n') {
+            return HTTP_ERR_MALFORMED_REQ;
         }
 
-        const char* value_start = sep + 1;
-        while (value_start < line_end && *value_start == ' ') value_start++;
-
-        char* value = strndup(value_start, line_end - value_start);
-        if (value == NULL) {
-            free(key);
-            return HTTP_ERR_MEMORY_ALLOCATION;
+        if (headers->count == HTTP_MAX_HEADERS) {
+            return HTTP_ERR_TOO_MANY_HEADERS;
         }
 
-        if (hm_put(headers, key, (void*)value) != 0) {
-            free(key);
-            free(value);
-            return HTTP_ERR_MEMORY_ALLOCATION;
-        }
-        free(key);
+        const char* value_start = headers_str + sep + 1;
+        while (*value_start == ' ' || *value_start == '\t') value_start++;
+        const char* value_end = headers_str + line_end;
+        while (value_end > value_start && (value_end[-1] == ' ' || value_end[-1] == '\t')) value_end--;
+
+        Http_Header* header = &headers->entries[headers->count++];
+        header->key = (Http_Slice){ .ptr = headers_str + line_start, .len = sep - line_start };
+        header->value = (Http_Slice){ .ptr = value_start, .len = value_end - value_start };
+        // Terminate the value over its trailing whitespace or CR
+        *(char*)value_end = '\0';
 
         line_start = line_end + 2;
     }
@@ -113,6 +131,155 @@ Http_parse_headers(Http_Headers* headers, const char* headers_str, char** header
     return HTTP_ERR_MALFORMED_REQ;
 }
 
+const char*
+Http_get_header(Http_Request* req, const char* key)
+{
+    size_t len = strlen(key);
+    for (size_t i = 0; i < req->headers.count; i++) {
+        Http_Header* header = &req->headers.entries[i];
+        if (header->key.len == len && strncasecmp(header->key.ptr, key, len) == 0) {
+            return header->value.ptr;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Find a response header by case-insensitive name, NULL if it is not set
+ */
+Http_Header*
+Http_find_response_header(Http_Response* res, const char* key, size_t len)
+{
+    for (size_t i = 0; i < res->headers_count; i++) {
+        Http_Header* header = &res->headers[i];
+        if (header->key.len == len && strncasecmp(header->key.ptr, key, len) == 0) return header;
+    }
+    return NULL;
+}
+
+Http_Error
+Http_set_header(Http_Response* res, const char* key, const char* value)
+{
+    if (res == NULL || key == NULL || value == NULL) return HTTP_ERR_NULL_PARAM;
+    size_t len = strlen(key);
+    Http_Header* header = Http_find_response_header(res, key, len);
+    if (header == NULL) {
+        if (res->headers_count == HTTP_MAX_RESPONSE_HEADERS) return HTTP_ERR_TOO_MANY_HEADERS;
+        header = &res->headers[res->headers_count++];
+        header->key = (Http_Slice){ .ptr = key, .len = len };
+    }
+    header->value = (Http_Slice){ .ptr = value, .len = strlen(value) };
+    return HTTP_OK;
+}
+
+const char*
+Http_get_response_header(Http_Response* res, const char* key)
+{
+    Http_Header* header = Http_find_response_header(res, key, strlen(key));
+    return header != NULL ? header->value.ptr : NULL;
+}
+
+size_t
+Http_serialize_headers(Http_Response* res, char* buf, size_t size)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < res->headers_count; i++) {
+        Http_Header* header = &res->headers[i];
+        size_t len = header->key.len + header->value.len + 4;
+        if (len > size - count) return size + 1;
+        memcpy(buf + count, header->key.ptr, header->key.len);
+        count += header->key.len;
+        buf[count++] = ':';
+        buf[count++] = ' ';
+        memcpy(buf + count, header->value.ptr, header->value.len);
+        count += header->value.len;
+        buf[count++] = '\r';
+        buf[count++] = '\n';
+    }
+    return count;
+}
+
+typedef struct Http_Mime_Type {
+    const char* extension;
+    const char* type;
+} Http_Mime_Type;
+
+/**
+ * Perfect hash of a lowercase extension of at least 2 characters
+ *  Multipliers found offline so that no two extensions of the table collide
+ */
+#define HTTP_MIME_HASH(first, second, last, len) ((((first) * 7) ^ ((second) * 47) ^ (last) ^ (len)) & 63)
+
+// Indexed by HTTP_MIME_HASH, an extension is only ever found in its own slot
+const Http_Mime_Type http_mime_types[64] = {
+    [2] = { "woff", "font/woff" },
+    [5] = { "ttf", "font/ttf" },
+    [6] = { "png", "image/png" },
+    [7] = { "map", "application/json" },
+    [10] = { "js", "text/javascript; charset=utf-8" },
+    [15] = { "gz", "application/gzip" },
+    [17] = { "json", "application/json" },
+    [18] = { "jpg", "image/jpeg" },
+    [19] = { "txt", "text/plain; charset=utf-8" },
+    [21] = { "jpeg", "image/jpeg" },
+    [23] = { "woff2", "font/woff2" },
+    [24] = { "css", "text/css; charset=utf-8" },
+    [27] = { "mp3", "audio/mpeg" },
+    [28] = { "mp4", "video/mp4" },
+    [29] = { "csv", "text/csv; charset=utf-8" },
+    [30] = { "ico", "image/x-icon" },
+    [32] = { "otf", "font/otf" },
+    [34] = { "zip", "application/zip" },
+    [35] = { "webm", "video/webm" },
+    [36] = { "xml", "application/xml" },
+    [39] = { "wasm", "application/wasm" },
+    [41] = { "pdf", "application/pdf" },
+    [43] = { "svg", "image/svg+xml" },
+    [47] = { "avif", "image/avif" },
+    [51] = { "gif", "image/gif" },
+    [58] = { "htm", "text/html; charset=utf-8" },
+    [59] = { "wav", "audio/wav" },
+    [60] = { "html", "text/html; charset=utf-8" },
+    [61] = { "mjs", "text/javascript; charset=utf-8" },
+    [62] = { "webp", "image/webp" },
+};
+
+const char*
+Http_get_mime_type(const char* path)
+{
+    const char* dot = strrchr(path, '.');
+    if (dot == NULL || strchr(dot, '/') != NULL) return "application/octet-stream";
+    const char* ext = dot + 1;
+    size_t len = strlen(ext);
+    if (len < 2 || len > 5) return "application/octet-stream";
+
+    // Setting 0x20 lowercases letters and leaves digits untouched
+    unsigned first = ext[0] | 0x20, second = ext[1] | 0x20, last = ext[len - 1] | 0x20;
+    const Http_Mime_Type* mime = &http_mime_types[HTTP_MIME_HASH(first, second, last, len)];
+    if (mime->extension == NULL || strcasecmp(mime->extension, ext) != 0) return "application/octet-stream";
+    return mime->type;
+}
+
+Http_Slice
+Http_get_param(Http_Request* req, const char* name)
+{
+    size_t len = strlen(name);
+    for (size_t i = 0; i < req->params_count; i++) {
+        Http_Param* param = &req->params[i];
+        if (param->name.len == len && memcmp(param->name.ptr, name, len) == 0) {
+            return param->value;
+        }
+    }
+    return (Http_Slice){0};
+}
+
+bool
+Http_keep_alive(Http_Request* req)
+{
+    if (req->version != HTTP_VERSION_1_1) return false;
+    const char* connection = Http_get_header(req, "Connection");
+    return connection == NULL || strcasecmp(connection, "close") != 0;
+}
 
 bool
 Http_validate_path(const char* path)
@@ -138,6 +305,7 @@ Http_Version
 Http_parse_version(const char* str)
 {
     if(!strcmp(str, "HTTP/1.1")) return HTTP_VERSION_1_1;
+    if(!strcmp(str, "HTTP/1.0")) return HTTP_VERSION_1_0;
     return HTTP_VERSION_INVALID;
 }
 
@@ -183,10 +351,14 @@ Http_strstatus(Http_Status status)
             return "Not Found";
         case HTTP_STATUS_NOT_ALLOWED:
             return "Not Allowed";
+        case HTTP_STATUS_PAYLOAD_TOO_LARGE:
+            return "Payload Too Large";
         case HTTP_STATUS_INTERNAL_SERVER_ERROR :
             return "Internal Server Error";
         case HTTP_STATUS_NOT_IMPLEMENTED:
             return "Not Implemented";
+        case HTTP_STATUS_VERSION_NOT_SUPPORTED:
+            return "HTTP Version Not Supported";
         default:
             return NULL;
     }
@@ -195,8 +367,10 @@ Http_strstatus(Http_Status status)
 void
 Http_free_request(Http_Request* req)
 {
-    hm_free(&req->headers);
-    if (req->path != NULL) free(req->path);
+    req->headers.count = 0;
+    req->params_count = 0;
+    if (req->body.root != NULL) Jacon_free_content(&req->body);
+    Ju_arena_reset(&req->arena);
 }
 
 const char*
@@ -217,10 +391,14 @@ Http_get_status_header(Http_Status status)
             return HTTP_HEADER_NOT_FOUND;
         case HTTP_STATUS_NOT_ALLOWED:
             return HTTP_HEADER_NOT_ALLOWED;
+        case HTTP_STATUS_PAYLOAD_TOO_LARGE:
+            return HTTP_HEADER_PAYLOAD_TOO_LARGE;
         case HTTP_STATUS_INTERNAL_SERVER_ERROR:
             return HTTP_HEADER_INTERNAL_SERVER_ERROR;
         case HTTP_STATUS_NOT_IMPLEMENTED:
             return HTTP_HEADER_NOT_IMPLEMENTED;
+        case HTTP_STATUS_VERSION_NOT_SUPPORTED:
+            return HTTP_HEADER_VERSION_NOT_SUPPORTED;
         default:
             return NULL;
     }
@@ -0,0 +1,183 @@
+#include "http_scan.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86
+#endif
+
+Http_Scan_Masks (*Http_scan_block)(const char* block) = NULL;
+
+/**
+ * Classify the first len bytes of block, len can be short of a full block
+ */
+Http_Scan_Masks
+Http_scan_bytes(const char* block, size_t len)
+{
+    Http_Scan_Masks masks = {0};
+    for (size_t i = 0; i < len; i++) {
+        char c = block[i];
+        if (c == '\r') masks.cr |= (uint64_t)1 << i;
+        else if (c == ':' || c == ' ') masks.sep |= (uint64_t)1 << i;
+    }
+    return masks;
+}
+
+#define HTTP_SCAN_ONES 0x0101010101010101ULL
+#define HTTP_SCAN_LOW7 0x7F7F7F7F7F7F7F7FULL
+
+/**
+ * Get one bit per byte of word equal to c, byte i giving bit i
+ */
+uint64_t
+Http_scan_word(uint64_t word, char c)
+{
+    uint64_t x = word ^ (HTTP_SCAN_ONES * (unsigned char)c);
+    // High bit of every zero byte, exact unlike the usual haszero trick
+    uint64_t zero = ~(((x & HTTP_SCAN_LOW7) + HTTP_SCAN_LOW7) | x | HTTP_SCAN_LOW7);
+    // Gather the 8 high bits into the top byte
+    return ((zero >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+Http_Scan_Masks
+Http_scan_block_scalar(const char* block)
+{
+    // SWAR, 8 bytes at a time for CPUs without a SIMD classifier
+    Http_Scan_Masks masks = {0};
+    for (int i = 0; i < HTTP_SCAN_BLOCK_SIZE / 8; i++) {
+        uint64_t word;
+        memcpy(&word, block + i * 8, sizeof(word));
+        masks.cr |= Http_scan_word(word, '\r') << (i * 8);
+        masks.sep |= (Http_scan_word(word, ':') | Http_scan_word(word, ' ')) << (i * 8);
+    }
+    return masks;
+}
+
+#ifdef HTTP_SCAN_X86
+
+__attribute__((target("sse4.2")))
+Http_Scan_Masks
+Http_scan_block_sse42(const char* block)
+{
+    // pcmpestrm matches every byte against both separators at once
+    const __m128i separators = _mm_setr_epi8(':', ' ', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i cr = _mm_set1_epi8('\r');
+    Http_Scan_Masks masks = {0};
+    for (int i = 0; i < HTTP_SCAN_BLOCK_SIZE / 16; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(block + i * 16));
+        __m128i sep = _mm_cmpestrm(separators, 2, chunk, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        masks.sep |= (uint64_t)(uint16_t)_mm_cvtsi128_si32(sep) << (i * 16);
+        masks.cr |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr)) << (i * 16);
+    }
+    return masks;
+}
+
+__attribute__((target("avx2")))
+Http_Scan_Masks
+Http_scan_block_avx2(const char* block)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i space = _mm256_set1_epi8(' ');
+    Http_Scan_Masks masks = {0};
+    for (int i = 0; i < HTTP_SCAN_BLOCK_SIZE / 32; i++) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(block + i * 32));
+        __m256i sep = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon), _mm256_cmpeq_epi8(chunk, space));
+        masks.sep |= (uint64_t)(uint32_t)_mm256_movemask_epi8(sep) << (i * 32);
+        masks.cr |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr)) << (i * 32);
+    }
+    return masks;
+}
+
+#else
+
+Http_Scan_Masks
+Http_scan_block_sse42(const char* block)
+{
+    return Http_scan_block_scalar(block);
+}
+
+Http_Scan_Masks
+Http_scan_block_avx2(const char* block)
+{
+    return Http_scan_block_scalar(block);
+}
+
+#endif // HTTP_SCAN_X86
+
+const char*
+Http_scan_init(void)
+{
+#ifdef HTTP_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        Http_scan_block = Http_scan_block_avx2;
+        return "avx2";
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        Http_scan_block = Http_scan_block_sse42;
+        return "sse4.2";
+    }
+#endif
+    Http_scan_block = Http_scan_block_scalar;
+    return "scalar";
+}
+
+/**
+ * Classify the block starting at offset, the tail shorter than a block is done scalar
+ */
+void
+Http_scanner_load(Http_Scanner* scanner, size_t offset)
+{
+    scanner->block = offset;
+    size_t left = scanner->len - offset;
+    if (left >= HTTP_SCAN_BLOCK_SIZE) scanner->masks = Http_scan_block(scanner->buf + offset);
+    else scanner->masks = Http_scan_bytes(scanner->buf + offset, left);
+}
+
+void
+Http_scanner_init(Http_Scanner* scanner, const char* buf, size_t len)
+{
+    if (Http_scan_block == NULL) Http_scan_init();
+    scanner->buf = buf;
+    scanner->len = len;
+    Http_scanner_load(scanner, 0);
+}
+
+size_t
+Http_scanner_next(Http_Scanner* scanner)
+{
+    uint64_t mask;
+    while ((mask = scanner->masks.cr | scanner->masks.sep) == 0) {
+        if (scanner->block + HTTP_SCAN_BLOCK_SIZE >= scanner->len) return scanner->len;
+        Http_scanner_load(scanner, scanner->block + HTTP_SCAN_BLOCK_SIZE);
+    }
+    // Clear the lowest set bit, whichever mask holds it
+    uint64_t lowest = mask & -mask;
+    scanner->masks.cr &= ~lowest;
+    scanner->masks.sep &= ~lowest;
+    return scanner->block + __builtin_ctzll(mask);
+}
+
+size_t
+Http_scanner_next_line(Http_Scanner* scanner)
+{
+    while (scanner->masks.cr == 0) {
+        if (scanner->block + HTTP_SCAN_BLOCK_SIZE >= scanner->len) return scanner->len;
+        Http_scanner_load(scanner, scanner->block + HTTP_SCAN_BLOCK_SIZE);
+    }
+    uint64_t cr = scanner->masks.cr;
+    // The separators up to the CR belong to the line being skipped
+    scanner->masks.sep &= ~(cr ^ (cr - 1));
+    scanner->masks.cr = cr & (cr - 1);
+    return scanner->block + __builtin_ctzll(cr);
+}
+
+size_t
+Http_scanner_next_space(Http_Scanner* scanner)
+{
+    size_t offset = Http_scanner_next(scanner);
+    while (offset < scanner->len && scanner->buf[offset] == ':') offset = Http_scanner_next(scanner);
+    return offset;
+}
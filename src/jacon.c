@@ -1,4 +1,7 @@
 #include "jacon.h"
+#include "jacon_index.h"
+#include "jacon_number.h"
+#include <inttypes.h>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -7,10 +10,27 @@
 #include <limits.h>
 #include <ctype.h>
 #include <stdarg.h>
+#include <errno.h>
 
 #define Jacon_str_append_null(builder, ...) Jacon_str_append(builder, __VA_ARGS__, NULL)
 #define Jacon_str_append_fmt_null(builder, ...) Jacon_str_append_fmt(builder, __VA_ARGS__, NULL)
 
+/**
+ * Make room for len more bytes and the NUL terminator
+ */
+Jacon_Error
+Jacon_str_reserve(Jacon_StringBuilder* builder, size_t len)
+{
+    if (builder->count + len + 1 <= builder->capacity) return JACON_OK;
+    size_t new_capacity = builder->capacity * 2;
+    if (new_capacity < builder->count + len + 1) new_capacity = builder->count + len + 1;
+    char* tmp = Ju_realloc(builder->arena, builder->string, builder->capacity, new_capacity);
+    if (tmp == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+    builder->string = tmp;
+    builder->capacity = new_capacity;
+    return JACON_OK;
+}
+
 Jacon_Error 
 Jacon_str_append(Jacon_StringBuilder* builder, ...) 
 {
@@ -25,14 +45,11 @@ Jacon_str_append(Jacon_StringBuilder* builder, ...)
     {
         size_t size = strlen(arg);
         if (size > 0) {
-            if (builder->count + size + 1 > builder->capacity)
-            {
-                size_t new_capacity = builder->count + size + 1;
-                builder->string = realloc(builder->string, new_capacity);
-                if (builder->string == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-                builder->capacity = new_capacity;
+            if (Jacon_str_reserve(builder, size) != JACON_OK) {
+                va_end(args);
+                return JACON_ERR_MEMORY_ALLOCATION;
             }
-            strncpy(builder->string + builder->count, arg, size);
+            memcpy(builder->string + builder->count, arg, size);
             builder->count += size;
             builder->string[builder->count] = '\0';
         }
@@ -60,14 +77,8 @@ Jacon_str_append_fmt(Jacon_StringBuilder* builder, const char* fmt, ...)
         return JACON_ERR_APPEND_FSTRING;
 
     size = (size_t) n + 1;
-    if (builder->capacity < builder->count + size) {
-        size_t new_capacity = builder->count + size;
-        char* tmp = realloc(builder->string, new_capacity);
-        if (tmp == NULL) {
-            return JACON_ERR_MEMORY_ALLOCATION;
-        }
-        builder->string = tmp;
-        builder->capacity = new_capacity;
+    if (Jacon_str_reserve(builder, size - 1) != JACON_OK) {
+        return JACON_ERR_MEMORY_ALLOCATION;
     }
 
     va_start(args, fmt);
@@ -83,12 +94,50 @@ Jacon_str_append_fmt(Jacon_StringBuilder* builder, const char* fmt, ...)
     return JACON_OK;
 } 
 
+/**
+ * Append a number, formatted right into the builder
+ */
+Jacon_Error
+Jacon_str_append_number(Jacon_StringBuilder* builder, Jacon_ValueType type, Jacon_Value value)
+{
+    if (builder == NULL) {
+        return JACON_ERR_NULL_PARAM;
+    }
+    if (Jacon_str_reserve(builder, JACON_NUMBER_MAX_LENGTH) != JACON_OK) return JACON_ERR_MEMORY_ALLOCATION;
+    char* end = builder->string + builder->count;
+    switch (type) {
+        case JACON_VALUE_INT:
+            builder->count += Jacon_format_int64(end, value.int_val);
+            break;
+        case JACON_VALUE_INT64:
+            builder->count += Jacon_format_int64(end, value.int64_val);
+            break;
+        case JACON_VALUE_UINT64:
+            builder->count += Jacon_format_uint64(end, value.uint64_val);
+            break;
+        case JACON_VALUE_FLOAT:
+            builder->count += Jacon_format_float(end, value.float_val);
+            break;
+        case JACON_VALUE_DOUBLE:
+            builder->count += Jacon_format_double(end, value.double_val);
+            break;
+        case JACON_VALUE_OBJECT:
+        case JACON_VALUE_ARRAY:
+        case JACON_VALUE_STRING:
+        case JACON_VALUE_BOOLEAN:
+        case JACON_VALUE_NULL:
+            return JACON_ERR_INVALID_VALUE_TYPE;
+    }
+    builder->string[builder->count] = '\0';
+    return JACON_OK;
+}
+
 void
 Jacon_str_free(Jacon_StringBuilder *builder)
 {
     if (builder->string != NULL) 
     {
-        free(builder->string);
+        Ju_free(builder->arena, builder->string);
         builder->string = NULL;
     }
 }
@@ -113,15 +162,15 @@ Jacon_hash(unsigned char *str)
  * Create a new entry with the key, value pair
  */
 Jacon_HashMapEntry*
-Jacon_create_mapentry(const char* key, void* value)
+Jacon_create_mapentry(Ju_Arena* arena, const char* key, void* value)
 {
-    Jacon_HashMapEntry* entry = calloc(1, sizeof(Jacon_HashMapEntry));
+    Jacon_HashMapEntry* entry = Ju_calloc(arena, 1, sizeof(Jacon_HashMapEntry));
     if (entry == NULL) {
         return NULL;
     }
-    entry->key = strdup(key);
+    entry->key = Ju_strdup(arena, key);
     if (entry->key == NULL) {
-        free(entry);
+        Ju_free(arena, entry);
         return NULL;
     }
     entry->value = value;
@@ -152,34 +201,33 @@ Jacon_hm_create(Jacon_HashMap* map, size_t init_size)
 Jacon_Error
 Jacon_hm_resize(Jacon_HashMap* map)
 {
-    Jacon_HashMap tmp = {0};
-    tmp.size = map->size * JACON_MAP_RESIZE_FACTOR;
-    tmp.entries = calloc(tmp.size, sizeof(Jacon_HashMapEntry));
-    if(tmp.entries == NULL) {
+    size_t size = map->size * JACON_MAP_RESIZE_FACTOR;
+    Jacon_HashMapEntry** entries = Ju_calloc(map->arena, size, sizeof(Jacon_HashMapEntry*));
+    if(entries == NULL) {
         return JACON_ERR_MEMORY_ALLOCATION;
     }
 
+    // Entries are moved to their new bucket, keys and values are kept as is
     for(size_t i = 0; i < map->size; i++) {
-        if(map->entries[i] != NULL) {
-            Jacon_Node* duped = Jacon_duplicate_node(map->entries[i]->value);
-            Jacon_hm_put(&tmp, map->entries[i]->key, duped);
-            Jacon_HashMapEntry* entry = map->entries[i]->next_entry;
-            while(entry != NULL) {
-                duped = Jacon_duplicate_node(entry->value);
-                Jacon_hm_put(&tmp, entry->key, duped);
-                entry = entry->next_entry;
-            }
+        Jacon_HashMapEntry* entry = map->entries[i];
+        while(entry != NULL) {
+            Jacon_HashMapEntry* next = entry->next_entry;
+            size_t index = Jacon_hash((unsigned char*)entry->key) % size;
+            entry->next_entry = entries[index];
+            entries[index] = entry;
+            entry = next;
         }
     }
-    Jacon_hm_free(map);
-    *map = tmp;
+    Ju_free(map->arena, map->entries);
+    map->entries = entries;
+    map->size = size;
     return JACON_OK;
 }
 
 void*
 Jacon_hm_get(Jacon_HashMap* map, const char* key)
 {
-    if(map == NULL) {
+    if(map == NULL || map->size == 0) {
         return NULL;
     }
 
@@ -219,7 +267,7 @@ Jacon_hm_put(Jacon_HashMap* map, const char* key, void* value)
     unsigned long hashcode = Jacon_hash((unsigned char*)key);
     size_t index = hashcode % map->size;
 
-    Jacon_HashMapEntry* new_entry = Jacon_create_mapentry(key, value);
+    Jacon_HashMapEntry* new_entry = Jacon_create_mapentry(map->arena, key, value);
     if (new_entry == NULL) {
         return JACON_ERR_MEMORY_ALLOCATION;
     }
@@ -233,8 +281,8 @@ Jacon_hm_put(Jacon_HashMap* map, const char* key, void* value)
             if (strcmp(current->key, key) == 0) {
                 // Replace value if same key
                 current->value = value;
-                free(new_entry->key);
-                free(new_entry);
+                Ju_free(map->arena, new_entry->key);
+                Ju_free(map->arena, new_entry);
                 return JACON_OK;
             }
             current = current->next_entry;
@@ -265,8 +313,8 @@ Jacon_hm_remove(Jacon_HashMap* map, const char* key){
             } else {
                 prev->next_entry = current->next_entry;
             }
-            free(current->key);
-            free(current);
+            Ju_free(map->arena, current->key);
+            Ju_free(map->arena, current);
             map->entries_count--;
             return value;
         }
@@ -289,6 +337,7 @@ Jacon_hm_free_entry(Jacon_HashMapEntry* entry)
     }
     if (entry->value != NULL) {
         Jacon_free_node(entry->value);
+        free(entry->value);
         entry->value = NULL;
     }
     free(entry);
@@ -299,6 +348,11 @@ Jacon_hm_free(Jacon_HashMap* map)
 {
     if (map == NULL || map->entries == NULL)
         return;
+    // Everything goes away with the arena
+    if (map->arena != NULL) {
+        map->entries = NULL;
+        return;
+    }
     for (size_t i = 0; i < map->size; i++) {
         Jacon_HashMapEntry* entry = map->entries[i];
         while (entry != NULL) {
@@ -315,15 +369,15 @@ Jacon_hm_free(Jacon_HashMap* map)
  * Create a new entry with the key
  */
 Jacon_HashSetEntry*
-Jacon_create_setentry(const char* key)
+Jacon_create_setentry(Ju_Arena* arena, const char* key)
 {
-    Jacon_HashSetEntry* entry = calloc(1, sizeof(Jacon_HashSetEntry));
+    Jacon_HashSetEntry* entry = Ju_calloc(arena, 1, sizeof(Jacon_HashSetEntry));
     if (entry == NULL) {
         return NULL;
     }
-    entry->key = strdup(key);
+    entry->key = Ju_strdup(arena, key);
     if (entry->key == NULL) {
-        free(entry);
+        Ju_free(arena, entry);
         return NULL;
     }
     entry->next = NULL;
@@ -334,20 +388,18 @@ Jacon_Error
 Jacon_hs_resize(Jacon_HashSet* set)
 {
     Jacon_HashSet tmp = {0};
+    tmp.arena = set->arena;
     tmp.capacity = set->capacity * JACON_MAP_RESIZE_FACTOR;
-    tmp.entries = calloc(tmp.capacity, sizeof(Jacon_HashSetEntry));
+    tmp.entries = Ju_calloc(tmp.arena, tmp.capacity, sizeof(Jacon_HashSetEntry*));
     if(tmp.entries == NULL) {
         return JACON_ERR_MEMORY_ALLOCATION;
     }
 
     for(size_t i = 0; i < set->capacity; i++) {
-        if(set->entries[i] != NULL) {
-            Jacon_hs_put(&tmp, set->entries[i]->key);
-            Jacon_HashSetEntry* entry = set->entries[i];
-            while(entry != NULL) {
-                Jacon_hs_put(&tmp, set->entries[i]->key);
-                entry = entry->next;
-            }
+        Jacon_HashSetEntry* entry = set->entries[i];
+        while(entry != NULL) {
+            Jacon_hs_put(&tmp, entry->key);
+            entry = entry->next;
         }
     }
     Jacon_hs_free(set);
@@ -395,7 +447,7 @@ Jacon_hs_put(Jacon_HashSet *set, const char* key)
     unsigned long hashcode = Jacon_hash((unsigned char*)key);
     size_t index = hashcode % set->capacity;
 
-    Jacon_HashSetEntry* new_entry = Jacon_create_setentry(key);
+    Jacon_HashSetEntry* new_entry = Jacon_create_setentry(set->arena, key);
     if (new_entry == NULL) {
         return JACON_ERR_MEMORY_ALLOCATION;
     }
@@ -436,6 +488,10 @@ Jacon_hs_free(Jacon_HashSet* set)
 {
     if (set == NULL || set->entries == NULL)
         return;
+    if (set->arena != NULL) {
+        set->entries = NULL;
+        return;
+    }
     for (size_t i = 0; i < set->capacity; i++) {
         Jacon_HashSetEntry* entry = set->entries[i];
         while (entry != NULL) {
@@ -465,7 +521,7 @@ Jacon_hs_remove(Jacon_HashSet *set, const char* key)
             if (prev != NULL) {
                 prev->next = current->next;
             }
-            Jacon_hs_free_entry(current);
+            if (set->arena == NULL) Jacon_hs_free_entry(current);
             set->count--;
             return JACON_OK;
         }
@@ -476,64 +532,6 @@ Jacon_hs_remove(Jacon_HashSet *set, const char* key)
     return JACON_OK;
 }
 
-// Debug print token
-void 
-Jacon_print_token(const Jacon_Token* token) 
-{
-    switch (token->type) {
-        case JACON_TOKEN_STRING:
-            printf("Token Type: STRING, Value: %s\n", token->string_val);
-            break;
-        case JACON_TOKEN_INT:
-            printf("Token Type: INT, Value: %d\n", token->int_val);
-            break;
-        case JACON_TOKEN_FLOAT:
-            printf("Token Type: FLOAT, Value: %f\n", token->float_val);
-            break;
-        case JACON_TOKEN_DOUBLE:
-            printf("Token Type: DOUBLE, Value: %lf\n", token->double_val);
-            break;
-        case JACON_TOKEN_BOOLEAN:
-            printf("Token Type: BOOLEAN, Value: %s\n", token->bool_val ? "true" : "false");
-            break;
-        case JACON_TOKEN_ARRAY_START:
-            printf("Token Type: ARRAY_START\n");
-            break;
-        case JACON_TOKEN_ARRAY_END:
-            printf("Token Type: ARRAY_END\n");
-            break;
-        case JACON_TOKEN_OBJECT_START:
-            printf("Token Type: OBJECT_START\n");
-            break;
-        case JACON_TOKEN_OBJECT_END:
-            printf("Token Type: OBJECT_END\n");
-            break;
-        case JACON_TOKEN_NULL:
-            printf("Token Type: NULL VALUE\n");
-            break;
-        case JACON_TOKEN_COLON:
-            printf("Token Type: COLON\n");
-            break;
-        case JACON_TOKEN_COMMA:
-            printf("Token Type: COMMA\n");
-            break;
-        default:
-            printf("Unknown Token Type\n");
-            break;
-    }
-}
-
-// Debug print tokenizer
-void 
-Jacon_print_tokenizer(const Jacon_Tokenizer* tokenizer) 
-{
-    printf("Tokenizer contains %zu tokens:\n", tokenizer->count);
-    for (size_t i = 0; i < tokenizer->count; ++i) {
-        printf("Token %zu: ", i);
-        Jacon_print_token(&tokenizer->tokens[i]);
-    }
-}
-
 void 
 Jacon_print_node_value(Jacon_Value value, Jacon_ValueType type) 
 {
@@ -544,6 +542,12 @@ Jacon_print_node_value(Jacon_Value value, Jacon_ValueType type)
         case JACON_VALUE_INT:
             printf("%d", value.int_val);
             break;
+        case JACON_VALUE_INT64:
+            printf("%" PRId64, value.int64_val);
+            break;
+        case JACON_VALUE_UINT64:
+            printf("%" PRIu64, value.uint64_val);
+            break;
         case JACON_VALUE_FLOAT:
             printf("%f", value.float_val);
             break;
@@ -580,7 +584,7 @@ Jacon_print_node(Jacon_Node* node, int indent)
         case JACON_VALUE_OBJECT:
             printf("{\n");
             for (size_t i = 0; i < node->child_count; ++i) {
-                Jacon_print_node(node->childs[i], indent + 1);
+                Jacon_print_node(&node->childs[i], indent + 1);
                 if (i < node->child_count - 1) {
                     printf(",");
                 }
@@ -594,7 +598,7 @@ Jacon_print_node(Jacon_Node* node, int indent)
         case JACON_VALUE_ARRAY:
             printf("[\n");
             for (size_t i = 0; i < node->child_count; ++i) {
-                Jacon_print_node(node->childs[i], indent + 1);
+                Jacon_print_node(&node->childs[i], indent + 1);
                 if (i < node->child_count - 1) {
                     printf(",");
                 }
@@ -607,6 +611,8 @@ Jacon_print_node(Jacon_Node* node, int indent)
             break;
         case JACON_VALUE_STRING:
         case JACON_VALUE_INT:
+        case JACON_VALUE_INT64:
+        case JACON_VALUE_UINT64:
         case JACON_VALUE_FLOAT:
         case JACON_VALUE_DOUBLE:
         case JACON_VALUE_BOOLEAN:
@@ -617,47 +623,78 @@ Jacon_print_node(Jacon_Node* node, int indent)
     }
 }
 
-Jacon_Error
-Jacon_tokenizer_init(Jacon_Tokenizer* tokenizer)
-{
-    tokenizer->tokens = (Jacon_Token*)calloc(
-        JACON_TOKENIZER_DEFAULT_CAPACITY, sizeof(Jacon_Token));
-    if (tokenizer->tokens == NULL) {
-        perror("Jacon_append_token array alloc error");
-        return JACON_ERR_MEMORY_ALLOCATION;
-    }
-    tokenizer->capacity = JACON_TOKENIZER_DEFAULT_CAPACITY;
-    tokenizer->count = 0;
-    return JACON_OK;
-}
-
 Jacon_Error
 Jacon_init_content(Jacon_content* content)
 {
     // int ret;
-    content->root = (Jacon_Node*)calloc(1, sizeof(Jacon_Node));
+    if (content->arena == NULL) {
+        content->arena = calloc(1, sizeof(Ju_Arena));
+        if (content->arena == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+        content->owns_arena = true;
+    }
+    content->root = (Jacon_Node*)Ju_calloc(content->arena, 1, sizeof(Jacon_Node));
     if (content->root == NULL) return JACON_ERR_MEMORY_ALLOCATION;
     // ret = Jacon_hm_create(&content->entries, 10);
     content->entries = (Jacon_HashMap){
-        .entries = calloc(10, sizeof(Jacon_HashMapEntry*)),
-        .size = 10
+        .entries = Ju_calloc(content->arena, 10, sizeof(Jacon_HashMapEntry*)),
+        .size = 10,
+        .arena = content->arena
     };
     // if (ret != JACON_OK) return ret;
     return JACON_OK;
 }
 
-void
-Jacon_free_tokenizer(Jacon_Tokenizer* tokenizer)
+/**
+ * Copy a node and its childs into copy, on the heap
+ */
+Jacon_Error
+Jacon_copy_node(Jacon_Node* copy, const Jacon_Node* node)
 {
-    for (size_t i = 0; i < tokenizer->count; i++)
-    {
-        if (tokenizer->tokens[i].type == JACON_TOKEN_STRING)
-            free(tokenizer->tokens[i].string_val);
+    *copy = (Jacon_Node){ .type = node->type, .value = node->value };
+    if (node->name != NULL) {
+        copy->name = strdup(node->name);
+        if (copy->name == NULL) return JACON_ERR_MEMORY_ALLOCATION;
     }
-    if (tokenizer->tokens) {
-        free(tokenizer->tokens);
-        tokenizer->tokens = NULL;
+
+    switch (node->type) {
+        case JACON_VALUE_STRING:
+            if (node->value.string_val != NULL) {
+                copy->value.string_val = strdup(node->value.string_val);
+                if (copy->value.string_val == NULL) {
+                    Jacon_free_node(copy);
+                    return JACON_ERR_MEMORY_ALLOCATION;
+                }
+            }
+            break;
+        case JACON_VALUE_ARRAY:
+        case JACON_VALUE_OBJECT:
+            if (node->child_count == 0) break;
+            copy->childs = calloc(node->child_count, sizeof(Jacon_Node));
+            if (copy->childs == NULL) {
+                Jacon_free_node(copy);
+                return JACON_ERR_MEMORY_ALLOCATION;
+            }
+            copy->child_capacity = node->child_count;
+            for (size_t i = 0; i < node->child_count; i++) {
+                Jacon_Error ret = Jacon_copy_node(&copy->childs[i], &node->childs[i]);
+                if (ret != JACON_OK) {
+                    Jacon_free_node(copy);
+                    return ret;
+                }
+                copy->child_count++;
+            }
+            break;
+        case JACON_VALUE_INT:
+        case JACON_VALUE_INT64:
+        case JACON_VALUE_UINT64:
+        case JACON_VALUE_FLOAT:
+        case JACON_VALUE_DOUBLE:
+        case JACON_VALUE_BOOLEAN:
+        case JACON_VALUE_NULL:
+            // Copied with the value
+            break;
     }
+    return JACON_OK;
 }
 
 Jacon_Node* 
@@ -671,58 +708,10 @@ Jacon_duplicate_node(const Jacon_Node* node)
     if (new_node == NULL) {
         return NULL;
     }
-
-    new_node->parent = node->parent;
-    new_node->name = node->name ? strdup(node->name) : NULL;
-    new_node->type = node->type;
-
-    switch (node->type) {
-        case JACON_VALUE_STRING:
-            new_node->value.string_val = node->value.string_val ? strdup(node->value.string_val) : NULL;
-            break;
-        case JACON_VALUE_INT:
-            new_node->value.int_val = node->value.int_val;
-            break;
-        case JACON_VALUE_FLOAT:
-            new_node->value.float_val = node->value.float_val;
-            break;
-        case JACON_VALUE_DOUBLE:
-            new_node->value.double_val = node->value.double_val;
-            break;
-        case JACON_VALUE_BOOLEAN:
-            new_node->value.bool_val = node->value.bool_val;
-            break;
-        case JACON_VALUE_NULL:
-            // No additional data to copy
-            break;
-        case JACON_VALUE_ARRAY:
-        case JACON_VALUE_OBJECT:
-            new_node->child_count = node->child_count;
-            new_node->child_capacity = node->child_capacity;
-            new_node->childs = calloc(new_node->child_capacity, sizeof(Jacon_Node*));
-            if (new_node->childs == NULL) {
-                free(new_node->name);
-                new_node->name = NULL;
-                free(new_node);
-                new_node = NULL;
-                return NULL;
-            }
-            for (size_t i = 0; i < node->child_count; i++) {
-                new_node->childs[i] = Jacon_duplicate_node(node->childs[i]);
-                if (new_node->childs[i] == NULL) {
-                    for (size_t j = 0; j < i; j++) {
-                        Jacon_free_node(new_node->childs[j]);
-                    }
-                    free(new_node->childs);
-                    free(new_node->name);
-                    free(new_node);
-                    return NULL;
-                }
-                new_node->childs[i]->parent = new_node;
-            }
-            break;
+    if (Jacon_copy_node(new_node, node) != JACON_OK) {
+        free(new_node);
+        return NULL;
     }
-
     return new_node;
 }
 
@@ -740,75 +729,54 @@ Jacon_free_node(Jacon_Node* node)
     if (node->type == JACON_VALUE_ARRAY || node->type == JACON_VALUE_OBJECT) {
         for (size_t i = 0; i < node->child_count; i++)
         {
-            Jacon_free_node(node->childs[i]);
-            node->childs[i] = NULL;
+            Jacon_free_node(&node->childs[i]);
         }
-        free(node->childs);
+        if (node->child_capacity > 0) free(node->childs);
         node->childs = NULL;
-        return;
+        node->child_count = 0;
+        node->child_capacity = 0;
     }
-    free(node);
-    node = NULL;
 }
 
+/**
+ * Append a child to a node whose childs array is allocated in arena
+ */
 Jacon_Error
-Jacon_append_token(Jacon_Tokenizer* tokenizer, Jacon_Token token)
+Jacon_arena_append_child(Ju_Arena* arena, Jacon_Node* node, const Jacon_Node* child)
 {
-    if (tokenizer == NULL) {
+    if (node == NULL || child == NULL) {
         return JACON_ERR_NULL_PARAM;
     }
-    if (tokenizer->tokens == NULL) {
-        tokenizer->tokens = (Jacon_Token*)calloc(
-            JACON_TOKENIZER_DEFAULT_CAPACITY, sizeof(Jacon_Token));
-        if (tokenizer->tokens == NULL) {
-            perror("Jacon_append_token array alloc error");
-            return JACON_ERR_MEMORY_ALLOCATION;
+    if (node->child_count >= node->child_capacity) {
+        size_t capacity = node->child_count * JACON_NODE_DEFAULT_RESIZE_FACTOR;
+        if (capacity < JACON_NODE_DEFAULT_CHILD_CAPACITY) capacity = JACON_NODE_DEFAULT_CHILD_CAPACITY;
+        Jacon_Node* tmp;
+        if (node->child_capacity == 0) {
+            // The node does not own its childs yet, they may be a range of a content's nodes
+            tmp = Ju_alloc(arena, capacity * sizeof(Jacon_Node));
+            if (tmp != NULL && node->child_count > 0) {
+                memcpy(tmp, node->childs, node->child_count * sizeof(Jacon_Node));
+            }
+        } else {
+            tmp = Ju_realloc(arena, node->childs,
+                node->child_capacity * sizeof(Jacon_Node), capacity * sizeof(Jacon_Node));
         }
-        tokenizer->capacity = JACON_TOKENIZER_DEFAULT_CAPACITY;
-    }
-    if (tokenizer->count >= tokenizer->capacity) {
-        size_t new_capacity = tokenizer->capacity * 2;
-        Jacon_Token* new_tokens = realloc(tokenizer->tokens, new_capacity * sizeof(Jacon_Token));
-        if (!new_tokens) {
+        if (tmp == NULL) {
+            perror("Jacon_append_node_child array alloc error");
             return JACON_ERR_MEMORY_ALLOCATION;
         }
-        tokenizer->tokens = new_tokens;
-        tokenizer->capacity = new_capacity;
+        node->childs = tmp;
+        node->child_capacity = capacity;
     }
 
-    tokenizer->tokens[tokenizer->count++] = token;
+    node->childs[node->child_count++] = *child;
     return JACON_OK;
 }
 
 Jacon_Error
 Jacon_append_child(Jacon_Node* node, Jacon_Node* child)
 {
-    if (node == NULL) {
-        return JACON_ERR_NULL_PARAM;
-    }
-    if (node->childs == NULL) {
-        node->childs = calloc(
-            JACON_NODE_DEFAULT_CHILD_CAPACITY, sizeof(Jacon_Node*));
-        if (node->childs == NULL) {
-            perror("Jacon_append_node_child array alloc error");
-            return JACON_ERR_MEMORY_ALLOCATION;
-        }
-        node->child_capacity = JACON_NODE_DEFAULT_CHILD_CAPACITY;
-    }
-    if (node->child_count == node->child_capacity) {
-        Jacon_Node** tmp = realloc(
-            node->childs, 
-            node->child_capacity * JACON_NODE_DEFAULT_RESIZE_FACTOR * sizeof(Jacon_Node*));
-        if (tmp == NULL) {
-            perror("Jacon_append_node_child array realloc error");
-            return JACON_ERR_MEMORY_ALLOCATION;
-        }
-        node->childs = tmp;
-        node->child_capacity *= JACON_NODE_DEFAULT_RESIZE_FACTOR;
-    }
-
-    node->childs[node->child_count++] = child;
-    return JACON_OK;
+    return Jacon_arena_append_child(NULL, node, child);
 }
 
 // Check if is a valid hex char
@@ -826,644 +794,454 @@ Jacon_is_whitespace(char c)
 }
 
 Jacon_Error
-Jacon_validate_string(const char* str)
+Jacon_parse_value(Jacon_Parser* parser, Jacon_Node* node);
+
+/**
+ * Move the cursor to the next structural character, or to the input's end once there are none
+ */
+char*
+Jacon_parser_advance(Jacon_Parser* parser)
 {
-    const char *ptr = str;
-    while (*ptr) {
-        if (*ptr == '\n'
-            || *ptr == '\t') return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
-        else if (*ptr == '\\') {
-            ptr++;
-            if (*ptr == 'u') {
-                for (int i = 1; i < 5; ++i) {
-                    if (!Jacon_is_hex_digit(*(ptr + i))) {
-                        return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
-                    }
-                }
-                ptr += 4; // Skip valid escape sequence
-            } else if (*ptr == '"' 
-                || *ptr == '\\' 
-                || *ptr == '/' 
-                || *ptr == 'b' 
-                || *ptr == 'f' 
-                || *ptr == 'n' 
-                || *ptr == 'r' 
-                || *ptr == 't') {
-                ptr++;
-            } else {
-                return JACON_ERR_INVALID_ESCAPE_SEQUENCE; // Invalid escape sequence
-            }
-        } else {
-            ptr++; // Move to the next character
-        }
-    }
-    return JACON_OK;
+    parser->cursor = parser->next < parser->structural_count
+        ? parser->input + parser->structurals[parser->next++]
+        : parser->input + parser->len;
+    return parser->cursor;
 }
 
-Jacon_Error 
-Jacon_parse_token(Jacon_Token* token, const char** str) 
+/**
+ * Whether a number or literal ending at end is not followed by more of its characters
+ *  Anything other than whitespace or the next structural character would be
+ */
+bool
+Jacon_parser_scalar_end(Jacon_Parser* parser, const char* end)
 {
-    switch (**str) {
-        case ',':
-            token->type = JACON_TOKEN_COMMA;
-            (*str)++;
-            break;
-        case ':':
-            token->type = JACON_TOKEN_COLON;
-            (*str)++;
-            break;
-        case '{':
-            token->type = JACON_TOKEN_OBJECT_START;
-            (*str)++;
-            break;
-        case '}':
-            token->type = JACON_TOKEN_OBJECT_END;
-            (*str)++;
-            break;
-        case '[':
-            token->type = JACON_TOKEN_ARRAY_START;
-            (*str)++;
-            break;
-        case ']':
-            token->type = JACON_TOKEN_ARRAY_END;
-            (*str)++;
-            break;
-        case '"':
-            (*str)++; // Move past the initial quote
-            const char* string_end = strchr(*str, '"');
-            if (string_end == NULL) return JACON_ERR_CHAR_NOT_FOUND;
-
-            // While the double quote is escaped, find the next one
-            while (string_end[-1] == '\\') {
-                string_end = strchr(string_end + 1, '"');
-                if (string_end == NULL) return JACON_ERR_CHAR_NOT_FOUND;
-            }
-            token->type = JACON_TOKEN_STRING;
-            size_t string_size = string_end - *str;
-            token->string_val = (char*)calloc(string_size + 1, sizeof(char));
-            if (token->string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-
-            strncpy(token->string_val, *str, string_size);
-            token->string_val[string_size] = '\0';
-
-            int ret = Jacon_validate_string(token->string_val);
-            if (ret != JACON_OK) {
-                free(token->string_val);
-                return ret;
-            }
-
-            *str = string_end + 1; // Move past the closing quote
-            break;
-        case('n'):
-            if (strncmp(*str, "null", 4) != 0) return JACON_ERR_INVALID_JSON;
-            token->type = JACON_TOKEN_NULL;
-            (*str) += 4;
-            break;
-        case('t'):
-            if (strncmp(*str, "true", 4) != 0) return JACON_ERR_INVALID_JSON;
-            token->type = JACON_TOKEN_BOOLEAN;
-            token->bool_val = true;
-            (*str) += 4;
-            break;
-        case('f'):
-            if (strncmp(*str, "false", 5) != 0) return JACON_ERR_INVALID_JSON;
-            token->type = JACON_TOKEN_BOOLEAN;
-            token->bool_val = false;
-            (*str) += 5;
-            break;
-        case('\0'):
-            return JACON_END_OF_INPUT;
-        default:
-            // Check if whitespace
-            if(Jacon_is_whitespace(**str)) {
-                (*str)++;
-                return Jacon_parse_token(token, str);
-            }
-            // Invalidate hex values
-            else if (**str == '0' && (*str)[1] == 'x') return JACON_ERR_INVALID_JSON;
-            // Invalidate leading 0
-            else if (**str == '0' && (*str)[1] >= '0' && (*str)[1] <= '9') return JACON_ERR_INVALID_JSON;
-            // Check if char is a number or a negative number
-            else if ((**str >= '0' && **str <= '9') 
-                || (**str == '-' && (((*str)[1] >= '0' && (*str)[1] <= '9')))) {
-                if (**str == '-' && (*str)[1] == '0' && ((*str)[2] != '.' || !isdigit((*str)[2]))) {
-                    const char* p = *str + 1;
-                    while (*p == '0') p++;
-                    if (isdigit(*p)) return JACON_ERR_INVALID_JSON;
-                }
-                char* dot = strchr(*str, '.');
-                if (dot) {
-                    // Check for leading 0, if real, check if distance between last '0' and '.' > 1
-                    char* last_zero = strrchr(*str, '0');
-                    if (last_zero && dot - last_zero > 1) return JACON_ERR_INVALID_JSON;
-                    // Check if there is a dot and if so if there are numbers after
-                    char* after_dot = dot + 1;
-                    if (!isdigit(*after_dot)) return JACON_ERR_INVALID_JSON;
-                }
-                
-                char *endptr;
-                // Parse an int
-                int ival = (int)strtol(*str, &endptr, 10);
-                if ((isspace(*endptr) || *endptr == ',' || *endptr == ']' || *endptr == '}' || *endptr == '\0')
-                    && ival >= INT_MIN && ival <= INT_MAX) {
-                    token->int_val = ival;
-                    token->type = JACON_TOKEN_INT;
-                    *str = endptr;
-                    break;
-                }
-
-                double dval = strtod(*str, &endptr);
-    
-                // Ensure the number is followed by valid JSON characters
-                if (!isspace(*endptr) && *endptr != ',' && *endptr != ']' && *endptr != '}' && *endptr != '\0') {
-                    return JACON_ERR_INVALID_JSON;
-                }
-                
-                float fval = (float)dval;
-                double recast = (double)fval;
-                if (dval > recast) {
-                    token->type = JACON_TOKEN_DOUBLE;
-                    token->double_val = dval;
-                } else {
-                    token->type = JACON_TOKEN_FLOAT;
-                    token->float_val = fval;
-                }
+    if (Jacon_is_whitespace(*end)) return true;
+    return parser->next < parser->structural_count
+        ? end == parser->input + parser->structurals[parser->next]
+        : *end == '\0';
+}
 
-                *str = endptr;
+/**
+ * Validate the escape sequences of the characters of a string, between its quotes
+ *  Control characters were rejected by the index, only escapes are left to check
+ */
+Jacon_Error
+Jacon_check_escapes(const char* start, const char* end)
+{
+    const char* ptr = memchr(start, '\\', end - start);
+    while (ptr != NULL) {
+        ptr++;
+        if (*ptr == 'u') {
+            for (int i = 1; i < 5; ++i) {
+                if (!Jacon_is_hex_digit(ptr[i])) return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
             }
-            else return JACON_ERR_INVALID_JSON;
+            ptr += 5;
+        } else if (strchr("\"\\/bfnrt", *ptr) != NULL) {
+            ptr++;
+        } else {
+            return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+        }
+        ptr = memchr(ptr, '\\', end - ptr);
     }
     return JACON_OK;
 }
 
-Jacon_Error 
-Jacon_tokenize(Jacon_Tokenizer* tokenizer, const char* str) 
+/**
+ * Parse a string at the cursor, its escape sequences are validated and kept as is
+ *  The string is terminated in place of its closing quote and points into the input
+ */
+Jacon_Error
+Jacon_parse_string(Jacon_Parser* parser, char** str)
 {
-    Jacon_Error ret;
-
-    while (*str) {
-        Jacon_Token token = {0};
-        ret = Jacon_parse_token(&token, &str);
-        if (ret == JACON_END_OF_INPUT) return JACON_OK;
-        if (ret != JACON_OK) return ret;
-        ret = Jacon_append_token(tokenizer, token);
-        if (ret != JACON_OK) return ret;
-    }
+    char* start = parser->cursor + 1; // Move past the initial quote
+    // Nothing in a string is structural, the index guarantees the closing quote comes right after
+    // It is not read, a lazy content may have had the string terminated by an earlier lookup
+    char* end = Jacon_parser_advance(parser);
+    Jacon_Error ret = Jacon_check_escapes(start, end);
+    if (ret != JACON_OK) return ret;
 
+    *end = '\0';
+    *str = start;
     return JACON_OK;
 }
 
+/**
+ * Parse a number at the cursor into an int, int64 or uint64, or a float when it fits one exactly, or a double
+ */
 Jacon_Error
-Jacon_current_token(Jacon_Token* token, Jacon_Tokenizer* tokenizer, size_t current_index)
+Jacon_parse_number(Jacon_Parser* parser, Jacon_Node* node)
 {
-    if (current_index >= tokenizer->count) return JACON_ERR_INDEX_OUT_OF_BOUND;
-    *token = tokenizer->tokens[current_index];
+    Jacon_Number number;
+    const char* ptr = Jacon_scan_number(parser->cursor, &number);
+    if (ptr == NULL || !Jacon_parser_scalar_end(parser, ptr)) return JACON_ERR_INVALID_JSON;
+    Jacon_number_value(parser->cursor, &number, &node->type, &node->value);
     return JACON_OK;
 }
 
-Jacon_Error
-Jacon_consume_token(Jacon_Token* token, Jacon_Tokenizer* tokenizer, size_t* current_index)
+/**
+ * Whether an object already has a member of that name
+ *  Small objects are searched, the names of larger ones are put in a set
+ */
+bool
+Jacon_parser_has_name(Jacon_Parser* parser, Jacon_Node* members, size_t count, Jacon_HashSet* names, const char* name)
 {
-    if (*current_index >= tokenizer->count) return JACON_ERR_INDEX_OUT_OF_BOUND;
-    *token = tokenizer->tokens[*current_index + 1];
-    *current_index += 1;
-    return JACON_OK;
+    if (count < JACON_PARSER_NAMES_SET_MIN) {
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(members[i].name, name) == 0) return true;
+        }
+        return false;
+    }
+    if (names->entries == NULL) {
+        names->arena = parser->arena;
+        names->capacity = count * JACON_MAP_RESIZE_FACTOR;
+        names->entries = Ju_calloc(parser->arena, names->capacity, sizeof(Jacon_HashSetEntry*));
+        if (names->entries == NULL) return false;
+        for (size_t i = 0; i < count; i++) Jacon_hs_put(names, members[i].name);
+    }
+    return Jacon_hs_exists(names, name);
 }
 
+/**
+ * Push a parsed value as a child of the innermost open object or array
+ */
 Jacon_Error
-Jacon_validate_object(Jacon_Tokenizer* tokenizer, size_t* index);
-Jacon_Error
-Jacon_validate_array(Jacon_Tokenizer* tokenizer, size_t* index);
+Jacon_parser_push(Jacon_Parser* parser, const Jacon_Node* node)
+{
+    if (parser->stack_count == parser->stack_capacity) {
+        size_t capacity = parser->stack_capacity > 0
+            ? parser->stack_capacity * JACON_NODE_DEFAULT_RESIZE_FACTOR
+            : JACON_PARSER_DEFAULT_CAPACITY;
+        Jacon_Node* tmp = realloc(parser->stack, capacity * sizeof(Jacon_Node));
+        if (tmp == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+        parser->stack = tmp;
+        parser->stack_capacity = capacity;
+    }
+    parser->stack[parser->stack_count++] = *node;
+    return JACON_OK;
+}
 
+/**
+ * Move the childs pushed since base out of the stack, next to each other in the nodes
+ */
 Jacon_Error
-Jacon_validate_array(Jacon_Tokenizer* tokenizer, size_t* index)
-{
-    int ret = JACON_OK;
-    Jacon_Token* current = NULL;
-    bool last_value = false;
-    
-    if (*index < tokenizer->count) {
-        current = &tokenizer->tokens[*index];
-    } else {
-        return JACON_ERR_INVALID_JSON;
-    }
-
-    while (current->type != JACON_TOKEN_ARRAY_END) {
-        current = &tokenizer->tokens[*index];
-        switch (current->type) {
-            case JACON_TOKEN_ARRAY_START:
-                (*index)++;
-                ret = Jacon_validate_array(tokenizer, index);
-                if (ret != JACON_OK) return ret;
-                last_value = true;
-                break;
-            case JACON_TOKEN_OBJECT_START:
-                (*index)++;
-                ret = Jacon_validate_object(tokenizer, index);
-                if (ret != JACON_OK) return ret;
-                last_value = true;
-                break;
-            case JACON_TOKEN_COMMA:
-                if (!last_value) {
-                    return JACON_ERR_INVALID_JSON;
-                }
-                else {
-                    last_value = false;
-                    (*index)++;    
-                }
-                break;
-            case JACON_TOKEN_ARRAY_END:
-                return JACON_ERR_UNREACHABLE_STATEMENT;
-            case JACON_TOKEN_OBJECT_END:
-            case JACON_TOKEN_COLON:
-                return JACON_ERR_INVALID_JSON;
-            case JACON_TOKEN_STRING:
-            case JACON_TOKEN_INT:
-            case JACON_TOKEN_DOUBLE:
-            case JACON_TOKEN_FLOAT:
-            case JACON_TOKEN_BOOLEAN:
-            case JACON_TOKEN_NULL:
-            default:
-                if(last_value) return JACON_ERR_INVALID_JSON;
-                last_value = true;
-                (*index)++;
-                break;
-        }
-        if (*index >= tokenizer->count) {
-            return JACON_ERR_INVALID_JSON;
-        }
-        current = &tokenizer->tokens[*index];
-    }
-    (*index)++;
+Jacon_parser_close(Jacon_Parser* parser, Jacon_Node* node, size_t base)
+{
+    size_t count = parser->stack_count - base;
+    if (count == 0) return JACON_OK;
+    if (parser->node_count + count > parser->node_capacity) return JACON_ERR_INVALID_JSON;
+    node->childs = parser->nodes + parser->node_count;
+    node->child_count = count;
+    memcpy(node->childs, parser->stack + base, count * sizeof(Jacon_Node));
+    parser->node_count += count;
+    parser->stack_count = base;
     return JACON_OK;
 }
 
+/**
+ * Parse the members of an object, the cursor is on its opening brace
+ */
 Jacon_Error
-Jacon_validate_object(Jacon_Tokenizer* tokenizer, size_t* index)
+Jacon_parse_object(Jacon_Parser* parser, Jacon_Node* node)
 {
-    int ret = JACON_OK;
-    if (*index >= tokenizer->count) return JACON_ERR_INVALID_JSON;
-    if (*index >= tokenizer->count) {
-        return JACON_ERR_INVALID_JSON;
-    }
-    Jacon_Token* current = &tokenizer->tokens[*index];
-    Jacon_Token* last = NULL;
-    Jacon_HashSet names_set = (Jacon_HashSet){
-        .entries = calloc(10, sizeof(Jacon_HashSetEntry*)),
-        .capacity = 10
-    };
-    if (names_set.entries == NULL) {
-        return JACON_ERR_MEMORY_ALLOCATION;
-    }
-    bool last_value = false;
-    while (current->type != JACON_TOKEN_OBJECT_END) {
-        current = &tokenizer->tokens[*index];
-        switch (current->type) {
-            case JACON_TOKEN_ARRAY_START:
-                if (last == NULL || last->type != JACON_TOKEN_COLON)
-                    return JACON_ERR_INVALID_JSON;
+    node->type = JACON_VALUE_OBJECT;
+    if (*Jacon_parser_advance(parser) == '}') return JACON_OK;
 
-                (*index)++;
-                ret = Jacon_validate_array(tokenizer, index);
-                if (ret != JACON_OK) return ret;
-                last_value = true;
-                break;
-            case JACON_TOKEN_OBJECT_START:
-                if (last == NULL || last->type != JACON_TOKEN_COLON)
-                    return JACON_ERR_INVALID_JSON;
+    Jacon_Error ret = JACON_OK;
+    Jacon_HashSet names = {0};
+    size_t base = parser->stack_count;
+    while (true) {
+        if (*parser->cursor != '"') {
+            ret = JACON_ERR_INVALID_JSON;
+            break;
+        }
+        char* name;
+        ret = Jacon_parse_string(parser, &name);
+        if (ret != JACON_OK) break;
+        if (Jacon_parser_has_name(parser, parser->stack + base, parser->stack_count - base, &names, name)) {
+            ret = JACON_ERR_DUPLICATE_NAME;
+            break;
+        }
 
-                (*index)++;
-                ret = Jacon_validate_object(tokenizer, index);
-                if (ret != JACON_OK) return ret;
-                last_value = true;
-                break;
-            case JACON_TOKEN_COMMA:
-                if (last == NULL) return JACON_ERR_INVALID_JSON;
-                else if (!last_value) {
-                    return JACON_ERR_INVALID_JSON;
-                }
-                last = &tokenizer->tokens[*index];
-                (*index)++;
-                last_value = false;
-                break;
-            case JACON_TOKEN_ARRAY_END:
-                return JACON_ERR_INVALID_JSON;
-            case JACON_TOKEN_OBJECT_END:
-                return JACON_ERR_UNREACHABLE_STATEMENT;
-            case JACON_TOKEN_COLON:
-                if (last == NULL) return JACON_ERR_INVALID_JSON;
-                if (last->type != JACON_TOKEN_STRING) return JACON_ERR_INVALID_JSON;
-                last = &tokenizer->tokens[*index];
-                (*index)++;
-                break;
-            case JACON_TOKEN_STRING:
-                if (last == NULL) {
-                    if (Jacon_hs_exists(&names_set, tokenizer->tokens[*index].string_val)) {
-                        Jacon_hs_free(&names_set);
-                        return JACON_ERR_DUPLICATE_NAME;
-                    }
-                    Jacon_hs_put(&names_set, tokenizer->tokens[*index].string_val);
-                    last = &tokenizer->tokens[*index];
-                    (*index)++;
-                }
-                else if (last->type == JACON_TOKEN_COMMA) {
-                    if (Jacon_hs_exists(&names_set, tokenizer->tokens[*index].string_val)) {
-                        Jacon_hs_free(&names_set);
-                        return JACON_ERR_DUPLICATE_NAME;
-                    }
-                    Jacon_hs_put(&names_set, tokenizer->tokens[*index].string_val);
-                    last = &tokenizer->tokens[*index];
-                    (*index)++;
-                    last_value = true;
-                }
-                else if (last->type == JACON_TOKEN_COLON ) {
-                    last = &tokenizer->tokens[*index];
-                    (*index)++;
-                    last_value = true;
-                }
-                else {
-                    return JACON_ERR_UNREACHABLE_STATEMENT;
-                }
-                break;
-            case JACON_TOKEN_INT:
-            case JACON_TOKEN_DOUBLE:
-            case JACON_TOKEN_FLOAT:
-            case JACON_TOKEN_BOOLEAN:
-            case JACON_TOKEN_NULL:
-                if (last == NULL || last->type != JACON_TOKEN_COLON)
-                    return JACON_ERR_INVALID_JSON;
-                last = &tokenizer->tokens[*index];
-                (*index)++;
-                last_value = true;
-                break;
-            default:
-                return JACON_ERR_UNREACHABLE_STATEMENT;
+        if (*Jacon_parser_advance(parser) != ':') {
+            ret = JACON_ERR_INVALID_JSON;
+            break;
         }
-        if (*index >= tokenizer->count) {
-            return JACON_ERR_INVALID_JSON;
+        Jacon_parser_advance(parser);
+
+        Jacon_Node child = { .name = name };
+        ret = Jacon_parse_value(parser, &child);
+        if (ret != JACON_OK) break;
+        ret = Jacon_parser_push(parser, &child);
+        if (ret != JACON_OK) break;
+        if (names.entries != NULL) Jacon_hs_put(&names, name);
+
+        char next = *Jacon_parser_advance(parser);
+        if (next == '}') {
+            ret = Jacon_parser_close(parser, node, base);
+            break;
+        }
+        if (next != ',') {
+            ret = JACON_ERR_INVALID_JSON;
+            break;
         }
-        current = &tokenizer->tokens[*index];
+        Jacon_parser_advance(parser);
     }
-    (*index)++;
-    return JACON_OK;
+    Jacon_hs_free(&names);
+    return ret;
 }
 
+/**
+ * Parse the elements of an array, the cursor is on its opening bracket
+ */
 Jacon_Error
-Jacon_validate_value(Jacon_Token token)
+Jacon_parse_array(Jacon_Parser* parser, Jacon_Node* node)
 {
-    switch (token.type) {
-        case JACON_TOKEN_STRING:
-        case JACON_TOKEN_INT:
-        case JACON_TOKEN_DOUBLE:
-        case JACON_TOKEN_FLOAT:
-        case JACON_TOKEN_BOOLEAN:
-        case JACON_TOKEN_NULL:
-            return JACON_OK;
-        case JACON_TOKEN_ARRAY_START:
-        case JACON_TOKEN_ARRAY_END:
-        case JACON_TOKEN_OBJECT_START:
-        case JACON_TOKEN_OBJECT_END:
-        case JACON_TOKEN_COMMA:
-        case JACON_TOKEN_COLON:
-            return JACON_ERR_INVALID_JSON;
+    node->type = JACON_VALUE_ARRAY;
+    if (*Jacon_parser_advance(parser) == ']') return JACON_OK;
+
+    size_t base = parser->stack_count;
+    while (true) {
+        Jacon_Node child = {0};
+        Jacon_Error ret = Jacon_parse_value(parser, &child);
+        if (ret != JACON_OK) return ret;
+        ret = Jacon_parser_push(parser, &child);
+        if (ret != JACON_OK) return ret;
+
+        char next = *Jacon_parser_advance(parser);
+        if (next == ']') return Jacon_parser_close(parser, node, base);
+        if (next != ',') return JACON_ERR_INVALID_JSON;
+        Jacon_parser_advance(parser);
     }
-    return JACON_ERR_UNREACHABLE_STATEMENT;
 }
 
 /**
- * Validate a Jacon tokenizer result
+ * Parse the value the cursor is on into node
+ *  The cursor is left on the value's last structural character
  */
 Jacon_Error
-Jacon_validate_input(Jacon_Tokenizer* tokenizer)
+Jacon_parse_value(Jacon_Parser* parser, Jacon_Node* node)
 {
-    int ret = JACON_OK;
-
-    if (tokenizer->count == 1) {
-        ret = Jacon_validate_value(tokenizer->tokens[0]);
-        return ret;
-    }
-
-    Jacon_Token* current = NULL;
-    size_t index = 0;
-    current = &tokenizer->tokens[index];
-    switch (current->type) {
-        case JACON_TOKEN_ARRAY_START:
-            index++;
-            ret = Jacon_validate_array(tokenizer, &index);
-            if (ret != JACON_OK) return ret;
+    Jacon_Error ret = JACON_OK;
+    switch (*parser->cursor) {
+        case '{':
+        case '[':
+            if (parser->depth == JACON_PARSER_MAX_DEPTH) return JACON_ERR_INVALID_JSON;
+            parser->depth++;
+            ret = *parser->cursor == '{'
+                ? Jacon_parse_object(parser, node)
+                : Jacon_parse_array(parser, node);
+            parser->depth--;
             break;
-        case JACON_TOKEN_OBJECT_START:
-            index++;
-            ret = Jacon_validate_object(tokenizer, &index);
-            if (ret != JACON_OK) return ret;
+        case '"':
+            node->type = JACON_VALUE_STRING;
+            ret = Jacon_parse_string(parser, &node->value.string_val);
+            break;
+        case 't':
+            if (strncmp(parser->cursor, "true", 4) != 0
+                || !Jacon_parser_scalar_end(parser, parser->cursor + 4)) return JACON_ERR_INVALID_JSON;
+            node->type = JACON_VALUE_BOOLEAN;
+            node->value.bool_val = true;
+            break;
+        case 'f':
+            if (strncmp(parser->cursor, "false", 5) != 0
+                || !Jacon_parser_scalar_end(parser, parser->cursor + 5)) return JACON_ERR_INVALID_JSON;
+            node->type = JACON_VALUE_BOOLEAN;
+            node->value.bool_val = false;
             break;
-        case JACON_TOKEN_STRING:
-        case JACON_TOKEN_INT:
-        case JACON_TOKEN_DOUBLE:
-        case JACON_TOKEN_FLOAT:
-        case JACON_TOKEN_BOOLEAN:
-        case JACON_TOKEN_NULL:
-        case JACON_TOKEN_ARRAY_END:
-        case JACON_TOKEN_OBJECT_END:
-        case JACON_TOKEN_COMMA:
-        case JACON_TOKEN_COLON:
+        case 'n':
+            if (strncmp(parser->cursor, "null", 4) != 0
+                || !Jacon_parser_scalar_end(parser, parser->cursor + 4)) return JACON_ERR_INVALID_JSON;
+            node->type = JACON_VALUE_NULL;
+            break;
+        case '\0':
+            return JACON_ERR_INVALID_JSON;
         default:
-            return JACON_ERR_UNREACHABLE_STATEMENT;
+            ret = Jacon_parse_number(parser, node);
+            break;
     }
-    if (index < tokenizer->count) return JACON_ERR_INVALID_JSON;
+    return ret;
+}
 
-    return JACON_OK;
+/**
+ * Validate a string at the cursor without terminating it, the cursor is left on its closing quote
+ */
+Jacon_Error
+Jacon_parser_validate_string(Jacon_Parser* parser)
+{
+    char* start = parser->cursor + 1;
+    return Jacon_check_escapes(start, Jacon_parser_advance(parser));
 }
 
+/**
+ * Validate the name of a member at the cursor and its colon, the cursor is left on its value
+ */
 Jacon_Error
-Jacon_parse_node(Jacon_Node* node, Jacon_Tokenizer* tokenizer, size_t* current_index)
+Jacon_parser_validate_name(Jacon_Parser* parser)
 {
-    int ret = JACON_OK;
-    Jacon_Token current_token;
-    ret = Jacon_current_token(&current_token, tokenizer, *current_index);
+    if (*parser->cursor != '"') return JACON_ERR_INVALID_JSON;
+    Jacon_Error ret = Jacon_parser_validate_string(parser);
     if (ret != JACON_OK) return ret;
-    switch (current_token.type) {
-        case JACON_TOKEN_OBJECT_START:
-            node->type = JACON_VALUE_OBJECT;
-
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            while (current_token.type != JACON_TOKEN_OBJECT_END) {
-                Jacon_Node* child = calloc(1, sizeof(Jacon_Node));
-                if (child == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-                child->parent = node;
-                ret = Jacon_parse_node(child, tokenizer, current_index);
-                if (ret != JACON_OK) {
-                    Jacon_free_node(child);
-                    return ret;
-                }
+    if (*Jacon_parser_advance(parser) != ':') return JACON_ERR_INVALID_JSON;
+    Jacon_parser_advance(parser);
+    return JACON_OK;
+}
 
-                ret = Jacon_append_child(node, child);
-                if (ret != JACON_OK) return ret;
-                ret = Jacon_current_token(&current_token, tokenizer, *current_index);
-                if (ret != JACON_OK) return ret;
-            }
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
+/**
+ * Validate the syntax of a number or literal at the cursor, without converting it
+ */
+Jacon_Error
+Jacon_parser_validate_scalar(Jacon_Parser* parser)
+{
+    const char* ptr = parser->cursor;
+    const char* end;
+    Jacon_Number number;
+    switch (*ptr) {
+        case 't':
+            end = strncmp(ptr, "true", 4) == 0 ? ptr + 4 : NULL;
             break;
+        case 'f':
+            end = strncmp(ptr, "false", 5) == 0 ? ptr + 5 : NULL;
+            break;
+        case 'n':
+            end = strncmp(ptr, "null", 4) == 0 ? ptr + 4 : NULL;
+            break;
+        default:
+            end = Jacon_scan_number(ptr, &number);
+            break;
+    }
+    if (end == NULL || !Jacon_parser_scalar_end(parser, end)) return JACON_ERR_INVALID_JSON;
+    return JACON_OK;
+}
 
-        case JACON_TOKEN_ARRAY_START:
-            node->type = JACON_VALUE_ARRAY;
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            while (current_token.type != JACON_TOKEN_ARRAY_END) {
-                Jacon_Node* child = calloc(1, sizeof(Jacon_Node));
-                if (child == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-                child->parent = node;
-                ret = Jacon_parse_node(child, tokenizer, current_index);
-                if (ret != JACON_OK) {
-                    Jacon_free_node(child);
-                    return ret;
+/**
+ * Validate the whole input from its first structural character, without building anything
+ *  Goes from a structural character to the next, the open objects and arrays kept
+ *  by the index of their opening character. The index of the character closing each
+ *  is recorded in the ends. Names are not checked for duplicates.
+ */
+Jacon_Error
+Jacon_parser_validate(Jacon_Parser* parser)
+{
+    uint32_t opened[JACON_PARSER_MAX_DEPTH];
+    size_t depth = 0;
+    Jacon_Error ret = JACON_OK;
+    char* c = Jacon_parser_advance(parser);
+    while (true) {
+        // A value starts at c
+        switch (*c) {
+            case '{':
+            case '[': {
+                if (depth == JACON_PARSER_MAX_DEPTH) return JACON_ERR_INVALID_JSON;
+                bool object = *c == '{';
+                opened[depth++] = (uint32_t)(parser->next - 1);
+                c = Jacon_parser_advance(parser);
+                if (*c == (object ? '}' : ']')) {
+                    parser->ends[opened[--depth]] = (uint32_t)(parser->next - 1);
+                    break;
                 }
-
-                ret = Jacon_append_child(node, child);
+                if (object) {
+                    ret = Jacon_parser_validate_name(parser);
+                    if (ret != JACON_OK) return ret;
+                    c = parser->cursor;
+                }
+                continue;
+            }
+            case '"':
+                ret = Jacon_parser_validate_string(parser);
                 if (ret != JACON_OK) return ret;
-                ret = Jacon_current_token(&current_token, tokenizer, *current_index);
+                break;
+            case '\0':
+                return JACON_ERR_INVALID_JSON;
+            default:
+                ret = Jacon_parser_validate_scalar(parser);
                 if (ret != JACON_OK) return ret;
-            }
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            break;
-
-        case JACON_TOKEN_STRING:
-            if (node->type == JACON_VALUE_STRING) {
-                node->value.string_val = strdup(current_token.string_val);
-                if (node->value.string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+                break;
+        }
 
-                ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-                if (ret != JACON_OK) return ret;
+        // The value is complete, close the objects and arrays ending after it
+        while (true) {
+            if (depth == 0) {
+                return parser->next < parser->structural_count ? JACON_ERR_INVALID_JSON : JACON_OK;
             }
-            else if (node->parent != NULL && node->parent->type == JACON_VALUE_ARRAY) {
-                node->type = JACON_VALUE_STRING;
-                node->value.string_val = strdup(current_token.string_val);
-                if (node->value.string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-
-                ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-                if (ret != JACON_OK) return ret;
+            bool object = parser->input[parser->structurals[opened[depth - 1]]] == '{';
+            c = Jacon_parser_advance(parser);
+            if (*c == (object ? '}' : ']')) {
+                parser->ends[opened[--depth]] = (uint32_t)(parser->next - 1);
+                continue;
             }
-            else {
-                node->type = JACON_VALUE_STRING;
-                node->name = strdup(current_token.string_val);
-                if (node->name == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-
-                ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-                if (ret != JACON_OK) return ret;
-
-                ret = Jacon_parse_node(node, tokenizer, current_index);
+            if (*c != ',') return JACON_ERR_INVALID_JSON;
+            c = Jacon_parser_advance(parser);
+            if (object) {
+                ret = Jacon_parser_validate_name(parser);
                 if (ret != JACON_OK) return ret;
+                c = parser->cursor;
             }
             break;
-
-        case JACON_TOKEN_BOOLEAN:
-            node->type = JACON_VALUE_BOOLEAN;
-            node->value.bool_val = current_token.bool_val;
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            break;
-
-        case JACON_TOKEN_INT:
-            node->type = JACON_VALUE_INT;
-            node->value.int_val = current_token.int_val;
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            break;
-
-        case JACON_TOKEN_FLOAT:
-            node->type = JACON_VALUE_FLOAT;
-            node->value.float_val = current_token.float_val;
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            break;
-
-        case JACON_TOKEN_DOUBLE:
-            node->type = JACON_VALUE_DOUBLE;
-            node->value.double_val = current_token.double_val;
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            break;
-
-        case JACON_TOKEN_NULL:
-            node->type = JACON_VALUE_NULL;
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            break;
-            
-        case JACON_TOKEN_COLON:
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            return Jacon_parse_node(node, tokenizer, current_index);
-        case JACON_TOKEN_COMMA:
-            ret = Jacon_consume_token(&current_token, tokenizer, current_index);
-            if (ret != JACON_OK) return ret;
-            return Jacon_parse_node(node, tokenizer, current_index);
-        case JACON_TOKEN_OBJECT_END:
-        case JACON_TOKEN_ARRAY_END:
-            // Both of these cases should never happen
-            // We skip this token when we are done parsing an array / object
-        default:
-            return JACON_ERR_UNREACHABLE_STATEMENT;
+        }
     }
-    return JACON_OK;
 }
 
-Jacon_Error
-Jacon_parse_value(Jacon_Node* root, Jacon_Token token)
+/**
+ * Move the cursor from the start of a validated value to its last structural character
+ *  Objects and arrays are jumped over to their end, strings to their closing quote
+ */
+void
+Jacon_parser_skip(Jacon_Parser* parser)
 {
-    switch (token.type) {
-        case JACON_TOKEN_STRING:
-            root->type = JACON_VALUE_STRING;
-            root->value.string_val = strdup(token.string_val);
-            if (root->value.string_val == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-            break;
-        case JACON_TOKEN_INT:
-            root->type = JACON_VALUE_INT;
-            root->value.int_val = token.int_val;
-            break;
-        case JACON_TOKEN_DOUBLE:
-            root->type = JACON_VALUE_DOUBLE;
-            root->value.double_val = token.double_val;
-            break;
-        case JACON_TOKEN_FLOAT:
-            root->type = JACON_VALUE_FLOAT;
-            root->value.float_val = token.float_val;
-            break;
-        case JACON_TOKEN_BOOLEAN:
-            root->type = JACON_VALUE_BOOLEAN;
-            root->value.bool_val = token.bool_val;
-            break;
-        case JACON_TOKEN_NULL:
-            root->type = JACON_VALUE_NULL;
-            break;
-        case JACON_TOKEN_ARRAY_START:
-        case JACON_TOKEN_ARRAY_END:
-        case JACON_TOKEN_OBJECT_START:
-        case JACON_TOKEN_OBJECT_END:
-        case JACON_TOKEN_COLON:
-        case JACON_TOKEN_COMMA:
+    switch (*parser->cursor) {
+        case '"':
+            Jacon_parser_advance(parser);
+            return;
+        case '{':
+        case '[':
+            parser->next = parser->ends[parser->next - 1];
+            Jacon_parser_advance(parser);
+            return;
         default:
-            return JACON_ERR_UNREACHABLE_STATEMENT;
+            return;
     }
-    return JACON_OK;
 }
 
 /**
- * Parse a Jacon tokenizer content into a queryable C variable
+ * Move the cursor of a validated input from its root to the value at a path
+ *  Every member of the objects along the path is gone through, to find
+ *  duplicates of its names. Names are compared as written, escapes included.
+ *  name is set to the name of the value, terminated in place, NULL for the root.
  */
 Jacon_Error
-Jacon_parse_tokens(Jacon_Node* root, Jacon_Tokenizer* tokenizer)
-{
-    int ret = JACON_OK;
-    if (tokenizer->count == 1) 
-        return Jacon_parse_value(root, tokenizer->tokens[0]);
-    size_t current_index = 0;
-    while(current_index < tokenizer->count) {
-        ret = Jacon_parse_node(root, tokenizer, &current_index);
-        if (ret != JACON_OK && ret != JACON_NO_MORE_TOKENS) return ret;
+Jacon_parser_find(Jacon_Parser* parser, const char* path, char** name)
+{
+    parser->next = 0;
+    Jacon_parser_advance(parser);
+    *name = NULL;
+    while (*path != '\0') {
+        const char* dot = strchr(path, '.');
+        size_t len = dot != NULL ? (size_t)(dot - path) : strlen(path);
+        if (*parser->cursor != '{') return JACON_ERR_KEY_NOT_FOUND;
+
+        // Structural character following the value of the member, 0 if none has the name
+        size_t found = 0;
+        char* c = Jacon_parser_advance(parser);
+        while (*c != '}') {
+            char* member = c + 1;
+            c = Jacon_parser_advance(parser);
+            bool match = (size_t)(c - member) == len && memcmp(member, path, len) == 0;
+            if (match) {
+                if (found != 0) return JACON_ERR_DUPLICATE_NAME;
+                *c = '\0';
+                *name = member;
+            }
+            Jacon_parser_advance(parser); // Colon
+            Jacon_parser_advance(parser);
+            if (match) found = parser->next;
+            Jacon_parser_skip(parser);
+            c = Jacon_parser_advance(parser);
+            if (*c == ',') c = Jacon_parser_advance(parser);
+        }
+        if (found == 0) return JACON_ERR_KEY_NOT_FOUND;
+        parser->next = found;
+        parser->cursor = parser->input + parser->structurals[found - 1];
+        path += dot != NULL ? len + 1 : len;
     }
     return JACON_OK;
 }
@@ -1481,7 +1259,7 @@ Jacon_add_node_to_map(Jacon_HashMap* map, Jacon_Node* node, const char* path_to_
 
     int ret;
 
-    Jacon_StringBuilder builder = {0};
+    Jacon_StringBuilder builder = { .arena = map->arena };
     ret = Jacon_str_append_null(&builder, path_to_node);
     if (ret != JACON_OK) {
         Jacon_str_free(&builder);
@@ -1499,8 +1277,9 @@ Jacon_add_node_to_map(Jacon_HashMap* map, Jacon_Node* node, const char* path_to_
     // Single value won't change
     // Full object is subject to change if it appears to be needed
     if (node->type != JACON_VALUE_OBJECT) {
-        Jacon_Node* duped = Jacon_duplicate_node(node);
-        Jacon_hm_put(map, builder.string, duped);
+        // An arena map does not own its values, it can point to the tree's nodes
+        Jacon_Node* value = map->arena != NULL ? node : Jacon_duplicate_node(node);
+        Jacon_hm_put(map, builder.string, value);
         Jacon_str_free(&builder);
         return JACON_OK;
     }
@@ -1517,7 +1296,7 @@ Jacon_add_node_to_map(Jacon_HashMap* map, Jacon_Node* node, const char* path_to_
 
     for (size_t index = 0; index < node->child_count; index++)
     {
-        ret = Jacon_add_node_to_map(map, node->childs[index], builder.string);
+        ret = Jacon_add_node_to_map(map, &node->childs[index], builder.string);
         if (ret != JACON_OK) {
             Jacon_str_free(&builder);
             return ret;
@@ -1539,41 +1318,89 @@ Jacon_free_content(Jacon_content* content)
     if (content == NULL)
         return JACON_ERR_NULL_PARAM;
 
-    if (content->root != NULL) {
-        Jacon_free_node(content->root);
-        free(content->root);
-        content->root = NULL;
-    }
+    // Nodes, strings and entries all live in the arena
+    content->root = NULL;
+    content->nodes = NULL;
+    content->node_count = 0;
+    content->input = NULL;
+    free(content->structurals);
+    content->structurals = NULL;
+    content->structural_count = 0;
+    content->ends = NULL;
     Jacon_hm_free(&content->entries);
+    if (content->owns_arena) {
+        Ju_arena_reset(content->arena);
+        free(content->arena);
+        content->arena = NULL;
+        content->owns_arena = false;
+    }
     return JACON_OK;
 }
 
+/**
+ * Get the value at a path of a content, the root for an empty path
+ *  The entries are searched, or the value built into node from a lazy content.
+ *  Named objects have no entry, a lazy content doesn't find them either
+ */
 Jacon_Error
-Jacon_get_value_by_name(Jacon_content* content, const char* name, Jacon_ValueType type, void* value)
+Jacon_content_value(Jacon_content* content, const char* path, Jacon_Node* node, Jacon_Node** value)
 {
-    if (content == NULL || name == NULL || (value == NULL && type != JACON_VALUE_STRING)) {
-        return JACON_ERR_NULL_PARAM;
-    }
-    Jacon_Node* ptr = (Jacon_Node*)Jacon_hm_get(&content->entries, name);
-    if (ptr == NULL) {
-        return JACON_ERR_KEY_NOT_FOUND;
+    if (content->structurals != NULL) {
+        *value = node;
+        Jacon_Error ret = Jacon_find(content, path, node);
+        if (ret == JACON_OK && *path != '\0' && node->type == JACON_VALUE_OBJECT) return JACON_ERR_KEY_NOT_FOUND;
+        return ret;
     }
+    *value = *path == '\0' ? content->root : (Jacon_Node*)Jacon_hm_get(&content->entries, path);
+    return *value != NULL ? JACON_OK : JACON_ERR_KEY_NOT_FOUND;
+}
+
+/**
+ * Copy the value of node into value if it holds a type
+ *  Ints widen to int64 and floats to double, non-negative ints and int64s
+ *  are converted to uint64. Any other mismatch is JACON_ERR_INVALID_VALUE_TYPE
+ */
+Jacon_Error
+Jacon_node_get_value(const Jacon_Node* node, Jacon_ValueType type, void* value)
+{
     switch (type) {
         case JACON_VALUE_STRING:
-            *(char**)value = strdup(ptr->value.string_val);
+            if (node->type != JACON_VALUE_STRING) return JACON_ERR_INVALID_VALUE_TYPE;
+            *(char**)value = strdup(node->value.string_val);
             if (*(char**)value == NULL) return JACON_ERR_MEMORY_ALLOCATION;
             break;
         case JACON_VALUE_INT:
-            *(int*)value = ptr->value.int_val;
+            if (node->type != JACON_VALUE_INT) return JACON_ERR_INVALID_VALUE_TYPE;
+            *(int*)value = node->value.int_val;
+            break;
+        case JACON_VALUE_INT64:
+            if (node->type == JACON_VALUE_INT) *(int64_t*)value = node->value.int_val;
+            else if (node->type == JACON_VALUE_INT64) *(int64_t*)value = node->value.int64_val;
+            else return JACON_ERR_INVALID_VALUE_TYPE;
+            break;
+        case JACON_VALUE_UINT64:
+            if (node->type == JACON_VALUE_INT && node->value.int_val >= 0) {
+                *(uint64_t*)value = (uint64_t)node->value.int_val;
+            } else if (node->type == JACON_VALUE_INT64 && node->value.int64_val >= 0) {
+                *(uint64_t*)value = (uint64_t)node->value.int64_val;
+            } else if (node->type == JACON_VALUE_UINT64) {
+                *(uint64_t*)value = node->value.uint64_val;
+            } else {
+                return JACON_ERR_INVALID_VALUE_TYPE;
+            }
             break;
         case JACON_VALUE_FLOAT:
-            *(float*)value = ptr->value.float_val;
+            if (node->type != JACON_VALUE_FLOAT) return JACON_ERR_INVALID_VALUE_TYPE;
+            *(float*)value = node->value.float_val;
             break;
         case JACON_VALUE_DOUBLE:
-            *(double*)value = ptr->value.double_val;
+            if (node->type == JACON_VALUE_FLOAT) *(double*)value = node->value.float_val;
+            else if (node->type == JACON_VALUE_DOUBLE) *(double*)value = node->value.double_val;
+            else return JACON_ERR_INVALID_VALUE_TYPE;
             break;
         case JACON_VALUE_BOOLEAN:
-            *(bool*)value = ptr->value.bool_val;
+            if (node->type != JACON_VALUE_BOOLEAN) return JACON_ERR_INVALID_VALUE_TYPE;
+            *(bool*)value = node->value.bool_val;
             break;
         case JACON_VALUE_NULL:
         case JACON_VALUE_ARRAY:
@@ -1584,6 +1411,19 @@ Jacon_get_value_by_name(Jacon_content* content, const char* name, Jacon_ValueTyp
     return JACON_OK;
 }
 
+Jacon_Error
+Jacon_get_value_by_name(Jacon_content* content, const char* name, Jacon_ValueType type, void* value)
+{
+    if (content == NULL || name == NULL || value == NULL) {
+        return JACON_ERR_NULL_PARAM;
+    }
+    Jacon_Node node;
+    Jacon_Node* ptr;
+    Jacon_Error ret = Jacon_content_value(content, name, &node, &ptr);
+    if (ret != JACON_OK) return ret;
+    return Jacon_node_get_value(ptr, type, value);
+}
+
 Jacon_Error
 Jacon_get_string_by_name(Jacon_content* content, const char* name, char** value)
 {
@@ -1596,6 +1436,18 @@ Jacon_get_int_by_name(Jacon_content* content, const char* name, int* value)
     return Jacon_get_value_by_name(content, name, JACON_VALUE_INT, value);
 }
 
+Jacon_Error
+Jacon_get_int64_by_name(Jacon_content* content, const char* name, int64_t* value)
+{
+    return Jacon_get_value_by_name(content, name, JACON_VALUE_INT64, value);
+}
+
+Jacon_Error
+Jacon_get_uint64_by_name(Jacon_content* content, const char* name, uint64_t* value)
+{
+    return Jacon_get_value_by_name(content, name, JACON_VALUE_UINT64, value);
+}
+
 Jacon_Error
 Jacon_get_float_by_name(Jacon_content* content, const char* name, float* value)
 {
@@ -1622,32 +1474,13 @@ Jacon_get_bool_by_name(Jacon_content* content, const char* name, bool* value)
 Jacon_Error
 Jacon_get_value(Jacon_content* content, Jacon_ValueType type, void* value)
 {
-    if (content == NULL || (value == NULL && type != JACON_VALUE_STRING)) 
+    if (content == NULL || value == NULL)
         return JACON_ERR_NULL_PARAM;
-    switch (type) {
-        case JACON_VALUE_STRING:
-            *(char**)value = strdup(content->root->value.string_val);
-            if (value == NULL) return JACON_ERR_MEMORY_ALLOCATION;
-            break;
-        case JACON_VALUE_INT:
-            *(int*)value = content->root->value.int_val;
-            break;
-        case JACON_VALUE_FLOAT:
-            *(float*)value = content->root->value.float_val;
-            break;
-        case JACON_VALUE_DOUBLE:
-            *(double*)value = content->root->value.double_val;
-            break;
-        case JACON_VALUE_BOOLEAN:
-            *(bool*)value = content->root->value.bool_val;
-            break;
-        case JACON_VALUE_NULL:
-        case JACON_VALUE_ARRAY:
-        case JACON_VALUE_OBJECT:
-        default:
-            return JACON_ERR_INVALID_VALUE_TYPE;
-    }
-    return JACON_OK;
+    Jacon_Node node;
+    Jacon_Node* root;
+    Jacon_Error ret = Jacon_content_value(content, "", &node, &root);
+    if (ret != JACON_OK) return ret;
+    return Jacon_node_get_value(root, type, value);
 }
 
 /**
@@ -1668,6 +1501,24 @@ Jacon_get_int(Jacon_content* content, int* value)
     return Jacon_get_value(content, JACON_VALUE_INT, value);
 }
 
+/**
+ * Get single int64 value, an int is widened
+ */
+Jacon_Error
+Jacon_get_int64(Jacon_content* content, int64_t* value)
+{
+    return Jacon_get_value(content, JACON_VALUE_INT64, value);
+}
+
+/**
+ * Get single uint64 value, a non-negative int or int64 is converted
+ */
+Jacon_Error
+Jacon_get_uint64(Jacon_content* content, uint64_t* value)
+{
+    return Jacon_get_value(content, JACON_VALUE_UINT64, value);
+}
+
 /**
  * Get single float value
  */
@@ -1678,7 +1529,7 @@ Jacon_get_float(Jacon_content* content, float* value)
 }
 
 /**
- * Get single double value
+ * Get single double value, a float is widened
  */
 Jacon_Error
 Jacon_get_double(Jacon_content* content, double* value)
@@ -1698,8 +1549,9 @@ Jacon_get_bool(Jacon_content* content, bool* value)
 bool
 Jacon_exist_by_name(Jacon_content* content, const char* name, Jacon_ValueType type)
 {
-    void* value = Jacon_hm_get(&content->entries, name);
-    return ((Jacon_Node*)value)->type == type;
+    Jacon_Node node;
+    Jacon_Node* value;
+    return Jacon_content_value(content, name, &node, &value) == JACON_OK && value->type == type;
 }
 
 /**
@@ -1720,6 +1572,24 @@ Jacon_exist_int_by_name(Jacon_content* content, const char* name)
     return Jacon_exist_by_name(content, name, JACON_VALUE_INT);
 }
 
+/**
+ * Verify the existence of a single int64 value
+ */
+Jacon_Error
+Jacon_exist_int64_by_name(Jacon_content* content, const char* name)
+{
+    return Jacon_exist_by_name(content, name, JACON_VALUE_INT64);
+}
+
+/**
+ * Verify the existence of a single uint64 value
+ */
+Jacon_Error
+Jacon_exist_uint64_by_name(Jacon_content* content, const char* name)
+{
+    return Jacon_exist_by_name(content, name, JACON_VALUE_UINT64);
+}
+
 /**
  * Verify the existence of a single float value
  */
@@ -1762,7 +1632,9 @@ Jacon_exist_null_by_name(Jacon_content* content, const char* name)
 bool
 Jacon_exist(Jacon_content* content, Jacon_ValueType type)
 {
-    return content->root->type == type;
+    Jacon_Node node;
+    Jacon_Node* root;
+    return Jacon_content_value(content, "", &node, &root) == JACON_OK && root->type == type;
 }
 
 /**
@@ -1783,6 +1655,24 @@ Jacon_exist_int(Jacon_content* content)
     return Jacon_exist(content, JACON_VALUE_INT);
 }
 
+/**
+ * Verify the existence of a single int64 value
+ */
+Jacon_Error
+Jacon_exist_int64(Jacon_content* content)
+{
+    return Jacon_exist(content, JACON_VALUE_INT64);
+}
+
+/**
+ * Verify the existence of a single uint64 value
+ */
+Jacon_Error
+Jacon_exist_uint64(Jacon_content* content)
+{
+    return Jacon_exist(content, JACON_VALUE_UINT64);
+}
+
 /**
  * Verify the existence of a single float value
  */
@@ -1851,7 +1741,7 @@ Jacon_node_as_str(Jacon_Node* node, Jacon_StringBuilder* builder, size_t offset,
             if (node->child_count > 0) Jacon_str_append_null(builder, "\n");
             index = 0;
             while (index < node->child_count) {
-                ret = Jacon_node_as_str(node->childs[index], builder, offset + 1, true);
+                ret = Jacon_node_as_str(&node->childs[index], builder, offset + 1, true);
                 if (ret != JACON_OK) return ret;
                 if (++index < node->child_count) Jacon_str_append_null(builder, ",\n");
             }
@@ -1871,7 +1761,7 @@ Jacon_node_as_str(Jacon_Node* node, Jacon_StringBuilder* builder, size_t offset,
 
             index = 0;
             while (index < node->child_count) {
-                ret = Jacon_node_as_str(node->childs[index], builder, offset + 1, false);
+                ret = Jacon_node_as_str(&node->childs[index], builder, offset + 1, false);
                 if (ret != JACON_OK) return ret;
                 if (++index < node->child_count) Jacon_str_append_null(builder, ", ");
             }
@@ -1887,13 +1777,12 @@ Jacon_node_as_str(Jacon_Node* node, Jacon_StringBuilder* builder, size_t offset,
             Jacon_str_append_fmt_null(builder, "\"%s\"", node->value.string_val);
             break;
         case JACON_VALUE_INT:
-            Jacon_str_append_fmt_null(builder, "%d", node->value.int_val);
-            break;
+        case JACON_VALUE_INT64:
+        case JACON_VALUE_UINT64:
         case JACON_VALUE_FLOAT:
-            Jacon_str_append_fmt_null(builder, "%f", node->value.float_val);
-            break;
         case JACON_VALUE_DOUBLE:
-            Jacon_str_append_fmt_null(builder, "%f", node->value.double_val);
+            ret = Jacon_str_append_number(builder, node->type, node->value);
+            if (ret != JACON_OK) return ret;
             break;
         case JACON_VALUE_BOOLEAN:
             Jacon_str_append_fmt_null(builder, "%s", 
@@ -1923,7 +1812,7 @@ Jacon_node_as_str_unformatted(Jacon_Node* node, Jacon_StringBuilder* builder)
             Jacon_str_append_null(builder, "{");
             index = 0;
             while (index < node->child_count) {
-                ret = Jacon_node_as_str_unformatted(node->childs[index], builder);
+                ret = Jacon_node_as_str_unformatted(&node->childs[index], builder);
                 if (ret != JACON_OK) return ret;
                 if (++index < node->child_count) Jacon_str_append_null(builder, ",");
             }
@@ -1933,7 +1822,7 @@ Jacon_node_as_str_unformatted(Jacon_Node* node, Jacon_StringBuilder* builder)
             Jacon_str_append_null(builder, "[");
             index = 0;
             while (index < node->child_count) {
-                ret = Jacon_node_as_str_unformatted(node->childs[index], builder);
+                ret = Jacon_node_as_str_unformatted(&node->childs[index], builder);
                 if (ret != JACON_OK) return ret;
                 if (++index < node->child_count) Jacon_str_append_null(builder, ",");
             }
@@ -1944,13 +1833,12 @@ Jacon_node_as_str_unformatted(Jacon_Node* node, Jacon_StringBuilder* builder)
             Jacon_str_append_fmt_null(builder, "\"%s\"", node->value.string_val);
             break;
         case JACON_VALUE_INT:
-            Jacon_str_append_fmt_null(builder, "%d", node->value.int_val);
-            break;
+        case JACON_VALUE_INT64:
+        case JACON_VALUE_UINT64:
         case JACON_VALUE_FLOAT:
-            Jacon_str_append_fmt_null(builder, "%f", node->value.float_val);
-            break;
         case JACON_VALUE_DOUBLE:
-            Jacon_str_append_fmt_null(builder, "%f", node->value.double_val);
+            ret = Jacon_str_append_number(builder, node->type, node->value);
+            if (ret != JACON_OK) return ret;
             break;
         case JACON_VALUE_BOOLEAN:
             Jacon_str_append_fmt_null(builder, "%s", 
@@ -1966,74 +1854,223 @@ Jacon_node_as_str_unformatted(Jacon_Node* node, Jacon_StringBuilder* builder)
 }
 
 Jacon_Error
-Jacon_serialize(Jacon_Node* node, char** str)
+Jacon_serialize(Jacon_Node* node, Ju_Arena* arena, char** str)
 {
     if (node == NULL) return JACON_OK;
     int ret;
-    Jacon_StringBuilder builder = {0};
+    Jacon_StringBuilder builder = { .arena = arena };
     ret = Jacon_node_as_str(node, &builder, 0, true);
     if (ret != JACON_OK) {
         Jacon_str_free(&builder);
         return ret;
     }
-    *str = strdup(builder.string);
-    Jacon_str_free(&builder);
+    // The builder's string is handed over as is
+    *str = builder.string;
     return JACON_OK;
 }
 
 Jacon_Error
-Jacon_serialize_unformatted(Jacon_Node* node, char** str)
+Jacon_serialize_unformatted(Jacon_Node* node, Ju_Arena* arena, char** str)
 {
     if (node == NULL) return JACON_OK;
     int ret;
-    Jacon_StringBuilder builder = {0};
+    Jacon_StringBuilder builder = { .arena = arena };
     ret = Jacon_node_as_str_unformatted(node, &builder);
     if (ret != JACON_OK) {
         Jacon_str_free(&builder);
         return ret;
     }
-    *str = strdup(builder.string);
-    Jacon_str_free(&builder);
+    // The builder's string is handed over as is
+    *str = builder.string;
     return JACON_OK;
 }
 
+/**
+ * Count the values of a valid input from its structural characters, the root aside
+ *  Every object, array, number, literal and string is one, but the strings naming members
+ */
+size_t
+Jacon_parser_count_values(const char* input, const uint32_t* structurals, size_t count)
+{
+    size_t values = 0;
+    size_t quotes = 0;
+    size_t names = 0;
+    for (size_t i = 0; i < count; i++) {
+        switch (input[structurals[i]]) {
+            // The closing quote of a string a lazy content has terminated in place
+            case '\0':
+            case '"':
+                quotes++;
+                break;
+            case ':':
+                names++;
+                break;
+            case ',':
+            case '}':
+            case ']':
+                break;
+            default:
+                values++;
+                break;
+        }
+    }
+    values += quotes / 2;
+    return values > names ? values - names - 1 : 0;
+}
+
 Jacon_Error
 Jacon_deserialize(Jacon_content* content, const char* str)
 {
     if (content == NULL || str == NULL) return JACON_ERR_NULL_PARAM;
-    size_t len = strlen(str);
-    if (len == 0) return JACON_ERR_EMPTY_INPUT;
 
-    Jacon_Tokenizer tokenizer;
-    Jacon_tokenizer_init(&tokenizer);
-    Jacon_Error ret;
-    ret = Jacon_tokenize(&tokenizer, str);
+    size_t len = strlen(str);
+    Jacon_Index index = {0};
+    Jacon_Error ret = Jacon_index_build(&index, str, len);
+    if (ret == JACON_OK && index.count == 0) ret = JACON_ERR_EMPTY_INPUT;
     if (ret != JACON_OK) {
-        Jacon_free_tokenizer(&tokenizer);
+        Jacon_index_free(&index);
         return ret;
     }
-    
-    // Invalidate empty input
-    if (tokenizer.count == 0) {
-        Jacon_free_tokenizer(&tokenizer);
-        return JACON_ERR_EMPTY_INPUT;
+
+    // Strings are terminated in place, the input is left untouched
+    char* input = Ju_strndup(content->arena, str, len);
+    if (input == NULL) {
+        Jacon_index_free(&index);
+        return JACON_ERR_MEMORY_ALLOCATION;
+    }
+    Jacon_Parser parser = {
+        .input = input,
+        .len = len,
+        .structurals = index.offsets,
+        .structural_count = index.count,
+        .arena = content->arena,
+        .node_capacity = Jacon_parser_count_values(str, index.offsets, index.count)
+    };
+    if (parser.node_capacity > 0) {
+        parser.nodes = Ju_alloc(content->arena, parser.node_capacity * sizeof(Jacon_Node));
+        if (parser.nodes == NULL) ret = JACON_ERR_MEMORY_ALLOCATION;
+    }
+    if (ret == JACON_OK) {
+        Jacon_parser_advance(&parser);
+        ret = Jacon_parse_value(&parser, content->root);
     }
+    if (ret == JACON_OK && parser.next < parser.structural_count) ret = JACON_ERR_INVALID_JSON;
+    free(parser.stack);
+    Jacon_index_free(&index);
+    if (ret != JACON_OK) {
+        // Leave an empty root, as if nothing was parsed
+        *content->root = (Jacon_Node){0};
+        return ret;
+    }
+
+    content->nodes = parser.nodes;
+    content->node_count = parser.node_count;
+    return Jacon_build_content(content);
+}
+
+Jacon_Error
+Jacon_deserialize_lazy(Jacon_content* content, const char* str)
+{
+    if (content == NULL || str == NULL) return JACON_ERR_NULL_PARAM;
 
-    ret = Jacon_validate_input(&tokenizer);
+    size_t len = strlen(str);
+    Jacon_Index index = {0};
+    Jacon_Error ret = Jacon_index_build(&index, str, len);
+    if (ret == JACON_OK && index.count == 0) ret = JACON_ERR_EMPTY_INPUT;
     if (ret != JACON_OK) {
-        Jacon_free_tokenizer(&tokenizer);
+        Jacon_index_free(&index);
         return ret;
     }
 
-    ret = Jacon_parse_tokens(content->root, &tokenizer);
+    // Looked up strings are terminated in place, the input is left untouched
+    char* input = Ju_strndup(content->arena, str, len);
+    if (input == NULL) {
+        Jacon_index_free(&index);
+        return JACON_ERR_MEMORY_ALLOCATION;
+    }
+    Jacon_Parser parser = {
+        .input = input,
+        .len = len,
+        .structurals = index.offsets,
+        .structural_count = index.count,
+        .ends = Ju_alloc(content->arena, index.count * sizeof(uint32_t)),
+    };
+    ret = parser.ends != NULL ? Jacon_parser_validate(&parser) : JACON_ERR_MEMORY_ALLOCATION;
     if (ret != JACON_OK) {
-        Jacon_free_tokenizer(&tokenizer);
+        Jacon_index_free(&index);
         return ret;
     }
-    Jacon_free_tokenizer(&tokenizer);
 
-    ret = Jacon_build_content(content);
+    // The content takes over the offsets, freed with it
+    content->input = input;
+    content->len = len;
+    content->structurals = index.offsets;
+    content->structural_count = index.count;
+    content->ends = parser.ends;
+    return JACON_OK;
+}
+
+/**
+ * Find the node at a path of a parsed content, the root for an empty path
+ *  Goes down the tree a name at a time, NULL if nothing is there
+ */
+Jacon_Node*
+Jacon_find_node(Jacon_Node* node, const char* path)
+{
+    while (*path != '\0') {
+        const char* dot = strchr(path, '.');
+        size_t len = dot != NULL ? (size_t)(dot - path) : strlen(path);
+        if (node->type != JACON_VALUE_OBJECT) return NULL;
+        Jacon_Node* child = NULL;
+        for (size_t i = 0; i < node->child_count && child == NULL; i++) {
+            if (strncmp(node->childs[i].name, path, len) == 0 && node->childs[i].name[len] == '\0') {
+                child = &node->childs[i];
+            }
+        }
+        if (child == NULL) return NULL;
+        node = child;
+        path += dot != NULL ? len + 1 : len;
+    }
+    return node;
+}
+
+Jacon_Error
+Jacon_find(Jacon_content* content, const char* path, Jacon_Node* node)
+{
+    if (content == NULL || path == NULL || node == NULL) return JACON_ERR_NULL_PARAM;
+    if (content->structurals == NULL) {
+        Jacon_Node* found = content->root != NULL ? Jacon_find_node(content->root, path) : NULL;
+        if (found == NULL) return JACON_ERR_KEY_NOT_FOUND;
+        *node = *found;
+        return JACON_OK;
+    }
+
+    Jacon_Parser parser = {
+        .input = content->input,
+        .len = content->len,
+        .structurals = content->structurals,
+        .structural_count = content->structural_count,
+        .ends = content->ends,
+        .arena = content->arena,
+    };
+    char* name;
+    Jacon_Error ret = Jacon_parser_find(&parser, path, &name);
     if (ret != JACON_OK) return ret;
 
-    return JACON_OK;
-}
\ No newline at end of file
+    // Size the nodes for the value's structural characters alone, then build it from its start
+    size_t start = parser.next;
+    Jacon_parser_skip(&parser);
+    parser.node_capacity = Jacon_parser_count_values(parser.input,
+        parser.structurals + start - 1, parser.next - start + 1);
+    if (parser.node_capacity > 0) {
+        parser.nodes = Ju_alloc(content->arena, parser.node_capacity * sizeof(Jacon_Node));
+        if (parser.nodes == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+    }
+    parser.next = start;
+    parser.cursor = parser.input + parser.structurals[start - 1];
+    *node = (Jacon_Node){ .name = name };
+    ret = Jacon_parse_value(&parser, node);
+    free(parser.stack);
+    if (ret != JACON_OK) *node = (Jacon_Node){0};
+    return ret;
+}
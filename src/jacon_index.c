@@ -0,0 +1,246 @@
+#include "jacon_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JACON_INDEX_X86
+#endif
+
+Jacon_Index_Masks (*Jacon_index_block)(const char* block) = NULL;
+
+#define JACON_INDEX_ONES 0x0101010101010101ULL
+#define JACON_INDEX_LOW7 0x7F7F7F7F7F7F7F7FULL
+#define JACON_INDEX_EVEN_BITS 0x5555555555555555ULL
+
+/**
+ * Get one bit per byte of word equal to c, byte i giving bit i
+ */
+uint64_t
+Jacon_index_word(uint64_t word, char c)
+{
+    uint64_t x = word ^ (JACON_INDEX_ONES * (unsigned char)c);
+    // High bit of every zero byte, exact unlike the usual haszero trick
+    uint64_t zero = ~(((x & JACON_INDEX_LOW7) + JACON_INDEX_LOW7) | x | JACON_INDEX_LOW7);
+    // Gather the 8 high bits into the top byte
+    return ((zero >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+/**
+ * Get one bit per byte of word below 0x20
+ */
+uint64_t
+Jacon_index_word_control(uint64_t word)
+{
+    // Bytes with none of the bits 5 to 7 set
+    uint64_t high = word & (JACON_INDEX_ONES * 0xE0);
+    uint64_t zero = ~(((high & JACON_INDEX_LOW7) + JACON_INDEX_LOW7) | high | JACON_INDEX_LOW7);
+    return ((zero >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+Jacon_Index_Masks
+Jacon_index_block_scalar(const char* block)
+{
+    // SWAR, 8 bytes at a time for CPUs without a SIMD classifier
+    Jacon_Index_Masks masks = {0};
+    for (int i = 0; i < JACON_INDEX_BLOCK_SIZE / 8; i++) {
+        uint64_t word;
+        memcpy(&word, block + i * 8, sizeof(word));
+        masks.quote |= Jacon_index_word(word, '"') << (i * 8);
+        masks.backslash |= Jacon_index_word(word, '\\') << (i * 8);
+        masks.op |= (Jacon_index_word(word, '{') | Jacon_index_word(word, '}')
+            | Jacon_index_word(word, '[') | Jacon_index_word(word, ']')
+            | Jacon_index_word(word, ':') | Jacon_index_word(word, ',')) << (i * 8);
+        masks.whitespace |= (Jacon_index_word(word, ' ') | Jacon_index_word(word, '\t')
+            | Jacon_index_word(word, '\n') | Jacon_index_word(word, '\r')) << (i * 8);
+        masks.control |= Jacon_index_word_control(word) << (i * 8);
+    }
+    return masks;
+}
+
+#ifdef JACON_INDEX_X86
+
+__attribute__((target("sse4.2")))
+Jacon_Index_Masks
+Jacon_index_block_sse42(const char* block)
+{
+    // pcmpestrm matches every byte against a whole set of characters at once
+    const __m128i ops = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i spaces = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1F);
+    Jacon_Index_Masks masks = {0};
+    for (int i = 0; i < JACON_INDEX_BLOCK_SIZE / 16; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(block + i * 16));
+        __m128i op = _mm_cmpestrm(ops, 6, chunk, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        __m128i whitespace = _mm_cmpestrm(spaces, 4, chunk, 16,
+            _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        // Unsigned c <= 0x1F, as min(c, 0x1F) == c
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, control_max), chunk);
+        masks.op |= (uint64_t)(uint16_t)_mm_cvtsi128_si32(op) << (i * 16);
+        masks.whitespace |= (uint64_t)(uint16_t)_mm_cvtsi128_si32(whitespace) << (i * 16);
+        masks.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << (i * 16);
+        masks.backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << (i * 16);
+        masks.control |= (uint64_t)(uint16_t)_mm_movemask_epi8(control) << (i * 16);
+    }
+    return masks;
+}
+
+__attribute__((target("avx2")))
+Jacon_Index_Masks
+Jacon_index_block_avx2(const char* block)
+{
+    // Nibble lookups classify every character in two shuffles, simdjson style:
+    // a character is in a class when its low and high nibble entries share a bit.
+    //  0x01: '\t' '\n' '\r' | 0x02: ' ' | 0x04: ',' | 0x08: ':' | 0x10: '[' ']' '{' '}'
+    const __m256i low_nibbles = _mm256_setr_epi8(
+        0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x09, 0x10, 0x04, 0x11, 0, 0,
+        0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x09, 0x10, 0x04, 0x11, 0, 0);
+    const __m256i high_nibbles = _mm256_setr_epi8(
+        0x01, 0, 0x06, 0x08, 0, 0x10, 0, 0x10, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x01, 0, 0x06, 0x08, 0, 0x10, 0, 0x10, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i op_bits = _mm256_set1_epi8(0x1C);
+    const __m256i whitespace_bits = _mm256_set1_epi8(0x03);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control_max = _mm256_set1_epi8(0x1F);
+    const __m256i zero = _mm256_setzero_si256();
+    Jacon_Index_Masks masks = {0};
+    for (int i = 0; i < JACON_INDEX_BLOCK_SIZE / 32; i++) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(block + i * 32));
+        __m256i low = _mm256_shuffle_epi8(low_nibbles, _mm256_and_si256(chunk, nibble));
+        // Bytes over 0x7F shift a high nibble of 8 or more, whose table entries are 0
+        __m256i high = _mm256_shuffle_epi8(high_nibbles, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+        __m256i classes = _mm256_and_si256(low, high);
+        __m256i op = _mm256_cmpgt_epi8(_mm256_and_si256(classes, op_bits), zero);
+        __m256i whitespace = _mm256_cmpgt_epi8(_mm256_and_si256(classes, whitespace_bits), zero);
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control_max), chunk);
+        masks.op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << (i * 32);
+        masks.whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(whitespace) << (i * 32);
+        masks.quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)) << (i * 32);
+        masks.backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)) << (i * 32);
+        masks.control |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << (i * 32);
+    }
+    return masks;
+}
+
+#else
+
+Jacon_Index_Masks
+Jacon_index_block_sse42(const char* block)
+{
+    return Jacon_index_block_scalar(block);
+}
+
+Jacon_Index_Masks
+Jacon_index_block_avx2(const char* block)
+{
+    return Jacon_index_block_scalar(block);
+}
+
+#endif // JACON_INDEX_X86
+
+const char*
+Jacon_index_init(void)
+{
+#ifdef JACON_INDEX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        Jacon_index_block = Jacon_index_block_avx2;
+        return "avx2";
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        Jacon_index_block = Jacon_index_block_sse42;
+        return "sse4.2";
+    }
+#endif
+    Jacon_index_block = Jacon_index_block_scalar;
+    return "scalar";
+}
+
+/**
+ * Get the structural characters of a classified block, updating the state carried to the next
+ */
+uint64_t
+Jacon_indexer_next(Jacon_Indexer* indexer, Jacon_Index_Masks masks)
+{
+    // Characters preceded by an odd run of backslashes are escaped,
+    // the runs starting on odd bits are told apart from the even ones by an add carry
+    uint64_t backslash = masks.backslash & ~indexer->escaped;
+    uint64_t follows_escape = backslash << 1 | indexer->escaped;
+    uint64_t odd_starts = backslash & ~JACON_INDEX_EVEN_BITS & ~follows_escape;
+    uint64_t even_starts;
+    indexer->escaped = __builtin_add_overflow(odd_starts, backslash, &even_starts);
+    uint64_t escaped = (JACON_INDEX_EVEN_BITS ^ (even_starts << 1)) & follows_escape;
+
+    // Strings span from an unescaped quote to the character before the next one
+    uint64_t quote = masks.quote & ~escaped;
+    uint64_t in_string = quote;
+    in_string ^= in_string << 1;
+    in_string ^= in_string << 2;
+    in_string ^= in_string << 4;
+    in_string ^= in_string << 8;
+    in_string ^= in_string << 16;
+    in_string ^= in_string << 32;
+    in_string ^= indexer->in_string;
+    indexer->in_string = (uint64_t)((int64_t)in_string >> 63);
+    indexer->control |= masks.control & in_string;
+
+    // Numbers and literals are runs of any other characters, their first one is structural
+    uint64_t scalar = ~(masks.op | masks.whitespace | quote | in_string);
+    uint64_t scalar_start = scalar & ~(scalar << 1 | indexer->scalar);
+    indexer->scalar = scalar >> 63;
+
+    return (masks.op & ~in_string) | quote | scalar_start;
+}
+
+Jacon_Error
+Jacon_index_build(Jacon_Index* index, const char* input, size_t len)
+{
+    if (Jacon_index_block == NULL) Jacon_index_init();
+    if (len >= UINT32_MAX) return JACON_ERR_INVALID_SIZE;
+
+    index->count = 0;
+    Jacon_Indexer indexer = {0};
+    for (size_t offset = 0; offset < len; offset += JACON_INDEX_BLOCK_SIZE) {
+        // A block adds at most a structural per character
+        if (index->capacity - index->count < JACON_INDEX_BLOCK_SIZE) {
+            size_t capacity = index->capacity > 0 ? index->capacity * 2 : len / 8 + JACON_INDEX_BLOCK_SIZE;
+            uint32_t* tmp = realloc(index->offsets, capacity * sizeof(uint32_t));
+            if (tmp == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+            index->offsets = tmp;
+            index->capacity = capacity;
+        }
+
+        Jacon_Index_Masks masks;
+        if (len - offset >= JACON_INDEX_BLOCK_SIZE) {
+            masks = Jacon_index_block(input + offset);
+        } else {
+            // The tail is padded with whitespace, which is never structural
+            char tail[JACON_INDEX_BLOCK_SIZE];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, input + offset, len - offset);
+            masks = Jacon_index_block(tail);
+        }
+
+        uint64_t structurals = Jacon_indexer_next(&indexer, masks);
+        while (structurals != 0) {
+            index->offsets[index->count++] = (uint32_t)(offset + __builtin_ctzll(structurals));
+            structurals &= structurals - 1;
+        }
+    }
+
+    if (indexer.in_string) return JACON_ERR_CHAR_NOT_FOUND;
+    if (indexer.control) return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+    return JACON_OK;
+}
+
+void
+Jacon_index_free(Jacon_Index* index)
+{
+    free(index->offsets);
+    *index = (Jacon_Index){0};
+}
@@ -0,0 +1,341 @@
+#include "jacon_stream.h"
+#include "jacon_number.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+void
+Jacon_stream_init(Jacon_Stream* stream, Jacon_Event_Handler handler, void* context)
+{
+    *stream = (Jacon_Stream){
+        .handler = handler,
+        .context = context,
+        .max_token = JACON_STREAM_DEFAULT_MAX_TOKEN,
+        .state = JACON_STREAM_VALUE,
+        .first = true,
+    };
+}
+
+void
+Jacon_stream_free(Jacon_Stream* stream)
+{
+    free(stream->token);
+    stream->token = NULL;
+    stream->token_count = 0;
+    stream->token_capacity = 0;
+}
+
+/**
+ * Send an event to the handler
+ */
+Jacon_Error
+Jacon_stream_emit(Jacon_Stream* stream, Jacon_EventType type, Jacon_ValueType value_type, Jacon_Value value)
+{
+    if (stream->handler == NULL) return JACON_OK;
+    Jacon_Event event = {
+        .type = type,
+        .value_type = value_type,
+        .value = value,
+        .depth = stream->depth,
+    };
+    return stream->handler(stream->context, &event) < 0 ? JACON_ERR_HANDLER_FAILED : JACON_OK;
+}
+
+/**
+ * Append characters to the token being read, keeping room for its terminator
+ */
+Jacon_Error
+Jacon_stream_append(Jacon_Stream* stream, const char* chars, size_t count)
+{
+    // Room for the terminator is always kept once the buffer exists
+    if (count == 0 && stream->token != NULL) return JACON_OK;
+    if (stream->token_count + count > stream->max_token) return JACON_ERR_INVALID_SIZE;
+    if (stream->token_count + count + 1 > stream->token_capacity) {
+        size_t capacity = stream->token_capacity > 0
+            ? stream->token_capacity
+            : JACON_STREAM_DEFAULT_TOKEN_CAPACITY;
+        while (capacity < stream->token_count + count + 1) capacity *= 2;
+        if (capacity > stream->max_token + 1) capacity = stream->max_token + 1;
+        char* tmp = realloc(stream->token, capacity);
+        if (tmp == NULL) return JACON_ERR_MEMORY_ALLOCATION;
+        stream->token = tmp;
+        stream->token_capacity = capacity;
+    }
+    memcpy(stream->token + stream->token_count, chars, count);
+    stream->token_count += count;
+    return JACON_OK;
+}
+
+/**
+ * Whether the innermost open container is an object
+ */
+bool
+Jacon_stream_in_object(Jacon_Stream* stream)
+{
+    size_t top = stream->depth - 1;
+    return (stream->objects[top / 64] >> (top % 64)) & 1;
+}
+
+/**
+ * Open an object or array
+ */
+Jacon_Error
+Jacon_stream_open(Jacon_Stream* stream, bool object)
+{
+    if (stream->depth == JACON_PARSER_MAX_DEPTH) return JACON_ERR_INVALID_JSON;
+    Jacon_Error ret = Jacon_stream_emit(stream,
+        object ? JACON_EVENT_OBJECT_START : JACON_EVENT_ARRAY_START, JACON_VALUE_NULL, (Jacon_Value){0});
+    if (ret != JACON_OK) return ret;
+    size_t top = stream->depth++;
+    if (object) stream->objects[top / 64] |= 1ULL << (top % 64);
+    else stream->objects[top / 64] &= ~(1ULL << (top % 64));
+    stream->state = object ? JACON_STREAM_NAME : JACON_STREAM_VALUE;
+    stream->first = true;
+    return JACON_OK;
+}
+
+/**
+ * A value is complete, a top level one ends its document
+ */
+Jacon_Error
+Jacon_stream_value_end(Jacon_Stream* stream)
+{
+    stream->first = false;
+    if (stream->depth > 0) {
+        stream->state = JACON_STREAM_NEXT;
+        return JACON_OK;
+    }
+    stream->state = JACON_STREAM_END;
+    stream->documents++;
+    return Jacon_stream_emit(stream, JACON_EVENT_DOCUMENT_END, JACON_VALUE_NULL, (Jacon_Value){0});
+}
+
+/**
+ * Close the innermost object or array
+ */
+Jacon_Error
+Jacon_stream_close(Jacon_Stream* stream)
+{
+    bool object = Jacon_stream_in_object(stream);
+    stream->depth--;
+    Jacon_Error ret = Jacon_stream_emit(stream,
+        object ? JACON_EVENT_OBJECT_END : JACON_EVENT_ARRAY_END, JACON_VALUE_NULL, (Jacon_Value){0});
+    if (ret != JACON_OK) return ret;
+    return Jacon_stream_value_end(stream);
+}
+
+/**
+ * Read a string up to its closing quote or the end of the part
+ *  Runs of plain characters are appended at once, escape sequences are
+ *  validated a character at a time so that they can be cut between parts
+ */
+Jacon_Error
+Jacon_stream_string(Jacon_Stream* stream, const char** data, const char* end)
+{
+    Jacon_Error ret;
+    const char* ptr = *data;
+    while (ptr < end) {
+        if (stream->escape > 0) {
+            char c = *ptr;
+            if (stream->escape == 5) {
+                if (c == 'u') stream->escape = 4;
+                else if (c != '\0' && strchr("\"\\/bfnrt", c) != NULL) stream->escape = 0;
+                else return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+            } else {
+                if (!isxdigit((unsigned char)c)) return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+                stream->escape--;
+            }
+            ret = Jacon_stream_append(stream, ptr++, 1);
+            if (ret != JACON_OK) return ret;
+            continue;
+        }
+
+        const char* start = ptr;
+        while (ptr < end && *ptr != '"' && *ptr != '\\' && (unsigned char)*ptr >= 0x20) ptr++;
+        if (ptr > start) {
+            ret = Jacon_stream_append(stream, start, ptr - start);
+            if (ret != JACON_OK) return ret;
+        }
+        if (ptr == end) break;
+
+        if (*ptr == '\\') {
+            ret = Jacon_stream_append(stream, ptr++, 1);
+            if (ret != JACON_OK) return ret;
+            stream->escape = 5;
+            continue;
+        }
+        if (*ptr != '"') return JACON_ERR_INVALID_ESCAPE_SEQUENCE;
+
+        *data = ptr + 1;
+        ret = Jacon_stream_append(stream, "", 0);
+        if (ret != JACON_OK) return ret;
+        stream->token[stream->token_count] = '\0';
+        Jacon_Value value = { .string_val = stream->token };
+        if (stream->name) {
+            stream->state = JACON_STREAM_COLON;
+            return Jacon_stream_emit(stream, JACON_EVENT_KEY, JACON_VALUE_STRING, value);
+        }
+        ret = Jacon_stream_emit(stream, JACON_EVENT_VALUE, JACON_VALUE_STRING, value);
+        if (ret != JACON_OK) return ret;
+        return Jacon_stream_value_end(stream);
+    }
+    *data = ptr;
+    return JACON_OK;
+}
+
+/**
+ * Validate and convert the number or literal read, now that it is complete
+ */
+Jacon_Error
+Jacon_stream_scalar_end(Jacon_Stream* stream)
+{
+    Jacon_Error ret = Jacon_stream_append(stream, "", 0);
+    if (ret != JACON_OK) return ret;
+    char* token = stream->token;
+    token[stream->token_count] = '\0';
+
+    Jacon_ValueType type;
+    Jacon_Value value = {0};
+    if (strcmp(token, "true") == 0 || strcmp(token, "false") == 0) {
+        type = JACON_VALUE_BOOLEAN;
+        value.bool_val = token[0] == 't';
+    } else if (strcmp(token, "null") == 0) {
+        type = JACON_VALUE_NULL;
+    } else {
+        Jacon_Number number;
+        if (Jacon_scan_number(token, &number) != token + stream->token_count) return JACON_ERR_INVALID_JSON;
+        Jacon_number_value(token, &number, &type, &value);
+    }
+    ret = Jacon_stream_emit(stream, JACON_EVENT_VALUE, type, value);
+    if (ret != JACON_OK) return ret;
+    return Jacon_stream_value_end(stream);
+}
+
+/**
+ * Read a number or literal up to the first character that can't be part of one
+ *  That character is left to be parsed, the part may end before it
+ */
+Jacon_Error
+Jacon_stream_scalar(Jacon_Stream* stream, const char** data, const char* end)
+{
+    const char* start = *data;
+    const char* ptr = start;
+    while (ptr < end && (isalnum((unsigned char)*ptr) || *ptr == '-' || *ptr == '+' || *ptr == '.')) ptr++;
+    *data = ptr;
+    Jacon_Error ret = Jacon_stream_append(stream, start, ptr - start);
+    if (ret != JACON_OK || ptr == end) return ret;
+    return Jacon_stream_scalar_end(stream);
+}
+
+/**
+ * Parse a character outside of strings, numbers and literals
+ */
+Jacon_Error
+Jacon_stream_structural(Jacon_Stream* stream, const char** data)
+{
+    char c = **data;
+    switch (stream->state) {
+        case JACON_STREAM_VALUE:
+            if (c == '{' || c == '[') {
+                (*data)++;
+                return Jacon_stream_open(stream, c == '{');
+            }
+            if (c == ']' && stream->first && stream->depth > 0) {
+                (*data)++;
+                return Jacon_stream_close(stream);
+            }
+            stream->token_count = 0;
+            if (c == '"') {
+                (*data)++;
+                stream->name = false;
+                stream->state = JACON_STREAM_STRING;
+                return JACON_OK;
+            }
+            if (c == '-' || isdigit((unsigned char)c) || c == 't' || c == 'f' || c == 'n') {
+                stream->state = JACON_STREAM_SCALAR;
+                return JACON_OK;
+            }
+            return JACON_ERR_INVALID_JSON;
+        case JACON_STREAM_NAME:
+            (*data)++;
+            if (c == '}' && stream->first) return Jacon_stream_close(stream);
+            if (c != '"') return JACON_ERR_INVALID_JSON;
+            stream->token_count = 0;
+            stream->name = true;
+            stream->state = JACON_STREAM_STRING;
+            return JACON_OK;
+        case JACON_STREAM_COLON:
+            (*data)++;
+            if (c != ':') return JACON_ERR_INVALID_JSON;
+            stream->state = JACON_STREAM_VALUE;
+            stream->first = false;
+            return JACON_OK;
+        case JACON_STREAM_NEXT: {
+            (*data)++;
+            bool object = Jacon_stream_in_object(stream);
+            if (c == ',') {
+                stream->state = object ? JACON_STREAM_NAME : JACON_STREAM_VALUE;
+                stream->first = false;
+                return JACON_OK;
+            }
+            if (c != (object ? '}' : ']')) return JACON_ERR_INVALID_JSON;
+            return Jacon_stream_close(stream);
+        }
+        case JACON_STREAM_END:
+        case JACON_STREAM_STRING:
+        case JACON_STREAM_SCALAR:
+        default:
+            return JACON_ERR_INVALID_JSON;
+    }
+}
+
+Jacon_Error
+Jacon_stream_feed(Jacon_Stream* stream, const char* data, size_t len)
+{
+    if (stream->error != JACON_OK) return stream->error;
+    const char* ptr = data;
+    const char* end = data + len;
+    Jacon_Error ret = JACON_OK;
+    while (ptr < end && ret == JACON_OK) {
+        switch (stream->state) {
+            case JACON_STREAM_STRING:
+                ret = Jacon_stream_string(stream, &ptr, end);
+                break;
+            case JACON_STREAM_SCALAR:
+                ret = Jacon_stream_scalar(stream, &ptr, end);
+                break;
+            case JACON_STREAM_VALUE:
+            case JACON_STREAM_NAME:
+            case JACON_STREAM_COLON:
+            case JACON_STREAM_NEXT:
+            case JACON_STREAM_END:
+            default:
+                while (ptr < end && Jacon_is_whitespace(*ptr)) {
+                    // The next line of an ndjson input holds the next value
+                    if (*ptr == '\n' && stream->state == JACON_STREAM_END && stream->ndjson) {
+                        stream->state = JACON_STREAM_VALUE;
+                    }
+                    ptr++;
+                }
+                if (ptr < end) ret = Jacon_stream_structural(stream, &ptr);
+                break;
+        }
+    }
+    stream->offset += ptr - data;
+    stream->error = ret;
+    return ret;
+}
+
+Jacon_Error
+Jacon_stream_finish(Jacon_Stream* stream)
+{
+    if (stream->error != JACON_OK) return stream->error;
+    Jacon_Error ret = JACON_OK;
+    if (stream->state == JACON_STREAM_SCALAR) ret = Jacon_stream_scalar_end(stream);
+    if (ret == JACON_OK && stream->state != JACON_STREAM_END) {
+        if (stream->state != JACON_STREAM_VALUE || stream->depth > 0) ret = JACON_ERR_INVALID_JSON;
+        else if (!stream->ndjson) ret = JACON_ERR_EMPTY_INPUT;
+    }
+    stream->error = ret;
+    return ret;
+}
@@ -3,6 +3,208 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+
+/**
+ * Take a chunk of capacity bytes, from the pool when it has one of this size
+ */
+Ju_Arena_Chunk*
+Ju_arena_chunk_create(Ju_Arena_Pool* pool, size_t capacity)
+{
+    Ju_Arena_Chunk* chunk;
+    if (pool != NULL && pool->chunks != NULL && capacity == JU_ARENA_CHUNK_SIZE) {
+        chunk = pool->chunks;
+        pool->chunks = chunk->next;
+        pool->count--;
+    } else {
+        chunk = malloc(sizeof(Ju_Arena_Chunk) + capacity);
+        if (chunk == NULL) return NULL;
+        chunk->capacity = capacity;
+    }
+    chunk->next = NULL;
+    chunk->used = 0;
+    return chunk;
+}
+
+/**
+ * Bump size bytes aligned on align, a power of two
+ */
+void*
+Ju_arena_push(Ju_Arena* arena, size_t size, size_t align)
+{
+    if (size > JU_ARENA_LARGE_SIZE) {
+        Ju_Arena_Chunk* chunk = Ju_arena_chunk_create(NULL, size);
+        if (chunk == NULL) return NULL;
+        chunk->used = size;
+        chunk->next = arena->large;
+        arena->large = chunk;
+        return chunk->data;
+    }
+
+    Ju_Arena_Chunk* head = arena->head;
+    size_t offset = head != NULL ? (head->used + align - 1) & ~(align - 1) : 0;
+    if (head == NULL || offset + size > head->capacity) {
+        // The end of the previous chunk is left unused
+        head = Ju_arena_chunk_create(arena->pool, JU_ARENA_CHUNK_SIZE);
+        if (head == NULL) return NULL;
+        head->next = arena->head;
+        if (arena->head == NULL) arena->tail = head;
+        arena->head = head;
+        arena->count++;
+        offset = 0;
+    }
+    head->used = offset + size;
+    return head->data + offset;
+}
+
+void*
+Ju_arena_alloc(Ju_Arena* arena, size_t size)
+{
+    return Ju_arena_push(arena, size, _Alignof(max_align_t));
+}
+
+void*
+Ju_arena_realloc(Ju_Arena* arena, void* ptr, size_t old_size, size_t size)
+{
+    if (ptr == NULL) return Ju_arena_alloc(arena, size);
+
+    // Large chunks are heap blocks of their own, the latest one is resized by the system
+    if (arena->large != NULL && ptr == arena->large->data && size > JU_ARENA_LARGE_SIZE) {
+        Ju_Arena_Chunk* chunk = realloc(arena->large, sizeof(Ju_Arena_Chunk) + size);
+        if (chunk == NULL) return NULL;
+        chunk->capacity = size;
+        chunk->used = size;
+        arena->large = chunk;
+        return chunk->data;
+    }
+
+    Ju_Arena_Chunk* head = arena->head;
+    unsigned char* bytes = ptr;
+    if (head != NULL && bytes >= head->data && bytes + old_size == head->data + head->used
+        && (size_t)(bytes - head->data) + size <= head->capacity) {
+        head->used = (bytes - head->data) + size;
+        return ptr;
+    }
+    if (size <= old_size) return ptr;
+
+    void* moved = Ju_arena_alloc(arena, size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+char*
+Ju_arena_strndup(Ju_Arena* arena, const char* str, size_t len)
+{
+    char* copy = Ju_arena_push(arena, len + 1, 1);
+    if (copy == NULL) return NULL;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void
+Ju_arena_reset(Ju_Arena* arena)
+{
+    while (arena->large != NULL) {
+        Ju_Arena_Chunk* next = arena->large->next;
+        free(arena->large);
+        arena->large = next;
+    }
+
+    Ju_Arena_Pool* pool = arena->pool;
+    if (pool != NULL && pool->count + arena->count <= JU_ARENA_POOL_MAX_CHUNKS) {
+        // The whole list is spliced in front of the pool's
+        if (arena->head != NULL) {
+            arena->tail->next = pool->chunks;
+            pool->chunks = arena->head;
+            pool->count += arena->count;
+        }
+    } else {
+        Ju_Arena_Chunk* chunk = arena->head;
+        while (chunk != NULL) {
+            Ju_Arena_Chunk* next = chunk->next;
+            if (pool != NULL && pool->count < JU_ARENA_POOL_MAX_CHUNKS) {
+                chunk->next = pool->chunks;
+                pool->chunks = chunk;
+                pool->count++;
+            } else {
+                free(chunk);
+            }
+            chunk = next;
+        }
+    }
+    arena->head = NULL;
+    arena->tail = NULL;
+    arena->count = 0;
+}
+
+void
+Ju_arena_pool_free(Ju_Arena_Pool* pool)
+{
+    while (pool->chunks != NULL) {
+        Ju_Arena_Chunk* next = pool->chunks->next;
+        free(pool->chunks);
+        pool->chunks = next;
+    }
+    pool->count = 0;
+}
+
+void*
+Ju_alloc(Ju_Arena* arena, size_t size)
+{
+    return arena != NULL ? Ju_arena_alloc(arena, size) : malloc(size);
+}
+
+void*
+Ju_calloc(Ju_Arena* arena, size_t count, size_t size)
+{
+    if (arena == NULL) return calloc(count, size);
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+    void* ptr = Ju_arena_alloc(arena, count * size);
+    if (ptr != NULL) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void*
+Ju_realloc(Ju_Arena* arena, void* ptr, size_t old_size, size_t size)
+{
+    return arena != NULL ? Ju_arena_realloc(arena, ptr, old_size, size) : realloc(ptr, size);
+}
+
+char*
+Ju_strdup(Ju_Arena* arena, const char* str)
+{
+    return arena != NULL ? Ju_arena_strndup(arena, str, strlen(str)) : strdup(str);
+}
+
+char*
+Ju_strndup(Ju_Arena* arena, const char* str, size_t len)
+{
+    return arena != NULL ? Ju_arena_strndup(arena, str, len) : strndup(str, len);
+}
+
+void
+Ju_free(Ju_Arena* arena, void* ptr)
+{
+    if (arena == NULL) free(ptr);
+}
+
+/**
+ * Make room for len more bytes and the NUL terminator
+ */
+Ju_Error
+Ju_builder_reserve(StringBuilder* builder, size_t len)
+{
+    if (builder->count + len + 1 <= builder->capacity) return JU_OK;
+    size_t new_capacity = builder->capacity * 2;
+    if (new_capacity < builder->count + len + 1) new_capacity = builder->count + len + 1;
+    char* tmp = Ju_realloc(builder->arena, builder->string, builder->capacity, new_capacity);
+    if (tmp == NULL) return JU_ERR_MEMORY_ALLOCATION;
+    builder->string = tmp;
+    builder->capacity = new_capacity;
+    return JU_OK;
+}
 
 Ju_Error 
 Ju_str_append(StringBuilder* builder, ...) 
@@ -18,14 +220,11 @@ Ju_str_append(StringBuilder* builder, ...)
     {
         size_t size = strlen(arg);
         if (size > 0) {
-            if (builder->count + size + 1 > builder->capacity)
-            {
-                size_t new_capacity = builder->count + size + 1;
-                builder->string = realloc(builder->string, new_capacity);
-                if (builder->string == NULL) return JU_ERR_MEMORY_ALLOCATION;
-                builder->capacity = new_capacity;
+            if (Ju_builder_reserve(builder, size) != JU_OK) {
+                va_end(args);
+                return JU_ERR_MEMORY_ALLOCATION;
             }
-            strncpy(builder->string + builder->count, arg, size);
+            memcpy(builder->string + builder->count, arg, size);
             builder->count += size;
             builder->string[builder->count] = '\0';
         }
@@ -36,6 +235,19 @@ Ju_str_append(StringBuilder* builder, ...)
     return JU_OK;
 }
 
+Ju_Error
+Ju_str_append_len(StringBuilder* builder, const char* str, size_t len)
+{
+    if (builder == NULL || str == NULL) {
+        return JU_ERR_NULL_PARAM;
+    }
+    if (Ju_builder_reserve(builder, len) != JU_OK) return JU_ERR_MEMORY_ALLOCATION;
+    memcpy(builder->string + builder->count, str, len);
+    builder->count += len;
+    builder->string[builder->count] = '\0';
+    return JU_OK;
+}
+
 Ju_Error 
 Ju_str_append_fmt(StringBuilder* builder, const char* fmt, ...)
 {
@@ -43,36 +255,23 @@ Ju_str_append_fmt(StringBuilder* builder, const char* fmt, ...)
         return JU_ERR_NULL_PARAM;
     }
     int n;
-    size_t size = 0;
     va_list args;
     va_start(args, fmt);
-    n = vsnprintf(NULL, size, fmt, args);
+    n = vsnprintf(NULL, 0, fmt, args);
     va_end(args);
     
     if (n < 0)
         return JU_ERR_APPEND_FSTRING;
 
-    size = (size_t) n + 1;
-    if (builder->capacity < builder->count + size) {
-        size_t new_capacity = builder->count + size;
-        char* tmp = realloc(builder->string, new_capacity);
-        if (tmp == NULL) {
-            return JU_ERR_MEMORY_ALLOCATION;
-        }
-        builder->string = tmp;
-        builder->capacity = new_capacity;
+    if (Ju_builder_reserve(builder, n) != JU_OK) {
+        return JU_ERR_MEMORY_ALLOCATION;
     }
 
     va_start(args, fmt);
-    vsnprintf(builder->string + builder->count, size, fmt, args);
+    vsnprintf(builder->string + builder->count, n + 1, fmt, args);
     va_end(args);
 
-    builder->count += size - 1;
-
-    if (n < 0) {
-        return JU_ERR_MEMORY_ALLOCATION;
-    }
-
+    builder->count += n;
     return JU_OK;
 }
 
@@ -81,9 +280,11 @@ Ju_builder_free(StringBuilder *builder)
 {
     if (builder->string != NULL) 
     {
-        free(builder->string);
+        Ju_free(builder->arena, builder->string);
         builder->string = NULL;
     }
+    builder->count = 0;
+    builder->capacity = 0;
 }
 
 char*
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include "reactor.h"
+#include "file_cache.h"
+#include "jutils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+int
+Ws_set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void
+Ws_reactor_accept(Ws_Reactor* reactor);
+
+/**
+ * Close a connection and release its slot
+ */
+void
+Ws_reactor_close(Ws_Reactor* reactor, Ws_Connection* conn)
+{
+    Ws_timer_cancel(&reactor->worker->timers, &conn->timer);
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    shutdown(conn->fd, SHUT_RDWR);
+    close(conn->fd);
+    Ws_connection_free(conn);
+    reactor->connection_count--;
+
+    // The listener is edge-triggered, pending connections
+    // will not be signaled again, accept them now
+    if (reactor->saturated) {
+        reactor->saturated = false;
+        Ws_reactor_accept(reactor);
+    }
+}
+
+/**
+ * Accept every pending connection on the listener
+ */
+void
+Ws_reactor_accept(Ws_Reactor* reactor)
+{
+    while (!stop_server) {
+        if (reactor->connection_count >= reactor->worker->max_connections) {
+            reactor->saturated = true;
+            return;
+        }
+
+        int client_fd = accept4(reactor->worker->sock_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ERROR("Ws_reactor_accept : accept error: %s", strerror(errno));
+            }
+            return;
+        }
+
+        Ws_Connection* conn = Ws_connection_create(client_fd);
+        if (conn == NULL) {
+            ERROR("Ws_reactor_accept : connection alloc error");
+            close(client_fd);
+            continue;
+        }
+
+        struct epoll_event event = {
+            .events = EPOLLIN | EPOLLET,
+            .data.ptr = conn
+        };
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, client_fd, &event) != 0) {
+            ERROR("Ws_reactor_accept : epoll_ctl error: %s", strerror(errno));
+            close(client_fd);
+            Ws_connection_free(conn);
+            continue;
+        }
+        reactor->connection_count++;
+        reactor->worker->stats.connections++;
+        Ws_connection_arm_timeout(reactor->worker, conn, WS_TIMEOUT_HEADER);
+    }
+}
+
+/**
+ * Change the events a connection is waited for, edge-triggered
+ */
+bool
+Ws_reactor_watch(Ws_Reactor* reactor, Ws_Connection* conn, uint32_t events)
+{
+    struct epoll_event event = {
+        .events = events | EPOLLET,
+        .data.ptr = conn
+    };
+    return epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event) == 0;
+}
+
+/**
+ * Answer the requests buffered on conn in order, until one is incomplete
+ *  or the socket did not take the whole of a response
+ *  Returns false if the connection must be closed once its response is sent
+ */
+bool
+Ws_reactor_serve(Ws_Server* server, Ws_Connection* conn)
+{
+    size_t len;
+    Ws_Request_State state;
+    while (!Ws_connection_pending(conn) && (state = Ws_connection_parse(server, conn, &len)) != WS_REQUEST_INCOMPLETE) {
+        if (state >= WS_REQUEST_TOO_LARGE) {
+            Ws_connection_reject(server, conn, state);
+            return false;
+        }
+        if (!Ws_connection_serve(server, conn, len, true)) return false;
+    }
+    return true;
+}
+
+/**
+ * Drain a readable connection and serve every complete request it holds
+ */
+void
+Ws_reactor_read(Ws_Reactor* reactor, Ws_Server* server, Ws_Connection* conn)
+{
+    if (conn->count == 0) Ws_start_request(&conn->request);
+
+    // Responses are sent right away, what the socket does not take is queued on the connection
+    Ws_Sink sink;
+    Ws_connection_set_sink(&sink, conn);
+    conn->keep_alive = true;
+    bool eof = false;
+    bool full;
+    do {
+        // Edge-triggered: read until the socket would block
+        size_t room = 0;
+        while (!eof && (room = Ws_connection_reserve(server, conn, WS_BUFFER_MAX_LENGHT)) > 0) {
+            ssize_t ret = read(conn->fd, conn->buffer + conn->count, room);
+            if (ret > 0) {
+                conn->count += ret;
+                continue;
+            }
+            if (ret == 0) {
+                eof = true;
+                break;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            Ws_set_sink(NULL);
+            Ws_reactor_close(reactor, conn);
+            return;
+        }
+        full = room == 0;
+
+        // Pipelined requests are answered in order
+        conn->keep_alive = Ws_reactor_serve(server, conn);
+        // The read stopped at max_req_size, the socket may hold more
+    } while (conn->keep_alive && !eof && full && !Ws_connection_pending(conn) && !stop_server);
+
+    // A queued response is sent first, the end of the stream is read again after it
+    if (eof && conn->keep_alive && !Ws_connection_pending(conn)) {
+        // Peer closed its side, serve what was sent before closing
+        if (conn->count > 0) Ws_connection_serve(server, conn, conn->count, false);
+        conn->keep_alive = false;
+    }
+    Ws_set_sink(NULL);
+
+    if (Ws_connection_pending(conn)) {
+        // The socket is full, the rest of the response is sent on EPOLLOUT
+        if (!Ws_reactor_watch(reactor, conn, EPOLLOUT)) {
+            Ws_reactor_close(reactor, conn);
+            return;
+        }
+        Ws_connection_arm_timeout(reactor->worker, conn, WS_TIMEOUT_WRITE);
+        return;
+    }
+    if (!conn->keep_alive || stop_server) {
+        Ws_reactor_close(reactor, conn);
+        return;
+    }
+    Ws_connection_arm_timeout(reactor->worker, conn, Ws_connection_read_timeout(conn));
+}
+
+/**
+ * Send more of the response queued on a writable connection,
+ *  then serve the requests that waited for it
+ */
+void
+Ws_reactor_write(Ws_Reactor* reactor, Ws_Server* server, Ws_Connection* conn)
+{
+    int ret = Ws_connection_flush(conn);
+    if (ret < 0) {
+        Ws_reactor_close(reactor, conn);
+        return;
+    }
+    if (ret == 0) {
+        // Sent bytes push the deadline back, the peer has write_timeout to read more
+        Ws_connection_arm_timeout(reactor->worker, conn, WS_TIMEOUT_WRITE);
+        return;
+    }
+    if (!conn->keep_alive || stop_server || !Ws_reactor_watch(reactor, conn, EPOLLIN)) {
+        Ws_reactor_close(reactor, conn);
+        return;
+    }
+    // Requests may be buffered already, or were sent meanwhile
+    Ws_reactor_read(reactor, server, conn);
+}
+
+/**
+ * Close the connections whose deadline passed
+ *  Returns the epoll_wait timeout until the next deadline
+ */
+int
+Ws_reactor_expire(Ws_Reactor* reactor)
+{
+    Ws_Timer_Wheel* timers = &reactor->worker->timers;
+    long now = Ws_now_ms();
+    Ws_Timer* timer;
+    while ((timer = Ws_timer_expire(timers, now)) != NULL) Ws_reactor_close(reactor, timer->data);
+    return Ws_timer_wheel_timeout(timers, now);
+}
+
+int
+Ws_reactor_run(Ws_Server* server, Ws_Worker* worker)
+{
+    Ws_Reactor reactor = {0};
+    reactor.worker = worker;
+
+    reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    CHECK(reactor.epoll_fd >= 0, "Ws_reactor_run : epoll_create1 error");
+
+    int ret = Ws_set_nonblocking(worker->sock_fd);
+    CHECK(ret == 0, "Ws_reactor_run : fcntl error");
+
+    // The listener is registered with a NULL pointer to tell it apart from connections
+    struct epoll_event listen_event = {
+        .events = EPOLLIN | EPOLLET,
+        .data.ptr = NULL
+    };
+    ret = epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, worker->sock_fd, &listen_event);
+    CHECK(ret == 0, "Ws_reactor_run : epoll_ctl error");
+
+    // The file cache watch is registered with a pointer to the cache
+    if (worker->files.watch_fd >= 0) {
+        struct epoll_event watch_event = {
+            .events = EPOLLIN,
+            .data.ptr = &worker->files
+        };
+        ret = epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, worker->files.watch_fd, &watch_event);
+        CHECK(ret == 0, "Ws_reactor_run : epoll_ctl error");
+    }
+
+    struct epoll_event events[WS_REACTOR_MAX_EVENTS];
+    while (!stop_server) {
+        int timeout = Ws_reactor_expire(&reactor);
+        int count = epoll_wait(reactor.epoll_fd, events, WS_REACTOR_MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            ERROR("Ws_reactor_run : epoll_wait error: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Ws_Connection* conn = events[i].data.ptr;
+            if (conn == NULL) {
+                Ws_reactor_accept(&reactor);
+            } else if (events[i].data.ptr == &worker->files) {
+                Ws_file_cache_refresh(&worker->files, &server->router);
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                Ws_reactor_close(&reactor, conn);
+            } else if (Ws_connection_pending(conn)) {
+                Ws_reactor_write(&reactor, server, conn);
+            } else {
+                Ws_reactor_read(&reactor, server, conn);
+            }
+        }
+    }
+
+    // Every open connection has a deadline unless its timeout is disabled
+    Ws_Timer* timer;
+    while ((timer = Ws_timer_pop(&worker->timers)) != NULL) Ws_reactor_close(&reactor, timer->data);
+    close(reactor.epoll_fd);
+    return EXIT_SUCCESS;
+}
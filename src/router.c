@@ -0,0 +1,233 @@
+#include "router.h"
+#include "jutils.h"
+#include <stdlib.h>
+#include <string.h>
+
+Ws_Route_Node*
+Ws_route_node_create(const char* prefix, size_t prefix_len)
+{
+    Ws_Route_Node* node = calloc(1, sizeof(Ws_Route_Node));
+    CHECK(node != NULL, "route node alloc error");
+    node->prefix = prefix;
+    node->prefix_len = prefix_len;
+    return node;
+}
+
+/**
+ * Follow the static edges under node along len bytes of str, adding and
+ *  splitting edges as needed, and return the node where str ends
+ */
+Ws_Route_Node*
+Ws_route_node_insert_static(Ws_Route_Node* node, const char* str, size_t len)
+{
+    while (len > 0) {
+        Ws_Route_Node** slot = NULL;
+        for (size_t i = 0; i < node->children_count; i++) {
+            if (node->children[i]->prefix[0] == str[0]) {
+                slot = &node->children[i];
+                break;
+            }
+        }
+
+        if (slot == NULL) {
+            Ws_Route_Node** children = realloc(node->children, (node->children_count + 1) * sizeof(Ws_Route_Node*));
+            CHECK(children != NULL, "route node alloc error");
+            node->children = children;
+            Ws_Route_Node* child = Ws_route_node_create(str, len);
+            node->children[node->children_count++] = child;
+            return child;
+        }
+
+        Ws_Route_Node* child = *slot;
+        size_t common = 0;
+        while (common < child->prefix_len && common < len && child->prefix[common] == str[common]) common++;
+        if (common < child->prefix_len) {
+            // Split the edge where the new path leaves it
+            Ws_Route_Node* split = Ws_route_node_create(child->prefix, common);
+            split->children = malloc(sizeof(Ws_Route_Node*));
+            CHECK(split->children != NULL, "route node alloc error");
+            split->children[0] = child;
+            split->children_count = 1;
+            child->prefix += common;
+            child->prefix_len -= common;
+            *slot = split;
+            child = split;
+        }
+        node = child;
+        str += common;
+        len -= common;
+    }
+    return node;
+}
+
+Route*
+Ws_create_route()
+{
+    Route* route = malloc(sizeof(Route));
+    CHECK(route != NULL, "route alloc error");
+    return route;
+}
+
+Route*
+Ws_router_handle(
+    Ws_Router* router,
+    char* path,
+    Http_Method method,
+    Ws_Handler handler,
+    Ws_Handler middleware
+)
+{
+    CHECK(path != NULL, "add handler null path");
+    CHECK(method >= 0 && method < HTTP_METHOD_INVALID, "add handler wrong method");
+
+    if (router->trees[method] == NULL) router->trees[method] = Ws_route_node_create(path, 0);
+    Ws_Route_Node* node = router->trees[method];
+
+    size_t params = 0;
+    const char* p = path;
+    while (*p != '\0') {
+        if (*p == ':' || *p == '*') {
+            // A wildcard takes the rest of the path, a param one segment
+            const char* end = p + 1;
+            if (*p == '*') end += strlen(end);
+            else while (*end != '\0' && *end != '/') end++;
+
+            Http_Slice name = { .ptr = p + 1, .len = end - p - 1 };
+            CHECK(name.len > 0, "add handler unnamed path parameter");
+            CHECK(++params <= HTTP_MAX_PARAMS, "add handler too many path parameters");
+
+            Ws_Route_Node** slot = *p == ':' ? &node->param : &node->wildcard;
+            if (*slot == NULL) {
+                *slot = Ws_route_node_create(p, 0);
+                (*slot)->name = name;
+            }
+            CHECK((*slot)->name.len == name.len && memcmp((*slot)->name.ptr, name.ptr, name.len) == 0,
+                "add handler conflicting path parameter names");
+            node = *slot;
+            p = end;
+        } else {
+            const char* end = p;
+            while (*end != '\0' && *end != ':' && *end != '*') end++;
+            node = Ws_route_node_insert_static(node, p, end - p);
+            p = end;
+        }
+    }
+    CHECK(node->route == NULL, "add handler duplicate route");
+
+    Route* route = Ws_create_route();
+    route->path = path;
+    route->method = method;
+    route->handler = handler;
+    route->middleware = middleware;
+    route->body_handler = NULL;
+    route->file_path = NULL;
+    route->file_index = 0;
+    route->file_buffer = NULL;
+    route->file_size = 0;
+    node->route = route;
+    router->routes_count++;
+    return route;
+}
+
+Route*
+Ws_router_handle_stream(
+    Ws_Router* router,
+    char* path,
+    Http_Method method,
+    Ws_Body_Handler body_handler,
+    Ws_Handler handler,
+    Ws_Handler middleware
+)
+{
+    CHECK(body_handler != NULL, "add stream handler null body handler");
+    Route* route = Ws_router_handle(router, path, method, handler, middleware);
+    route->body_handler = body_handler;
+    router->streams_count++;
+    return route;
+}
+
+/**
+ * Match len bytes of path below node, whose own prefix is already matched
+ *  Backtracks from static edges to params and then wildcards
+ */
+Route*
+Ws_route_node_match(Ws_Route_Node* node, const char* path, size_t len, Http_Request* req)
+{
+    if (len == 0 && node->route != NULL) return node->route;
+
+    Route* route;
+    if (len > 0) {
+        for (size_t i = 0; i < node->children_count; i++) {
+            Ws_Route_Node* child = node->children[i];
+            if (child->prefix[0] != path[0]) continue;
+            if (child->prefix_len <= len && memcmp(child->prefix, path, child->prefix_len) == 0) {
+                route = Ws_route_node_match(child, path + child->prefix_len, len - child->prefix_len, req);
+                if (route != NULL) return route;
+            }
+            break;
+        }
+
+        if (node->param != NULL) {
+            const char* slash = memchr(path, '/', len);
+            size_t segment = slash != NULL ? (size_t)(slash - path) : len;
+            if (segment > 0) {
+                size_t params_count = req->params_count;
+                req->params[req->params_count++] = (Http_Param){
+                    .name = node->param->name,
+                    .value = { .ptr = path, .len = segment }
+                };
+                route = Ws_route_node_match(node->param, path + segment, len - segment, req);
+                if (route != NULL) return route;
+                req->params_count = params_count;
+            }
+        }
+    }
+
+    if (node->wildcard != NULL && node->wildcard->route != NULL) {
+        req->params[req->params_count++] = (Http_Param){
+            .name = node->wildcard->name,
+            .value = { .ptr = path, .len = len }
+        };
+        return node->wildcard->route;
+    }
+    return NULL;
+}
+
+Route*
+Ws_router_match(Ws_Router* router, Http_Request* req)
+{
+    req->params_count = 0;
+    if (req->path == NULL || req->method < 0 || req->method >= HTTP_METHOD_INVALID) return NULL;
+    Ws_Route_Node* root = router->trees[req->method];
+    if (root == NULL) return NULL;
+    // The query string is not part of the route
+    size_t len = strcspn(req->path, "?");
+    return Ws_route_node_match(root, req->path, len, req);
+}
+
+void
+Ws_route_node_free(Ws_Route_Node* node)
+{
+    if (node == NULL) return;
+    for (size_t i = 0; i < node->children_count; i++) Ws_route_node_free(node->children[i]);
+    free(node->children);
+    Ws_route_node_free(node->param);
+    Ws_route_node_free(node->wildcard);
+    if (node->route != NULL) free(node->route->file_buffer);
+    free(node->route);
+    free(node);
+}
+
+void
+Ws_router_free(Ws_Router* router)
+{
+    for (int i = 0; i < HTTP_METHOD_INVALID; i++) {
+        Ws_route_node_free(router->trees[i]);
+        router->trees[i] = NULL;
+    }
+    router->routes_count = 0;
+    router->streams_count = 0;
+    free(router->files);
+    router->files = NULL;
+    router->files_count = 0;
+}
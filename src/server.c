@@ -1,7 +1,13 @@
 #include "server.h"
+#include "reactor.h"
+#include "worker.h"
+#include "file_cache.h"
+#include "http_scan.h"
 #include "jutils.h"
 #include "hashmap.h"
 #include <ctype.h>
+#include <errno.h>
+#include <poll.h>
 #include <string.h>
 #include <stdio.h>
 #include <limits.h>
@@ -16,9 +22,7 @@
 #include <sys/wait.h>
 #include <sys/sendfile.h>
 #include <bits/waitflags.h>
-#include <semaphore.h>
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <sys/mman.h>
 
 // Handles the stopping of the server when SIGINT is encountered, through 'sigint_handler()'
 volatile sig_atomic_t stop_server = 0;
@@ -63,6 +67,20 @@ char *trim_whitespace(char *str) {
     return str;
 }
 
+/**
+ * Utility function for config file parsing
+ * Strips an inline comment ('#' or ';' preceded by whitespace) from a value
+ */
+char *strip_inline_comment(char *str) {
+    for (char* p = str; *p; p++) {
+        if ((*p == '#' || *p == ';') && p > str && isspace((unsigned char)p[-1])) {
+            *p = '\0';
+            return trim_whitespace(str);
+        }
+    }
+    return str;
+}
+
 /**
  * Utility funciton to parse a config file into a Ws_config struct
  */
@@ -84,8 +102,9 @@ Ws_parse_config(Ws_Config* config, FILE* input_file)
         if (equals) {
             *equals = '\0';
             char *key = trim_whitespace(trimmed_line);
-            char *value = trim_whitespace(equals + 1);
-            hm_put(config, key, value);
+            char *value = strip_inline_comment(trim_whitespace(equals + 1));
+            // line is reused for every line, the map must own its values
+            hm_put(config, key, strdup(value));
         } else {
             ERROR("Config parsing: Malformed line: %s\n", trimmed_line);
         }
@@ -138,15 +157,61 @@ Ws_config_get_value(Ws_Config* config, const char* key)
     return value;
 }
 
-/**
- * Default server root route
- */
+char*
+Ws_config_get_value_or(Ws_Config* config, const char* key, char* default_value)
+{
+    char* value = hm_get(config, key);
+    return value != NULL ? value : default_value;
+}
+
+Ws_Engine
+Ws_parse_engine(const char* str)
+{
+    if (str == NULL) return WS_ENGINE_INVALID;
+    if (!strcmp(str, "fork")) return WS_ENGINE_FORK;
+    if (!strcmp(str, "epoll")) return WS_ENGINE_EPOLL;
+    if (!strcmp(str, "io_uring")) return WS_ENGINE_URING;
+    return WS_ENGINE_INVALID;
+}
+
+Ws_Worker_Mode
+Ws_parse_worker_mode(const char* str)
+{
+    if (str == NULL) return WS_WORKER_INVALID;
+    if (!strcmp(str, "process")) return WS_WORKER_PROCESS;
+    if (!strcmp(str, "thread")) return WS_WORKER_THREAD;
+    return WS_WORKER_INVALID;
+}
+
 int
-default_server_route(Route* route, Http_Request* req, Http_Response* res)
+Ws_parse_cpu_list(const char* str, int** cpus)
 {
-    (void)route;
-    Ws_send_response_with_file(req->client_fd, res, "static/default.html");
-    return 0;
+    *cpus = NULL;
+    if (str == NULL) return 0;
+    int count = 0;
+    const char* p = str;
+    while (*p != '\0') {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        bool valid = end != p && first >= 0 && first < WS_MAX_CPUS;
+        if (valid && *end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            valid = end != p && last >= first && last < WS_MAX_CPUS;
+        }
+        if (valid && *end != ',' && *end != '\0') valid = false;
+        int* grown = valid ? realloc(*cpus, (count + last - first + 1) * sizeof(int)) : NULL;
+        if (grown == NULL) {
+            free(*cpus);
+            *cpus = NULL;
+            return 0;
+        }
+        *cpus = grown;
+        for (long cpu = first; cpu <= last; cpu++) (*cpus)[count++] = cpu;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
 }
 
 /**
@@ -156,8 +221,7 @@ Ws_Router
 Ws_default_router()
 {
     Ws_Router router = {0};
-    router.routes = hm_create(1);
-    Ws_router_handle(&router, "/", HTTP_METHOD_GET, default_server_route, NULL);
+    Ws_router_handle_file(&router, "/", "static/default.html", NULL);
     return router;
 }
 
@@ -172,9 +236,6 @@ sigint_handler(int signum)
     stop_server = 1;
 }
 
-/**
- * Add a signal handler
- */
 int
 Ws_handle_signal(int signum, void (*handler)(int signum))
 {
@@ -189,18 +250,23 @@ Ws_handle_signal(int signum, void (*handler)(int signum))
 }
 
 /**
- * Initializes the server socket
+ * Create a listening socket bound to the configured port
+ *  reuseport: set SO_REUSEPORT so several listeners can share the port
  */
-void
-Ws_init_server_socket(Ws_Server* server)
+int
+Ws_create_listener(Ws_Server* server, bool reuseport)
 {
     int ret;
 
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    CHECK(sockfd > 0, "Ws_init_server_socket : socket error");
+    int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    CHECK(sockfd > 0, "Ws_create_listener : socket error");
     
     int option = 1;
     setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(int));
+    if (reuseport) {
+        ret = setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(int));
+        CHECK(ret == 0, "Ws_create_listener : SO_REUSEPORT error");
+    }
 
     char* str_config_port = Ws_config_get_value(&server->config, "port");
     Ws_parse_result port = Ws_parse_int(str_config_port);
@@ -212,16 +278,39 @@ Ws_init_server_socket(Ws_Server* server)
     addr.sin_port = htons(port.int_val);
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
     ret = bind(sockfd, (struct sockaddr *) &addr, sizeof(addr));
-    CHECK(ret == 0, "Ws_init_server_socket : bind error");
+    CHECK(ret == 0, "Ws_create_listener : bind error");
 
     char* str_backlog = Ws_config_get_value(&server->config, "backlog");
     Ws_parse_result backlog = Ws_parse_int(str_backlog);
     if(backlog.error) backlog.int_val = WS_CONFIG_DEFAULT_BACKLOG;
 
     ret = listen(sockfd, backlog.int_val);
-    CHECK(ret == 0, "Ws_init_server_socket : listen error");
+    CHECK(ret == 0, "Ws_create_listener : listen error");
 
-    server->sock_fd = sockfd;
+    return sockfd;
+}
+
+/**
+ * Initializes the server socket
+ *  fork engine: a single listener accepted from by the parent
+ *  other engines: one SO_REUSEPORT listener per worker, created here so
+ *  bind errors surface at setup and a respawned worker gets its queue back
+ */
+void
+Ws_init_server_socket(Ws_Server* server)
+{
+    if (server->engine == WS_ENGINE_FORK) {
+        server->sock_fd = Ws_create_listener(server, false);
+        return;
+    }
+
+    server->worker_fds = malloc(server->worker_count * sizeof(int));
+    CHECK(server->worker_fds != NULL, "Ws_init_server_socket : listeners alloc error");
+    for (int i = 0; i < server->worker_count; i++) {
+        server->worker_fds[i] = Ws_create_listener(server, true);
+    }
+    // Set by each worker to its own listener
+    server->sock_fd = -1;
 }
 
 Ws_Server
@@ -232,22 +321,13 @@ Ws_server_setup(Ws_Config config, Ws_Router router)
     if(hm_isempty(config)) server.config = Ws_default_config();
     else server.config = config;
 
-    if(hm_isempty(router.routes)) server.router = Ws_default_router();
+    if(router.routes_count == 0) server.router = Ws_default_router();
     else server.router = router;
 
-    int shm_id = shmget(IPC_PRIVATE, sizeof(int), IPC_CREAT | 0666);
-    CHECK(shm_id > 0, "Ws_server_setup : shmget error");
-    server.connection_count_shm_id = shm_id;
-
-    int* connection_count = (int *)shmat(shm_id, NULL, 0);
-    CHECK(*connection_count != -1, "Ws_server_setup : shmat error");
-
-    server.connection_count = connection_count;
-    *server.connection_count = 0;
-
-    sem_t* sem = sem_open(SEM_NAME, O_CREAT, 0644, 1);
-    CHECK(sem != SEM_FAILED, "Ws_server_setup : sem_open failed");
-    server.connection_count_sem = sem;
+    // Inherited by the forked processes, unlike a private mapping
+    server.connections = mmap(NULL, sizeof(Ws_Connection_Counter), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    CHECK(server.connections != MAP_FAILED, "Ws_server_setup : mmap error");
+    atomic_init(&server.connections->count, 0);
 
     char* str_max_conn = Ws_config_get_value(&server.config, "max_conn");
     Ws_parse_result max_conn = Ws_parse_int(str_max_conn);
@@ -255,52 +335,333 @@ Ws_server_setup(Ws_Config config, Ws_Router router)
 
     server.max_connections = max_conn.int_val;
 
+    char* str_max_req_size = Ws_config_get_value_or(&server.config, "max_req_size", NULL);
+    Ws_parse_result max_req_size = Ws_parse_int(str_max_req_size);
+    if(max_req_size.error || max_req_size.int_val == 0) max_req_size.int_val = WS_CONFIG_DEFAULT_MAX_REQUEST_SIZE;
+    server.max_request_size = max_req_size.int_val;
+
+    char* str_engine = Ws_config_get_value_or(&server.config, "engine", NULL);
+    server.engine = Ws_parse_engine(str_engine);
+    if (server.engine == WS_ENGINE_INVALID) {
+        if (str_engine != NULL) WARN("Unknown engine '%s', using fork", str_engine);
+        server.engine = WS_CONFIG_DEFAULT_ENGINE;
+    }
+
+    char* str_worker_mode = Ws_config_get_value_or(&server.config, "worker_mode", NULL);
+    server.worker_mode = Ws_parse_worker_mode(str_worker_mode);
+    if (server.worker_mode == WS_WORKER_INVALID) {
+        if (str_worker_mode != NULL) WARN("Unknown worker mode '%s', using process", str_worker_mode);
+        server.worker_mode = WS_WORKER_PROCESS;
+    }
+
+    char* str_cpu_list = Ws_config_get_value_or(&server.config, "cpu_list", NULL);
+    server.cpu_count = Ws_parse_cpu_list(str_cpu_list, &server.cpu_list);
+    if (server.cpu_count == 0 && str_cpu_list != NULL && *str_cpu_list != '\0') {
+        WARN("Invalid cpu_list '%s', workers are not pinned", str_cpu_list);
+    }
+
+    // One worker per listed CPU, or per online CPU
+    char* str_workers = Ws_config_get_value_or(&server.config, "workers", NULL);
+    Ws_parse_result workers = Ws_parse_int(str_workers);
+    if(workers.error || workers.int_val == 0) {
+        workers.int_val = server.cpu_count > 0 ? server.cpu_count : sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(workers.int_val < 1) workers.int_val = 1;
+    // Each worker takes at least one of the max_conn connections
+    if(server.max_connections > 0 && workers.int_val > server.max_connections) {
+        WARN("%d workers for max_conn=%d, starting %d", workers.int_val, server.max_connections, server.max_connections);
+        workers.int_val = server.max_connections;
+    }
+    server.worker_count = workers.int_val;
+
+    char* str_keepalive_timeout = Ws_config_get_value_or(&server.config, "keepalive_timeout", NULL);
+    Ws_parse_result keepalive_timeout = Ws_parse_int(str_keepalive_timeout);
+    if(keepalive_timeout.error || keepalive_timeout.int_val < 0) keepalive_timeout.int_val = WS_CONFIG_DEFAULT_KEEPALIVE_TIMEOUT;
+    server.keepalive_timeout = keepalive_timeout.int_val;
+
+    char* str_keepalive_requests = Ws_config_get_value_or(&server.config, "keepalive_requests", NULL);
+    Ws_parse_result keepalive_requests = Ws_parse_int(str_keepalive_requests);
+    if(keepalive_requests.error || keepalive_requests.int_val < 1) keepalive_requests.int_val = WS_CONFIG_DEFAULT_KEEPALIVE_REQUESTS;
+    server.keepalive_requests = keepalive_requests.int_val;
+
+    char* str_header_timeout = Ws_config_get_value_or(&server.config, "header_timeout", NULL);
+    Ws_parse_result header_timeout = Ws_parse_int(str_header_timeout);
+    if(header_timeout.error || header_timeout.int_val < 0) header_timeout.int_val = WS_CONFIG_DEFAULT_HEADER_TIMEOUT;
+    server.header_timeout = header_timeout.int_val;
+
+    char* str_body_timeout = Ws_config_get_value_or(&server.config, "body_timeout", NULL);
+    Ws_parse_result body_timeout = Ws_parse_int(str_body_timeout);
+    if(body_timeout.error || body_timeout.int_val < 0) body_timeout.int_val = WS_CONFIG_DEFAULT_BODY_TIMEOUT;
+    server.body_timeout = body_timeout.int_val;
+
+    char* str_write_timeout = Ws_config_get_value_or(&server.config, "write_timeout", NULL);
+    Ws_parse_result write_timeout = Ws_parse_int(str_write_timeout);
+    if(write_timeout.error || write_timeout.int_val < 0) write_timeout.int_val = WS_CONFIG_DEFAULT_WRITE_TIMEOUT;
+    server.write_timeout = write_timeout.int_val;
+
     Ws_handle_signal(SIGINT, sigint_handler);
+    // A peer closing early must fail the write, not kill the process
+    Ws_handle_signal(SIGPIPE, SIG_IGN);
+
+    // Picked before any worker thread runs a scanner
+    Http_scan_init();
 
     Ws_init_server_socket(&server);
     INFO("Server setup done");
     return server;
 }
 
+// Sink of the request being processed, a worker only serves one request at a time
+_Thread_local Ws_Sink* current_sink = NULL;
+
+void
+Ws_set_sink(Ws_Sink* sink)
+{
+    current_sink = sink;
+}
+
 /**
- * Read a request on a file descriptor
+ * Wait for the peer to read from a non-blocking socket with a full send buffer
+ *  Only writes made outside of an engine's sink get here, the engines queue
+ *  what the socket does not take and time it out in their worker's wheel.
+ *  Once the write timeout passes without the peer reading, the socket is
+ *  shut down and ETIMEDOUT is returned
  */
 int
-Ws_read_request(int fd, char* buf) 
+Ws_wait_writable(int fd)
 {
-    int ret = read(fd, buf, WS_BUFFER_MAX_LENGHT);
-    CHECK(ret > 0, "read empty request");
-    return ret;
+    Ws_Worker* worker = Ws_current_worker();
+    long timeout = worker != NULL ? worker->timeouts[WS_TIMEOUT_WRITE] : 0;
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+    int ret = poll(&pfd, 1, timeout > 0 ? (int)timeout : -1);
+    if (ret < 0) return errno == EINTR ? 0 : -1;
+    if (ret == 0) {
+        shutdown(fd, SHUT_RDWR);
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return 0;
 }
 
 int
-Ws_send_response(int fd, Http_Response* res)
+Ws_write_all(int fd, const char* buf, size_t len)
 {
-    const char* res_header = Http_get_status_header(res->status);
+    if (current_sink != NULL && current_sink->fd == fd) {
+        struct iovec iov = { .iov_base = (char*)buf, .iov_len = len };
+        return current_sink->write(current_sink->ctx, &iov, 1, 0);
+    }
+    while (len > 0) {
+        ssize_t ret = write(fd, buf, len);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            // Non-blocking socket with a full send buffer
+            if (Ws_wait_writable(fd) != 0) return -1;
+            continue;
+        }
+        buf += ret;
+        len -= ret;
+    }
+    return 0;
+}
 
-    StringBuilder builder = {0};
-    Ju_str_append_null(&builder, res_header, "\r\n");
+/**
+ * Send count buffers of iov on the socket fd with a single sendmsg when it takes them all
+ *  Waits for the socket to be writable if it would block, for at most write_timeout
+ */
+int
+Ws_sendmsg_all(int fd, struct iovec* iov, int count, int flags)
+{
+    if (current_sink != NULL && current_sink->fd == fd) {
+        return current_sink->write(current_sink->ctx, iov, count, flags);
+    }
+    while (count > 0) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = count };
+        ssize_t ret = sendmsg(fd, &msg, flags);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            if (Ws_wait_writable(fd) != 0) return -1;
+            continue;
+        }
+        count = Ws_iov_advance(&iov, count, ret);
+    }
+    return 0;
+}
 
-    write(fd, builder.string, builder.count);
+int
+Ws_iov_advance(struct iovec** iov, int count, size_t len)
+{
+    // Skip the buffers fully written, then the written part of the next one
+    while (count > 0 && len >= (*iov)->iov_len) {
+        len -= (*iov)->iov_len;
+        (*iov)++;
+        count--;
+    }
+    if (count > 0) {
+        (*iov)->iov_base = (char*)(*iov)->iov_base + len;
+        (*iov)->iov_len -= len;
+    }
+    return count;
+}
 
-    Ju_builder_free(&builder);
+/**
+ * Send size bytes of filefd on fd
+ *  Waits for the socket to be writable if it would block, for at most write_timeout
+ */
+int
+Ws_sendfile_all(int fd, int filefd, size_t size)
+{
+    off_t offset = 0;
+    while ((size_t)offset < size) {
+        ssize_t ret = sendfile(fd, filefd, &offset, size - offset);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            if (Ws_wait_writable(fd) != 0) return -1;
+            continue;
+        }
+        if (ret == 0) break;
+    }
     return 0;
 }
 
 int
-Ws_send_response_with_content(int fd, Http_Response* res, Http_ContentType type)
+Ws_send_file(int fd, int filefd, size_t size)
 {
-    const char* res_header = Http_get_status_header(res->status);
-    const char* res_content_type = Http_get_content_type(type);
+    if (current_sink != NULL && current_sink->fd == fd) {
+        return current_sink->send_file(current_sink->ctx, filefd, size);
+    }
+    int ret = Ws_sendfile_all(fd, filefd, size);
+    close(filefd);
+    return ret;
+}
 
-    StringBuilder builder = {0};
-    Ju_str_append_fmt_null(&builder, "%s\r\nContent-Type: %s\r\nContent-Length: %ld\r\n\r\n%s",
-        res_header, res_content_type, strlen(res->content), res->content);
+const char*
+Ws_connection_header(Http_Response* res)
+{
+    return res->keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+}
 
-    write(fd, builder.string, builder.count);
+void
+Ws_writer_init(Ws_Response_Writer* writer)
+{
+    writer->head_count = 0;
+    writer->overflow = false;
+    writer->buffers[0] = (struct iovec){ .iov_base = writer->head, .iov_len = 0 };
+    writer->count = 1;
+}
 
-    Ju_builder_free(&builder);
-    return 0;
+/**
+ * Copy len bytes of str at the end of the head
+ */
+void
+Ws_writer_put(Ws_Response_Writer* writer, const char* str, size_t len)
+{
+    if (len > WS_WRITER_HEAD_SIZE - writer->head_count) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->head + writer->head_count, str, len);
+    writer->head_count += len;
+}
+
+void
+Ws_writer_head(Ws_Response_Writer* writer, Http_Response* res)
+{
+    const char* status = Http_get_status_header(res->status);
+    Ws_writer_put(writer, status, strlen(status));
+    Ws_writer_put(writer, "\r\n", 2);
+    const char* connection = Ws_connection_header(res);
+    Ws_writer_put(writer, connection, strlen(connection));
+
+    size_t room = WS_WRITER_HEAD_SIZE - writer->head_count;
+    size_t len = Http_serialize_headers(res, writer->head + writer->head_count, room);
+    if (len > room) writer->overflow = true;
+    else writer->head_count += len;
+}
+
+void
+Ws_writer_end_head(Ws_Response_Writer* writer, Http_Response* res, size_t content_length)
+{
+    // The body must be delimited for the connection to be reused
+    if (res->status != HTTP_STATUS_NO_CONTENT) {
+        char line[48];
+        int len = snprintf(line, sizeof(line), "Content-Length: %zu\r\n", content_length);
+        Ws_writer_put(writer, line, len);
+    }
+    Ws_writer_put(writer, "\r\n", 2);
+}
+
+void
+Ws_writer_append(Ws_Response_Writer* writer, const char* buf, size_t len)
+{
+    CHECK(writer->count < WS_WRITER_MAX_BUFFERS, "Ws_writer_append : too many buffers");
+    writer->buffers[writer->count++] = (struct iovec){ .iov_base = (char*)buf, .iov_len = len };
+}
+
+/**
+ * Seal the head, returns false if the response can't be sent
+ */
+bool
+Ws_writer_finish(Ws_Response_Writer* writer)
+{
+    if (writer->overflow) {
+        ERROR("Response headers over %d bytes", WS_WRITER_HEAD_SIZE);
+        return false;
+    }
+    writer->buffers[0].iov_len = writer->head_count;
+    return true;
+}
+
+int
+Ws_writer_flush(int fd, Ws_Response_Writer* writer)
+{
+    if (!Ws_writer_finish(writer)) return -1;
+    return Ws_sendmsg_all(fd, writer->buffers, writer->count, 0);
+}
+
+int
+Ws_writer_flush_with_file(int fd, Ws_Response_Writer* writer, int filefd, size_t size)
+{
+    if (!Ws_writer_finish(writer)) {
+        close(filefd);
+        return -1;
+    }
+    // Nothing follows an empty file, the head must be pushed
+    int ret = Ws_sendmsg_all(fd, writer->buffers, writer->count, size > 0 ? MSG_MORE : 0);
+    if (ret != 0) {
+        close(filefd);
+        return ret;
+    }
+    return Ws_send_file(fd, filefd, size);
+}
+
+int
+Ws_send_response(int fd, Http_Response* res)
+{
+    Ws_Response_Writer writer;
+    Ws_writer_init(&writer);
+    Ws_writer_head(&writer, res);
+    Ws_writer_end_head(&writer, res, 0);
+    return Ws_writer_flush(fd, &writer);
+}
+
+int
+Ws_send_response_with_content(int fd, Http_Response* res, Http_ContentType type)
+{
+    size_t content_length = strlen(res->content);
+    // A type set by the handler wins
+    if (Http_get_response_header(res, "Content-Type") == NULL) {
+        Http_set_header(res, "Content-Type", Http_get_content_type(type));
+    }
+
+    Ws_Response_Writer writer;
+    Ws_writer_init(&writer);
+    Ws_writer_head(&writer, res);
+    Ws_writer_end_head(&writer, res, content_length);
+    Ws_writer_append(&writer, res->content, content_length);
+    return Ws_writer_flush(fd, &writer);
 }
 
 int
@@ -312,69 +673,179 @@ Ws_send_response_with_file(int fd, Http_Response* res, const char* filepath)
         // And therefore should exist
         // We are not letting users say which file they want
         res->status = HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        res->headers_count = 0;
         Ws_send_response(fd, res);
         return 0;
     }
-    Ws_send_response(fd, res);
 
     struct stat stat_buf;
-    fstat(filefd, &stat_buf);
-
-    StringBuilder builder = {0};
-    Ju_str_append_fmt_null(&builder, "Content-Type: text/html\r\nContent-Length: %ld\r\nConnection: close\r\n\r\n", stat_buf.st_size);
-    write(fd, builder.string, builder.count);
+    if (fstat(filefd, &stat_buf) == -1) {
+        // Without its size the file can't be framed, nothing of it is sent
+        perror("fstat");
+        close(filefd);
+        res->status = HTTP_STATUS_INTERNAL_SERVER_ERROR;
+        res->headers_count = 0;
+        Ws_send_response(fd, res);
+        return 0;
+    }
+    if (Http_get_response_header(res, "Content-Type") == NULL) {
+        Http_set_header(res, "Content-Type", Http_get_mime_type(filepath));
+    }
 
-    off_t offset = 0;
-    ssize_t bytes_sent = sendfile(fd, filefd, &offset, stat_buf.st_size);
-    if (bytes_sent == -1) {
+    Ws_Response_Writer writer;
+    Ws_writer_init(&writer);
+    Ws_writer_head(&writer, res);
+    Ws_writer_end_head(&writer, res, stat_buf.st_size);
+    if (Ws_writer_flush_with_file(fd, &writer, filefd, stat_buf.st_size) == -1) {
         perror("sendfile");
         return -1;
     }
 
-    close(filefd);
-    Ju_builder_free(&builder);
     return 0;
 }
 
+// Size line reserved in front of a chunk, its digits are filled once the chunk is closed
+#define WS_STREAM_SIZE_LINE "00000000\r\n"
+#define WS_STREAM_SIZE_DIGITS 8
+
 /**
- * Log a request: time in ms, status, http method, path
+ * Append to the stream's buffer, a failure drops the rest of the body
  */
-void
-Ws_log_request(Http_Request* req, Http_Response* res) 
+int
+Ws_stream_append(Ws_Response_Stream* stream, const char* buf, size_t len)
 {
-    INFO("%8.3f ms %-3d %-6s %s", req->request_timing, res->status, Http_strmethod(req->method), req->path);
+    if (stream->failed) return -1;
+    if (Ju_str_append_len(&stream->buffer, buf, len) != JU_OK) {
+        stream->failed = true;
+        return -1;
+    }
+    return 0;
 }
 
-Route*
-Ws_create_route()
+/**
+ * Write the size of the open chunk in its size line and end it
+ */
+int
+Ws_stream_close_chunk(Ws_Response_Stream* stream)
 {
-    Route* route = malloc(sizeof(Route));
-    CHECK(route != NULL, "route alloc error");
-    return route;
+    if (!stream->chunk_open) return 0;
+    stream->chunk_open = false;
+    size_t size = stream->buffer.count - stream->chunk_start - (sizeof(WS_STREAM_SIZE_LINE) - 1);
+    char digits[WS_STREAM_SIZE_DIGITS + 1];
+    snprintf(digits, sizeof(digits), "%0*zx", WS_STREAM_SIZE_DIGITS, size);
+    memcpy(stream->buffer.string + stream->chunk_start, digits, WS_STREAM_SIZE_DIGITS);
+    return Ws_stream_append(stream, "\r\n", 2);
 }
 
-void 
-Ws_router_handle(
-    Ws_Router* router, 
-    char* path, 
-    Http_Method method, 
-    Ws_Handler handler,
-    Ws_Handler middleware
-)
-{
-    CHECK(path != NULL, "add handler null path");
-    CHECK(method >= 0 && method < HTTP_METHOD_INVALID, "add handler wrong method");
-    
-    Route* route = Ws_create_route(path, method, handler);
-    route->path = path;
-    route->method = method;
-    route->handler = handler;
-    route->middleware = middleware;
+/**
+ * Hold the handler while the engine's sink has more than WS_STREAM_MAX_QUEUED bytes left to send
+ */
+int
+Ws_stream_drain(Ws_Response_Stream* stream)
+{
+    if (stream->sink == NULL || stream->sink->drain == NULL) return 0;
+    if (stream->sink->drain(stream->sink->ctx, WS_STREAM_MAX_QUEUED) == 0) return 0;
+    stream->failed = true;
+    return -1;
+}
 
-    StringBuilder builder = {0};
-    Ju_str_append_null(&builder, Http_strmethod(method), path);
-    hm_put(&router->routes, builder.string, route);
-    Ju_builder_free(&builder);
+int
+Ws_stream_begin(Ws_Response_Stream* stream, Http_Request* req, Http_Response* res, Http_ContentType type)
+{
+    stream->fd = req->client_fd;
+    stream->buffer = (StringBuilder){ .arena = &req->arena };
+    stream->chunk_start = 0;
+    stream->chunk_open = false;
+    stream->chunked = req->version == HTTP_VERSION_1_1;
+    stream->sink = current_sink != NULL && current_sink->fd == stream->fd ? current_sink : NULL;
+    stream->failed = false;
+    // Without chunks, the end of the connection is the end of the body
+    if (!stream->chunked) res->keep_alive = false;
+    if (Http_get_response_header(res, "Content-Type") == NULL) {
+        Http_set_header(res, "Content-Type", Http_get_content_type(type));
+    }
+
+    Ws_Response_Writer writer;
+    Ws_writer_init(&writer);
+    Ws_writer_head(&writer, res);
+    if (stream->chunked) Ws_writer_put(&writer, "Transfer-Encoding: chunked\r\n", 28);
+    Ws_writer_put(&writer, "\r\n", 2);
+    if (!Ws_writer_finish(&writer)) {
+        stream->failed = true;
+        return -1;
+    }
+    return Ws_stream_append(stream, writer.head, writer.head_count);
+}
+
+int
+Ws_stream_write(Ws_Response_Stream* stream, const char* buf, size_t len)
+{
+    if (stream->failed) return -1;
+    // An empty chunk would end the body
+    if (len == 0) return 0;
+
+    if (len >= WS_STREAM_CHUNK_SIZE) {
+        // A chunk of its own, sent from buf behind what was buffered
+        if (Ws_stream_close_chunk(stream) != 0) return -1;
+        char line[32];
+        int line_len = stream->chunked ? snprintf(line, sizeof(line), "%zx\r\n", len) : 0;
+        struct iovec iov[] = {
+            { .iov_base = stream->buffer.string, .iov_len = stream->buffer.count },
+            { .iov_base = line, .iov_len = line_len },
+            { .iov_base = (char*)buf, .iov_len = len },
+            { .iov_base = "\r\n", .iov_len = stream->chunked ? 2 : 0 },
+        };
+        int ret = Ws_sendmsg_all(stream->fd, iov, 4, 0);
+        stream->buffer.count = 0;
+        if (ret != 0) {
+            stream->failed = true;
+            return ret;
+        }
+        return Ws_stream_drain(stream);
+    }
+
+    if (stream->chunked && !stream->chunk_open) {
+        stream->chunk_start = stream->buffer.count;
+        stream->chunk_open = true;
+        if (Ws_stream_append(stream, WS_STREAM_SIZE_LINE, sizeof(WS_STREAM_SIZE_LINE) - 1) != 0) return -1;
+    }
+    if (Ws_stream_append(stream, buf, len) != 0) return -1;
+    if (stream->buffer.count - stream->chunk_start < WS_STREAM_CHUNK_SIZE) return 0;
+    return Ws_stream_flush(stream);
+}
+
+int
+Ws_stream_flush(Ws_Response_Stream* stream)
+{
+    if (Ws_stream_close_chunk(stream) != 0) return -1;
+    if (stream->buffer.count == 0) return 0;
+    int ret = Ws_write_all(stream->fd, stream->buffer.string, stream->buffer.count);
+    stream->buffer.count = 0;
+    stream->chunk_start = 0;
+    if (ret != 0) {
+        stream->failed = true;
+        return ret;
+    }
+    return Ws_stream_drain(stream);
+}
+
+int
+Ws_stream_end(Ws_Response_Stream* stream)
+{
+    int ret = Ws_stream_close_chunk(stream);
+    if (ret == 0 && stream->chunked) ret = Ws_stream_append(stream, "0\r\n\r\n", 5);
+    if (ret == 0) ret = Ws_stream_flush(stream);
+    Ju_builder_free(&stream->buffer);
+    return ret;
+}
+
+/**
+ * Log a request: time in ms, status, http method, path
+ */
+void
+Ws_log_request(Http_Request* req, Http_Response* res) 
+{
+    INFO("%8.3f ms %-3d %-6s %s", req->request_timing, res->status, Http_strmethod(req->method), req->path);
 }
 
 bool
@@ -409,10 +880,7 @@ handle_not_found_request(Http_Request* request, Http_Response* res)
 int
 Ws_handle_request(Ws_Router* router, Http_Request* req, Http_Response* res)
 {
-    StringBuilder builder = {0};
-    Ju_str_append_null(&builder, Http_strmethod(req->method), req->path);
-    Route* route = hm_get(&router->routes, builder.string);
-    Ju_builder_free(&builder);
+    Route* route = Ws_router_match(router, req);
     if (route == NULL)
     {
         handle_not_found_request(req, res);
@@ -425,15 +893,22 @@ Ws_handle_request(Ws_Router* router, Http_Request* req, Http_Response* res)
                 return 0;
             }
         }
-        if (route->handler(route, req, res) < 0) {
-            ERROR("Internal server error: %s", route->path);
-            res->status = HTTP_STATUS_INTERNAL_SERVER_ERROR;
-            return Ws_send_response(req->client_fd, res);
-        }
+        if (route->handler(route, req, res) < 0) return Ws_send_handler_error(route, req, res);
         return 0;
     }
 }
 
+int
+Ws_send_handler_error(Route* route, Http_Request* req, Http_Response* res)
+{
+    ERROR("Internal server error: %s", route->path);
+    res->status = HTTP_STATUS_INTERNAL_SERVER_ERROR;
+    res->headers_count = 0;
+    // Part of a response may already be sent, the connection cannot be reused
+    res->keep_alive = false;
+    return Ws_send_response(req->client_fd, res);
+}
+
 /**
  * Time the start of a request
  */
@@ -454,90 +929,311 @@ Ws_end_request(Http_Request* request)
         (double)((request->end.tv_sec - request->start.tv_sec) * 1000000 + request->end.tv_usec - request->start.tv_usec) / 1000;
 }
 
-int
-Ws_run_server(Ws_Server* server)
+/**
+ * Answer a request that could not be parsed, the connection is then closed
+ *  An unknown version is answered with 505, anything else with 400
+ */
+void
+Ws_send_parse_error(Http_Request* req, Http_Response* res, Http_Error err)
+{
+    res->keep_alive = false;
+    res->status = err == HTTP_UNSUPPORTED_VERSION ? HTTP_STATUS_VERSION_NOT_SUPPORTED : HTTP_STATUS_BAD_REQUEST;
+    Ws_send_response(req->client_fd, res);
+}
+
+bool
+Ws_process_request(Ws_Server* server, Http_Request* req, char* buf, size_t len, bool keep_alive)
+{
+    Http_Response res = {0};
+    Ws_Worker* worker = Ws_current_worker();
+    if (worker != NULL) {
+        worker->stats.requests++;
+        req->arena.pool = &worker->arenas;
+    }
+
+    Http_Error ret = Http_parse_request(req, buf, len);
+    if (ret != HTTP_OK) {
+        Ws_send_parse_error(req, &res, ret);
+    } else {
+        res.keep_alive = keep_alive && Http_keep_alive(req);
+        Ws_handle_request(&server->router, req, &res);
+    }
+
+    Ws_end_request(req);
+    if (server->requests_logging) Ws_log_request(req, &res);
+    Http_free_request(req);
+    return res.keep_alive;
+}
+
+Route*
+Ws_body_route(Ws_Server* server, char* buf, size_t headers_len)
+{
+    char* method_end = memchr(buf, ' ', headers_len);
+    if (method_end == NULL) return NULL;
+    char* path = method_end + 1;
+    char* path_end = memchr(path, ' ', headers_len - (path - buf));
+    if (path_end == NULL) return NULL;
+
+    // Terminate the method and the path for the time of the lookup,
+    // the head is only parsed in place once the route is known
+    *method_end = '\0';
+    *path_end = '\0';
+    Http_Request peek = { .method = Http_parse_method(buf), .path = path };
+    Route* route = Ws_router_match(&server->router, &peek);
+    *method_end = ' ';
+    *path_end = ' ';
+    return route != NULL && route->body_handler != NULL ? route : NULL;
+}
+
+bool
+Ws_body_begin(Ws_Server* server, Http_Request* req, Route* route, char* buf, size_t headers_len, Http_Response* res, bool keep_alive)
+{
+    *res = (Http_Response){0};
+    Ws_Worker* worker = Ws_current_worker();
+    if (worker != NULL) {
+        worker->stats.requests++;
+        req->arena.pool = &worker->arenas;
+    }
+
+    char* body;
+    Http_Error ret = Http_parse_head(req, buf, headers_len, &body);
+    if (ret != HTTP_OK) {
+        Ws_send_parse_error(req, res, ret);
+        return false;
+    }
+    res->keep_alive = keep_alive && Http_keep_alive(req);
+    // Matched again on the parsed request to capture its path parameters
+    Ws_router_match(&server->router, req);
+    if (route->middleware != NULL && route->middleware(route, req, res)) {
+        // The rest of the body is not read, the connection can't be reused
+        res->keep_alive = false;
+        return false;
+    }
+    return true;
+}
+
+bool
+Ws_body_end(Ws_Server* server, Http_Request* req, Route* route, Http_Response* res, bool answered)
+{
+    if (!answered && route->handler(route, req, res) < 0) Ws_send_handler_error(route, req, res);
+
+    Ws_end_request(req);
+    if (server->requests_logging) Ws_log_request(req, res);
+    Http_free_request(req);
+    return res->keep_alive;
+}
+
+void
+Ws_body_abort(Route* route, Http_Request* req)
+{
+    route->body_handler(route, req, NULL, 0);
+    Http_free_request(req);
+}
+
+/**
+ * Wait for a socket to be readable
+ *  Returns false once the deadline armed in the worker's wheel passed
+ */
+bool
+Ws_fork_wait_readable(Ws_Worker* worker, int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    while (true) {
+        long now = Ws_now_ms();
+        if (Ws_timer_expire(&worker->timers, now) != NULL) return false;
+        int ret = poll(&pfd, 1, Ws_timer_wheel_timeout(&worker->timers, now));
+        // Interrupted by a signal, let the caller check stop_server
+        if (ret > 0 || (ret < 0 && errno == EINTR)) return true;
+        if (ret < 0) return false;
+    }
+}
+
+/**
+ * Send the response queued on a connection, waiting for its socket until the write deadline
+ *  Returns false if it could not be sent
+ */
+bool
+Ws_fork_flush(Ws_Worker* worker, Ws_Connection* conn)
 {
     int ret;
-    // size_t max_request_len = Ws_config_get_value(&server->config, "max_req_size");
+    while ((ret = Ws_connection_flush(conn)) == 0) {
+        // Sent bytes push the deadline back
+        Ws_connection_arm_timeout(worker, conn, WS_TIMEOUT_WRITE);
+        if (!Ws_connection_wait_writable(conn)) return false;
+    }
+    return ret > 0;
+}
 
-    INFO("Server ready, STOP with CTRL+C");
+/**
+ * Serve the requests of a connection until it is closed or one of its deadlines passes
+ *  The socket is non-blocking, reads and sends wait in poll for at most
+ *  what is left of the deadline armed in the worker's wheel
+ */
+void
+Ws_fork_serve(Ws_Server* server, int client_fd)
+{
+    Ws_Worker* worker = Ws_current_worker();
+    CHECK(worker != NULL, "Ws_fork_serve : no worker");
+    Ws_Connection* conn = Ws_connection_create(client_fd);
+    CHECK(conn != NULL, "Ws_fork_serve : connection alloc error");
+    Ws_set_nonblocking(client_fd);
+    // What the socket does not take of a response is sent before the next request
+    Ws_Sink sink;
+    Ws_connection_set_sink(&sink, conn);
+
+    bool keep_alive = true;
+    while (keep_alive && !stop_server) {
+        if (Ws_connection_pending(conn) && !Ws_fork_flush(worker, conn)) break;
+        size_t len;
+        Ws_Request_State state = Ws_connection_parse(server, conn, &len);
+        if (state >= WS_REQUEST_TOO_LARGE) {
+            Ws_connection_reject(server, conn, state);
+            break;
+        }
+        if (state == WS_REQUEST_COMPLETE) {
+            keep_alive = Ws_connection_serve(server, conn, len, true);
+            continue;
+        }
+
+        if (conn->count == 0) Ws_start_request(&conn->request);
+        size_t room = Ws_connection_reserve(server, conn, WS_BUFFER_MAX_LENGHT);
+        ssize_t ret = read(client_fd, conn->buffer + conn->count, room);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            Ws_connection_arm_timeout(worker, conn, Ws_connection_read_timeout(conn));
+            if (!Ws_fork_wait_readable(worker, client_fd)) break;
+            continue;
+        }
+        if (ret <= 0) {
+            // Peer closed its side, serve what was sent before closing
+            if (ret == 0 && conn->count > 0) Ws_connection_serve(server, conn, conn->count, false);
+            break;
+        }
+        conn->count += ret;
+    }
+    if (Ws_connection_pending(conn)) Ws_fork_flush(worker, conn);
+    Ws_set_sink(NULL);
+    Ws_timer_cancel(&worker->timers, &conn->timer);
+    Ws_connection_free(conn);
+}
+
+bool
+Ws_acquire_connection(Ws_Server* server)
+{
+    int count = atomic_load_explicit(&server->connections->count, memory_order_relaxed);
+    do {
+        if (count >= server->max_connections) return false;
+    } while (!atomic_compare_exchange_weak_explicit(&server->connections->count, &count, count + 1,
+        memory_order_relaxed, memory_order_relaxed));
+    return true;
+}
 
+void
+Ws_release_connection(Ws_Server* server)
+{
+    atomic_fetch_sub_explicit(&server->connections->count, 1, memory_order_relaxed);
+}
+
+/**
+ * Reap exited children, waiting for one if block is set
+ *  A child releases its slot before exiting, unless it was killed
+ */
+void
+Ws_fork_reap(Ws_Server* server, bool block)
+{
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, block ? 0 : WNOHANG)) != 0) {
+        if (pid < 0) {
+            // No child holds a slot anymore
+            if (errno == ECHILD) atomic_store(&server->connections->count, 0);
+            return;
+        }
+        if (WIFSIGNALED(status)) Ws_release_connection(server);
+        block = false;
+    }
+}
+
+/**
+ * Fork engine: accept in the parent, serve each connection in a child process
+ */
+int
+Ws_fork_run(Ws_Server* server)
+{
+    // Children are forked with the cache as it is when they are accepted
+    Ws_Worker worker;
+    Ws_worker_init(&worker, server, 0, server->sock_fd);
     while(!stop_server) {
-        sem_wait(server->connection_count_sem);
-        if(*server->connection_count == server->max_connections) {
+        Ws_fork_reap(server, false);
+        if (!Ws_acquire_connection(server)) {
+            // Stop accepting until a child exits rather than polling the listener
+            Ws_fork_reap(server, true);
             continue;
         }
-        sem_post(server->connection_count_sem);
         int client_fd = accept(server->sock_fd, NULL, NULL);
         if(client_fd < 0) {
+            Ws_release_connection(server);
             continue;
         }
+        worker.stats.connections++;
+        Ws_file_cache_refresh(&worker.files, &server->router);
 
-        Http_Request req = {
-            .client_fd = client_fd,
-            .method = HTTP_METHOD_INVALID
-        };
-        Http_Response res = {0};
-
-        Ws_start_request(&req);
-
-        sem_wait(server->connection_count_sem);
-        (*server->connection_count)++;
-        sem_post(server->connection_count_sem);
         pid_t childId = fork();
 
         if(childId == 0) {
-            char buf[WS_BUFFER_MAX_LENGHT+1];
-            Ws_read_request(client_fd, buf);
-
-            ret = Http_parse_request(&req, buf, WS_BUFFER_MAX_LENGHT+1);
-            
-            if(ret == HTTP_ERR_MALFORMED_REQ) {
-                res.status = HTTP_STATUS_BAD_REQUEST;
-                res.content = "Malformed header in the request";
-                Ws_send_response(req.client_fd, &res);
-            } else {
-                Ws_handle_request(&server->router, &req, &res);
-            }
+            if (worker.files.watch_fd >= 0) close(worker.files.watch_fd);
+            Ws_fork_serve(server, client_fd);
 
             // Close connection
             shutdown(client_fd, SHUT_RDWR);
             close(client_fd);
 
-            Ws_end_request(&req);
-            Ws_log_request(&req, &res);
-
-            sem_wait(server->connection_count_sem);
-            (*server->connection_count)--;
-            sem_post(server->connection_count_sem);
-
-            sem_close(server->connection_count_sem);
-            ret = shmdt(server->connection_count);
-            CHECK(ret == 0, "Ws_run_server : child shmdt error");
+            Ws_release_connection(server);
             exit(0);
         } else {
+            if (childId < 0) Ws_release_connection(server);
             close(client_fd);
         }
     }
 
+    // Requests are counted by the children, only the accepts are known here
+    INFO("Accepted %lu connections", worker.stats.connections);
+    Ws_file_cache_free(&worker.files);
     int status;
     while (wait(&status) > 0);
+    return EXIT_SUCCESS;
+}
+
+int
+Ws_run_server(Ws_Server* server)
+{
+    int ret;
 
-    sem_close(server->connection_count_sem);
-    sem_unlink(SEM_NAME);
-    shmdt(server->connection_count);
-    shmctl(server->connection_count_shm_id, IPC_RMID, NULL);
+    INFO("Server ready, STOP with CTRL+C");
 
-    for (size_t i = 0; i < server->router.routes.size; ++i)
-    {
-        HashMapEntry* entry = server->router.routes.entries[i];
-        if (entry != NULL)
-        {
-            free(entry->value);
-        }
+    switch (server->engine) {
+        case WS_ENGINE_EPOLL:
+        case WS_ENGINE_URING:
+            ret = Ws_workers_run(server);
+            break;
+        case WS_ENGINE_FORK:
+        case WS_ENGINE_INVALID:
+        default:
+            ret = Ws_fork_run(server);
+            break;
     }
 
+    munmap(server->connections, sizeof(Ws_Connection_Counter));
+    close(server->sock_fd);
+    if (server->worker_fds != NULL) {
+        for (int i = 0; i < server->worker_count; i++) close(server->worker_fds[i]);
+        free(server->worker_fds);
+    }
+    free(server->cpu_list);
+
+    Ws_router_free(&server->router);
+
     INFO("Stopping server");
 
-    return EXIT_SUCCESS;
+    return ret;
 }
\ No newline at end of file
@@ -16,43 +16,52 @@ rotru64(uint64_t value, size_t size, int shift)
     return (value >> shift) | (value << (size - shift));
 }
 
+/**
+ * Pad a message for hashing without copying it
+ *  Only the last partial block of input and the padding are written to tail,
+ *  which must hold two blocks, the full blocks before are hashed in place.
+ *  full_len is set to the length of those full blocks
+ */
 void
 shapad(const uint8_t *input, size_t input_len, 
-    uint8_t **padded_message, size_t *padded_len, const size_t block_size)
+    uint8_t *tail, size_t *full_len, size_t *padded_len, const size_t block_size)
 {
     size_t bit_len = input_len * 8;
     size_t pad_len = ((bit_len + block_size + (block_size / 8)) 
         / block_size) * (block_size / 8) - input_len;
     *padded_len = input_len + pad_len;
-    *padded_message = (uint8_t*)malloc(*padded_len);
+    *full_len = input_len - input_len % (block_size / 8);
 
-    memcpy(*padded_message, input, input_len);
-    (*padded_message)[input_len] = 0x80;
-    memset(*padded_message + input_len + 1, 0, pad_len - 1 - 8);
+    size_t rest = input_len - *full_len;
+    size_t tail_len = *padded_len - *full_len;
+    memcpy(tail, input + *full_len, rest);
+    tail[rest] = 0x80;
+    memset(tail + rest + 1, 0, tail_len - rest - 1 - 8);
 
     for (int i = 0; i < 8; i++) {
-        (*padded_message)[*padded_len - 1 - i] 
-            = (bit_len >> (8 * i)) & 0xFF;
+        tail[tail_len - 1 - i] = (bit_len >> (8 * i)) & 0xFF;
     }
 }
 
 int
 sha256(uint8_t *output, const uint8_t *input, size_t input_len)
 {
-    uint8_t *padded_message;
+    uint8_t tail[2 * SHA256_BLOCK_SIZE / 8];
+    size_t full_len;
     size_t padded_len;
-    shapad(input, input_len, &padded_message, &padded_len, SHA256_BLOCK_SIZE);
+    shapad(input, input_len, tail, &full_len, &padded_len, SHA256_BLOCK_SIZE);
 
     uint32_t h[8];
     memcpy(h, sha_256_H, sizeof(sha_256_H));
 
     for (size_t i = 0; i < padded_len; i += 64) {
+        const uint8_t *block = i < full_len ? input + i : tail + (i - full_len);
         uint32_t w[64] = {0};
         for (size_t j = 0; j < 16; j++) {
-            w[j] = (padded_message[i + 4 * j + 0] << 24) |
-                   (padded_message[i + 4 * j + 1] << 16) |
-                   (padded_message[i + 4 * j + 2] << 8) |
-                   (padded_message[i + 4 * j + 3]);
+            w[j] = ((uint32_t)block[4 * j + 0] << 24) |
+                   (block[4 * j + 1] << 16) |
+                   (block[4 * j + 2] << 8) |
+                   (block[4 * j + 3]);
         }
 
         for (size_t j = 16; j < 64; j++) {
@@ -110,8 +119,6 @@ sha256(uint8_t *output, const uint8_t *input, size_t input_len)
         h[7] += hh;
     }
 
-    free(padded_message);
-
     for (int i = 0; i < 8; i++) {
         output[4 * i + 0] = (h[i] >> 24) & 0xFF;
         output[4 * i + 1] = (h[i] >> 16) & 0xFF;
@@ -125,24 +132,26 @@ sha256(uint8_t *output, const uint8_t *input, size_t input_len)
 int
 sha384(uint8_t *output, const uint8_t *input, size_t input_len)
 {
-    uint8_t *padded_message;
+    uint8_t tail[2 * SHA512_BLOCK_SIZE / 8];
+    size_t full_len;
     size_t padded_len;
-    shapad(input, input_len, &padded_message, &padded_len, SHA512_BLOCK_SIZE);
+    shapad(input, input_len, tail, &full_len, &padded_len, SHA512_BLOCK_SIZE);
 
     uint64_t h[8];
     memcpy(h, sha_384_H, sizeof(sha_384_H));
 
     for (size_t i = 0; i < padded_len; i += 128) {
+        const uint8_t *block = i < full_len ? input + i : tail + (i - full_len);
         uint64_t w[80] = {0};
         for (size_t j = 0; j < 16; j++) {
-            w[j] = ((uint64_t)padded_message[i + 8 * j + 0] << 56) |
-                   ((uint64_t)padded_message[i + 8 * j + 1] << 48) |
-                   ((uint64_t)padded_message[i + 8 * j + 2] << 40) |
-                   ((uint64_t)padded_message[i + 8 * j + 3] << 32) |
-                   ((uint64_t)padded_message[i + 8 * j + 4] << 24) |
-                   ((uint64_t)padded_message[i + 8 * j + 5] << 16) |
-                   ((uint64_t)padded_message[i + 8 * j + 6] << 8) |
-                   ((uint64_t)padded_message[i + 8 * j + 7]);
+            w[j] = ((uint64_t)block[8 * j + 0] << 56) |
+                   ((uint64_t)block[8 * j + 1] << 48) |
+                   ((uint64_t)block[8 * j + 2] << 40) |
+                   ((uint64_t)block[8 * j + 3] << 32) |
+                   ((uint64_t)block[8 * j + 4] << 24) |
+                   ((uint64_t)block[8 * j + 5] << 16) |
+                   ((uint64_t)block[8 * j + 6] << 8) |
+                   ((uint64_t)block[8 * j + 7]);
         }
 
         for (size_t j = 16; j < 80; j++) {
@@ -200,8 +209,6 @@ sha384(uint8_t *output, const uint8_t *input, size_t input_len)
         h[7] += hh;
     }
 
-    free(padded_message);
-
     for (int i = 0; i < 6; i++) {
         output[8 * i + 0] = (h[i] >> 56) & 0xFF;
         output[8 * i + 1] = (h[i] >> 48) & 0xFF;
@@ -219,24 +226,26 @@ sha384(uint8_t *output, const uint8_t *input, size_t input_len)
 int
 sha512(uint8_t *output, const uint8_t *input, size_t input_len)
 {
-    uint8_t *padded_message;
+    uint8_t tail[2 * SHA512_BLOCK_SIZE / 8];
+    size_t full_len;
     size_t padded_len;
-    shapad(input, input_len, &padded_message, &padded_len, SHA512_BLOCK_SIZE);
+    shapad(input, input_len, tail, &full_len, &padded_len, SHA512_BLOCK_SIZE);
 
     uint64_t h[8];
     memcpy(h, sha_512_H, sizeof(sha_512_H));
 
     for (size_t i = 0; i < padded_len; i += 128) {
+        const uint8_t *block = i < full_len ? input + i : tail + (i - full_len);
         uint64_t w[80] = {0};
         for (size_t j = 0; j < 16; j++) {
-            w[j] = ((uint64_t)padded_message[i + 8 * j + 0] << 56) |
-                   ((uint64_t)padded_message[i + 8 * j + 1] << 48) |
-                   ((uint64_t)padded_message[i + 8 * j + 2] << 40) |
-                   ((uint64_t)padded_message[i + 8 * j + 3] << 32) |
-                   ((uint64_t)padded_message[i + 8 * j + 4] << 24) |
-                   ((uint64_t)padded_message[i + 8 * j + 5] << 16) |
-                   ((uint64_t)padded_message[i + 8 * j + 6] << 8) |
-                   ((uint64_t)padded_message[i + 8 * j + 7]);
+            w[j] = ((uint64_t)block[8 * j + 0] << 56) |
+                   ((uint64_t)block[8 * j + 1] << 48) |
+                   ((uint64_t)block[8 * j + 2] << 40) |
+                   ((uint64_t)block[8 * j + 3] << 32) |
+                   ((uint64_t)block[8 * j + 4] << 24) |
+                   ((uint64_t)block[8 * j + 5] << 16) |
+                   ((uint64_t)block[8 * j + 6] << 8) |
+                   ((uint64_t)block[8 * j + 7]);
         }
 
         for (size_t j = 16; j < 80; j++) {
@@ -294,8 +303,6 @@ sha512(uint8_t *output, const uint8_t *input, size_t input_len)
         h[7] += hh;
     }
 
-    free(padded_message);
-
     for (int i = 0; i < 8; i++) {
         output[8 * i + 0] = (h[i] >> 56) & 0xFF;
         output[8 * i + 1] = (h[i] >> 48) & 0xFF;
@@ -0,0 +1,166 @@
+#include "timer.h"
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+void
+Ws_timer_wheel_init(Ws_Timer_Wheel* wheel, long now)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->tick = now / WS_TIMER_TICK_MS;
+}
+
+/**
+ * Link a timer in the slot of its deadline, relative to the current tick
+ */
+void
+Ws_timer_place(Ws_Timer_Wheel* wheel, Ws_Timer* timer)
+{
+    unsigned long expires = timer->expires < wheel->tick ? wheel->tick : timer->expires;
+    unsigned long delta = expires - wheel->tick;
+    int level = 0;
+    while (level < WS_TIMER_LEVELS - 1 && delta >> (WS_TIMER_SLOT_BITS * (level + 1)) != 0) level++;
+    // Past the last level, wait in its furthest slot and be placed again when it is reached
+    unsigned long range = 1UL << (WS_TIMER_SLOT_BITS * WS_TIMER_LEVELS);
+    if (delta >= range) expires = wheel->tick + range - 1;
+
+    int slot = (expires >> (WS_TIMER_SLOT_BITS * level)) & WS_TIMER_SLOT_MASK;
+    Ws_Timer** head = &wheel->slots[level][slot];
+    timer->level = level;
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL) (*head)->prev = timer;
+    *head = timer;
+    wheel->pending[level] |= 1ULL << slot;
+}
+
+void
+Ws_timer_arm(Ws_Timer_Wheel* wheel, Ws_Timer* timer, long now, long timeout)
+{
+    Ws_timer_cancel(wheel, timer);
+    unsigned long now_tick = now / WS_TIMER_TICK_MS;
+    // An empty wheel catches up with the clock without going through the ticks
+    if (wheel->count == 0 && now_tick > wheel->tick) wheel->tick = now_tick;
+    // Rounded up, a timer never fires before its deadline
+    timer->expires = (now + timeout + WS_TIMER_TICK_MS - 1) / WS_TIMER_TICK_MS;
+    timer->armed = true;
+    Ws_timer_place(wheel, timer);
+    wheel->count++;
+}
+
+void
+Ws_timer_cancel(Ws_Timer_Wheel* wheel, Ws_Timer* timer)
+{
+    if (!timer->armed) return;
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        wheel->slots[timer->level][timer->slot] = timer->next;
+        if (timer->next == NULL) wheel->pending[timer->level] &= ~(1ULL << timer->slot);
+    }
+    if (timer->next != NULL) timer->next->prev = timer->prev;
+    timer->prev = NULL;
+    timer->next = NULL;
+    timer->armed = false;
+    wheel->count--;
+}
+
+/**
+ * Move the timers of the higher level slots starting at the current tick down the wheel
+ */
+void
+Ws_timer_cascade(Ws_Timer_Wheel* wheel)
+{
+    for (int level = 1; level < WS_TIMER_LEVELS; level++) {
+        int slot = (wheel->tick >> (WS_TIMER_SLOT_BITS * level)) & WS_TIMER_SLOT_MASK;
+        Ws_Timer* timer = wheel->slots[level][slot];
+        wheel->slots[level][slot] = NULL;
+        wheel->pending[level] &= ~(1ULL << slot);
+        while (timer != NULL) {
+            Ws_Timer* next = timer->next;
+            Ws_timer_place(wheel, timer);
+            timer = next;
+        }
+        // A level only turns when the one below it wraps around
+        if (slot != 0) break;
+    }
+}
+
+Ws_Timer*
+Ws_timer_expire(Ws_Timer_Wheel* wheel, long now)
+{
+    unsigned long target = now / WS_TIMER_TICK_MS;
+    while (wheel->tick <= target) {
+        if (wheel->count == 0) {
+            wheel->tick = target + 1;
+            break;
+        }
+        int slot = wheel->tick & WS_TIMER_SLOT_MASK;
+        Ws_Timer* timer = wheel->slots[0][slot];
+        if (timer != NULL) {
+            Ws_timer_cancel(wheel, timer);
+            return timer;
+        }
+        // Skip the rest of the level 0 turn when nothing is due in it
+        unsigned long next = wheel->pending[0] >> slot == 0
+            ? (wheel->tick | WS_TIMER_SLOT_MASK) + 1
+            : wheel->tick + 1;
+        wheel->tick = next < target + 1 ? next : target + 1;
+        if ((wheel->tick & WS_TIMER_SLOT_MASK) == 0) Ws_timer_cascade(wheel);
+    }
+    return NULL;
+}
+
+Ws_Timer*
+Ws_timer_pop(Ws_Timer_Wheel* wheel)
+{
+    for (int level = 0; level < WS_TIMER_LEVELS; level++) {
+        if (wheel->pending[level] == 0) continue;
+        Ws_Timer* timer = wheel->slots[level][__builtin_ctzll(wheel->pending[level])];
+        Ws_timer_cancel(wheel, timer);
+        return timer;
+    }
+    return NULL;
+}
+
+int
+Ws_timer_left(Ws_Timer* timer, long now)
+{
+    if (!timer->armed) return -1;
+    long left = (long)(timer->expires * WS_TIMER_TICK_MS) - now;
+    if (left < 0) return 0;
+    return left > INT_MAX ? INT_MAX : (int)left;
+}
+
+int
+Ws_timer_wheel_timeout(Ws_Timer_Wheel* wheel, long now)
+{
+    if (wheel->count == 0) return -1;
+    // Earliest tick at which a level 0 slot fires or a higher level slot cascades
+    unsigned long next = ULONG_MAX;
+    for (int level = 0; level < WS_TIMER_LEVELS; level++) {
+        uint64_t pending = wheel->pending[level];
+        if (pending == 0) continue;
+        int shift = WS_TIMER_SLOT_BITS * level;
+        unsigned long base = wheel->tick >> shift;
+        int slot = base & WS_TIMER_SLOT_MASK;
+        // Rotate the current slot to bit 0, the first set bit is then the nearest slot
+        uint64_t rotated = slot == 0 ? pending : (pending >> slot) | (pending << (WS_TIMER_SLOTS - slot));
+        unsigned long at;
+        if (level == 0) {
+            at = wheel->tick + __builtin_ctzll(rotated);
+        } else {
+            // The current slot of a higher level was already cascaded this turn,
+            // what it holds comes down a whole turn later
+            uint64_t later = rotated & ~1ULL;
+            unsigned long distance = later != 0 ? (unsigned long)__builtin_ctzll(later) : WS_TIMER_SLOTS;
+            at = (base + distance) << shift;
+        }
+        if (at < next) next = at;
+    }
+
+    long timeout = (long)(next * WS_TIMER_TICK_MS) - now;
+    if (timeout < 0) return 0;
+    return timeout > INT_MAX ? INT_MAX : (int)timeout;
+}
@@ -30,18 +30,14 @@ Toki_token_init(Toki_Token* token, Toki_Alg algorithm)
     token->algorithm = algorithm;
 
     const char* str_alg = Toki_stralg(algorithm);
-    Jacon_Node* alg = calloc(1, sizeof(Jacon_Node));
-    alg->type = JACON_VALUE_STRING;
-    alg->name = "alg";
-    alg->value.string_val = (char*)str_alg;
+    if (str_alg == NULL) return TOKI_ERR_UNSUPPORTED_ALGORITHM;
 
-    Jacon_Node* typ = calloc(1, sizeof(Jacon_Node));
-    typ->type = JACON_VALUE_STRING;
-    typ->name = "typ";
-    typ->value.string_val = "JWT";
+    // Claims are copied into the header, which owns them from then on
+    Jacon_Node alg = Jacon_string_prop("alg", str_alg);
+    Jacon_Node typ = Jacon_string_prop("typ", "JWT");
 
-    Jacon_append_child(&token->header, alg);
-    Jacon_append_child(&token->header, typ);
+    Jacon_append_child(&token->header, &alg);
+    Jacon_append_child(&token->header, &typ);
 
     return TOKI_OK;
 }
@@ -79,21 +75,21 @@ Toki_hash_params(Toki_Alg algorithm, size_t* block_size, size_t* digest_size, vo
 }
 
 Toki_Error
-Toki_sign_token(Toki_Token* token, const char* key, char** signed_token)
+Toki_sign_token(Toki_Token* token, const char* key, Ju_Arena* arena, char** signed_token)
 {
     int ret;
     char* header; 
-    Jacon_serialize_unformatted(&token->header, &header);
+    Jacon_serialize_unformatted(&token->header, arena, &header);
     
     char* payload; 
-    Jacon_serialize_unformatted(&token->payload, &payload);
+    Jacon_serialize_unformatted(&token->payload, arena, &payload);
 
     char* base64_header;
-    Base64Url_encode((const unsigned char*)header, strlen(header), &base64_header); 
+    Base64Url_encode((const unsigned char*)header, strlen(header), arena, &base64_header); 
     char* base64_payload;
-    Base64Url_encode((const unsigned char*)payload, strlen(payload), &base64_payload); 
+    Base64Url_encode((const unsigned char*)payload, strlen(payload), arena, &base64_payload); 
 
-    StringBuilder builder = {0};
+    StringBuilder builder = { .arena = arena };
 
     Ju_str_append_fmt_null(&builder, "%s.%s", base64_header, base64_payload);
 
@@ -105,27 +101,27 @@ Toki_sign_token(Toki_Token* token, const char* key, char** signed_token)
         return TOKI_ERR_UNSUPPORTED_ALGORITHM;
     }
     digest_size /= 8; // Size in bytes
-    char* signature = hmac(builder.string, key, hash_func, block_size/ 8, digest_size);
+    char* signature = hmac(builder.string, key, hash_func, block_size/ 8, digest_size, arena);
 
     char* base64_signature;
-    Base64Url_encode((const unsigned char*)signature, strlen(signature), &base64_signature);
+    Base64Url_encode((const unsigned char*)signature, strlen(signature), arena, &base64_signature);
     Ju_str_append_fmt_null(&builder, ".%s", base64_signature);
 
-    *signed_token = strdup(builder.string);
+    // The builder's string is handed over as is
+    *signed_token = builder.string;
 
-    Ju_builder_free(&builder);
-    free(header);
-    free(payload);
-    free(base64_header);
-    free(base64_payload);
-    free(signature);
-    free(base64_signature);
+    Ju_free(arena, header);
+    Ju_free(arena, payload);
+    Ju_free(arena, base64_header);
+    Ju_free(arena, base64_payload);
+    Ju_free(arena, signature);
+    Ju_free(arena, base64_signature);
 
     return TOKI_OK;
 }
 
 bool
-Toki_validate_token(const char* token)
+Toki_validate_token(const char* token, Ju_Arena* arena)
 {
     char *last_dot = strrchr(token, '.');
     if (last_dot == NULL) return false;
@@ -134,17 +130,20 @@ Toki_validate_token(const char* token)
     char *signature = last_dot + 1;
     unsigned char *base64_decoded;
     size_t decoded_len;
-    Base64Url_decode((const char*)signature, &decoded_len, &base64_decoded);
+    Base64Url_decode((const char*)signature, &decoded_len, arena, &base64_decoded);
 
     // TODO : extract algorithm from token using Jacon to get right params
-    char* verified_signature = hmac(header_payload, "secret", sha256, SHA256_BLOCK_SIZE / 8, SHA256_DIGEST_SIZE);
-    return strcmp((char*)base64_decoded, verified_signature) == 0;
+    char* verified_signature = hmac(header_payload, "secret", sha256, SHA256_BLOCK_SIZE / 8, SHA256_DIGEST_SIZE, arena);
+    bool valid = strcmp((char*)base64_decoded, verified_signature) == 0;
+    Ju_free(arena, base64_decoded);
+    Ju_free(arena, verified_signature);
+    return valid;
 }
 
 bool
-Toki_verify_token(const char* token)
+Toki_verify_token(const char* token, Ju_Arena* arena)
 {
-    if (!Toki_validate_token(token)) return false;
+    if (!Toki_validate_token(token, arena)) return false;
     
     // TODO : Additionnal verifications
     // expire time, ...
@@ -0,0 +1,741 @@
+#define _GNU_SOURCE
+#include "uring.h"
+#include "file_cache.h"
+#include "jutils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+// Engine of the worker running on this thread, the sink waits on its ring
+_Thread_local Ws_Uring* current_uring = NULL;
+
+int
+Ws_io_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int
+Ws_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, size_t arg_size)
+{
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+/**
+ * Create the ring and map its queues
+ */
+int
+Ws_uring_init(Ws_Uring* uring)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    int ring_fd = Ws_io_uring_setup(WS_URING_ENTRIES, &params);
+    if (ring_fd < 0 && errno == EINVAL) {
+        // Kernel older than 6.0, retry without the optimization flags
+        memset(&params, 0, sizeof(params));
+        ring_fd = Ws_io_uring_setup(WS_URING_ENTRIES, &params);
+    }
+    if (ring_fd < 0) return -1;
+    uring->ring_fd = ring_fd;
+
+    uring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        if (uring->cq_size > uring->sq_size) uring->sq_size = uring->cq_size;
+        uring->cq_size = uring->sq_size;
+    }
+
+    uring->sq_ptr = mmap(NULL, uring->sq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (uring->sq_ptr == MAP_FAILED) return -1;
+    if (single_mmap) {
+        uring->cq_ptr = uring->sq_ptr;
+    } else {
+        uring->cq_ptr = mmap(NULL, uring->cq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (uring->cq_ptr == MAP_FAILED) return -1;
+    }
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (uring->sqes == MAP_FAILED) return -1;
+
+    char* sq = uring->sq_ptr;
+    uring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    uring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    uring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    uring->sq_entries = params.sq_entries;
+    uring->sq_local_tail = *uring->sq_tail;
+
+    char* cq = uring->cq_ptr;
+    uring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    uring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    uring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    uring->buffers = malloc((size_t)WS_URING_BUFFER_COUNT * WS_BUFFER_MAX_LENGHT);
+    if (uring->buffers == NULL) return -1;
+
+    uring->accept_multishot = true;
+    uring->ext_arg = params.features & IORING_FEAT_EXT_ARG;
+    return 0;
+}
+
+void
+Ws_uring_free(Ws_Uring* uring)
+{
+    munmap(uring->sqes, uring->sqes_size);
+    if (uring->cq_ptr != uring->sq_ptr) munmap(uring->cq_ptr, uring->cq_size);
+    munmap(uring->sq_ptr, uring->sq_size);
+    close(uring->ring_fd);
+    free(uring->buffers);
+    free(uring->deferred);
+}
+
+struct io_uring_sqe*
+Ws_uring_get_sqe(Ws_Uring* uring, Ws_Connection* conn, Ws_Uring_Op op);
+
+/**
+ * Hand queued submissions to the kernel and wait for wait_count completions,
+ *  or for timeout milliseconds if it is not -1
+ */
+int
+Ws_uring_submit(Ws_Uring* uring, unsigned wait_count, int timeout)
+{
+    bool timed = wait_count > 0 && timeout >= 0;
+    if (timed) {
+        uring->wait_timeout.tv_sec = timeout / 1000;
+        uring->wait_timeout.tv_nsec = timeout % 1000 * 1000000L;
+    }
+    if (timed && !uring->ext_arg) {
+        // Kernel older than 5.11, a timeout completing with the first completion wakes the wait
+        struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, NULL, WS_URING_OP_IGNORE);
+        if (sqe != NULL) {
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->addr = (__u64)(uintptr_t)&uring->wait_timeout;
+            sqe->len = 1;
+            sqe->off = 1;
+        }
+    }
+
+    __atomic_store_n(uring->sq_tail, uring->sq_local_tail, __ATOMIC_RELEASE);
+    unsigned to_submit = uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+    if (to_submit == 0 && wait_count == 0) return 0;
+    unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (!timed || !uring->ext_arg) return Ws_io_uring_enter(uring->ring_fd, to_submit, wait_count, flags, NULL, 0);
+
+    struct io_uring_getevents_arg arg = { .ts = (__u64)(uintptr_t)&uring->wait_timeout };
+    return Ws_io_uring_enter(uring->ring_fd, to_submit, wait_count, flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+/**
+ * Make room for count submissions, flushing the queue if needed
+ *  A linked chain must be queued without a flush in the middle
+ */
+bool
+Ws_uring_reserve(Ws_Uring* uring, unsigned count)
+{
+    if (count > uring->sq_entries) return false;
+    unsigned used = uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+    if (uring->sq_entries - used >= count) return true;
+    Ws_uring_submit(uring, 0, -1);
+    used = uring->sq_local_tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+    return uring->sq_entries - used >= count;
+}
+
+struct io_uring_sqe*
+Ws_uring_get_sqe(Ws_Uring* uring, Ws_Connection* conn, Ws_Uring_Op op)
+{
+    if (!Ws_uring_reserve(uring, 1)) return NULL;
+    unsigned index = uring->sq_local_tail & *uring->sq_mask;
+    struct io_uring_sqe* sqe = &uring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (__u64)(uintptr_t)conn | op;
+    uring->sq_array[index] = index;
+    uring->sq_local_tail++;
+    return sqe;
+}
+
+void
+Ws_uring_arm_accept(Ws_Uring* uring)
+{
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, NULL, WS_URING_OP_ACCEPT);
+    if (sqe == NULL) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = uring->worker->sock_fd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (uring->accept_multishot) sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    uring->accept_armed = true;
+}
+
+void
+Ws_uring_cancel_accept(Ws_Uring* uring)
+{
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, NULL, WS_URING_OP_IGNORE);
+    if (sqe == NULL) return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (__u64)(uintptr_t)NULL | WS_URING_OP_ACCEPT;
+    uring->accept_cancelling = true;
+}
+
+/**
+ * Poll the file cache watch, the completion reloads the changed files
+ */
+void
+Ws_uring_arm_watch(Ws_Uring* uring)
+{
+    if (uring->worker->files.watch_fd < 0) return;
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, NULL, WS_URING_OP_WATCH);
+    if (sqe == NULL) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = uring->worker->files.watch_fd;
+    sqe->poll32_events = POLLIN;
+}
+
+/**
+ * Give count receive buffers starting at bid back to the kernel
+ */
+void
+Ws_uring_provide_buffers(Ws_Uring* uring, int bid, int count)
+{
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, NULL, WS_URING_OP_IGNORE);
+    if (sqe == NULL) return;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = count;
+    sqe->addr = (__u64)(uintptr_t)(uring->buffers + (size_t)bid * WS_BUFFER_MAX_LENGHT);
+    sqe->len = WS_BUFFER_MAX_LENGHT;
+    sqe->off = bid;
+    sqe->buf_group = WS_URING_BUFFER_GROUP;
+}
+
+void
+Ws_uring_close(Ws_Uring* uring, Ws_Connection* conn)
+{
+    Ws_timer_cancel(&uring->worker->timers, &conn->timer);
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, conn, WS_URING_OP_CLOSE);
+    if (sqe == NULL) {
+        close(conn->fd);
+        Ws_connection_free(conn);
+        uring->connection_count--;
+        return;
+    }
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = conn->fd;
+}
+
+/**
+ * Receive on a connection, under the deadline of what it waits for
+ */
+void
+Ws_uring_recv(Ws_Uring* uring, Ws_Connection* conn)
+{
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, conn, WS_URING_OP_RECV);
+    if (sqe == NULL) {
+        Ws_uring_close(uring, conn);
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->len = WS_BUFFER_MAX_LENGHT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = WS_URING_BUFFER_GROUP;
+    Ws_connection_arm_timeout(uring->worker, conn, Ws_connection_read_timeout(conn));
+}
+
+int
+Ws_uring_sink_write(void* ctx, struct iovec* iov, int count, int flags)
+{
+    (void)flags;
+    Ws_Connection* conn = ctx;
+    for (int i = 0; i < count; i++) {
+        if (Ju_str_append_len(&conn->output, iov[i].iov_base, iov[i].iov_len) != JU_OK) return -1;
+    }
+    return 0;
+}
+
+int
+Ws_uring_sink_send_file(void* ctx, int filefd, size_t size)
+{
+    Ws_Connection* conn = ctx;
+    if (conn->file_fd != -1) close(conn->file_fd);
+    conn->file_fd = filefd;
+    conn->file_size = size;
+    return 0;
+}
+
+/**
+ * Queue a link of conn's response chain, the last one ends the chain
+ */
+struct io_uring_sqe*
+Ws_uring_queue_link(Ws_Uring* uring, Ws_Connection* conn, Ws_Uring_Op op, bool last)
+{
+    struct io_uring_sqe* sqe = Ws_uring_get_sqe(uring, conn, op);
+    if (!last) sqe->flags = IOSQE_IO_LINK;
+    conn->in_flight++;
+    return sqe;
+}
+
+/**
+ * Queue what is left of the response captured by the sink as one linked chain:
+ *  send(head and content) -> [splice(file -> pipe) -> splice(pipe -> socket)]...
+ *  A short link cancels the rest of the chain, every completion records the
+ *  bytes it moved and the last one queues a new chain from there
+ */
+void
+Ws_uring_respond(Ws_Uring* uring, Ws_Connection* conn)
+{
+    size_t output_left = conn->output.count - conn->output_sent;
+    // Bytes a short splice to the socket left in the pipe
+    size_t piped = conn->file_piped - conn->file_sent;
+    size_t chunk_size = 0;
+    size_t chunks = 0;
+    if (conn->file_fd != -1 && conn->file_size > 0) {
+        if (conn->pipe_fds[0] == -1) {
+            if (pipe2(conn->pipe_fds, O_CLOEXEC) != 0) {
+                Ws_uring_close(uring, conn);
+                return;
+            }
+            fcntl(conn->pipe_fds[1], F_SETPIPE_SZ, WS_URING_PIPE_SIZE);
+        }
+        int pipe_size = fcntl(conn->pipe_fds[1], F_GETPIPE_SZ);
+        chunk_size = pipe_size > 0 ? (size_t)pipe_size : 65536;
+        chunks = (conn->file_size - conn->file_piped + chunk_size - 1) / chunk_size;
+    }
+
+    unsigned count = (output_left > 0) + (piped > 0) + 2 * chunks;
+    if (count == 0 || !Ws_uring_reserve(uring, count)) {
+        Ws_uring_close(uring, conn);
+        return;
+    }
+    Ws_connection_arm_timeout(uring->worker, conn, WS_TIMEOUT_WRITE);
+
+    unsigned queued = 0;
+    struct io_uring_sqe* sqe;
+    if (output_left > 0) {
+        queued++;
+        sqe = Ws_uring_queue_link(uring, conn, WS_URING_OP_SEND, queued == count);
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = conn->fd;
+        sqe->addr = (__u64)(uintptr_t)(conn->output.string + conn->output_sent);
+        sqe->len = output_left;
+        // Held back to leave in the same segment as the start of the file,
+        // and retried by the kernel until it is all sent
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL | (queued < count ? MSG_MORE : 0);
+    }
+    if (piped > 0) {
+        queued++;
+        sqe = Ws_uring_queue_link(uring, conn, WS_URING_OP_SPLICE_OUT, queued == count);
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->splice_fd_in = conn->pipe_fds[0];
+        sqe->splice_off_in = (__u64)-1;
+        sqe->fd = conn->fd;
+        sqe->off = (__u64)-1;
+        sqe->len = piped;
+        if (queued < count) sqe->splice_flags = SPLICE_F_MORE;
+    }
+    for (size_t i = 0; i < chunks; i++) {
+        size_t offset = conn->file_piped + i * chunk_size;
+        size_t len = conn->file_size - offset < chunk_size ? conn->file_size - offset : chunk_size;
+
+        queued++;
+        sqe = Ws_uring_queue_link(uring, conn, WS_URING_OP_SPLICE_IN, false);
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->splice_fd_in = conn->file_fd;
+        sqe->splice_off_in = offset;
+        sqe->fd = conn->pipe_fds[1];
+        sqe->off = (__u64)-1;
+        sqe->len = len;
+
+        queued++;
+        sqe = Ws_uring_queue_link(uring, conn, WS_URING_OP_SPLICE_OUT, queued == count);
+        sqe->opcode = IORING_OP_SPLICE;
+        sqe->splice_fd_in = conn->pipe_fds[0];
+        sqe->splice_off_in = (__u64)-1;
+        sqe->fd = conn->fd;
+        sqe->off = (__u64)-1;
+        sqe->len = len;
+        if (queued < count) sqe->splice_flags = SPLICE_F_MORE;
+    }
+}
+
+int
+Ws_uring_expire(Ws_Uring* uring);
+
+/**
+ * Keep a completion for the event loop, it can't be handled while a handler runs
+ */
+void
+Ws_uring_defer(Ws_Uring* uring, const struct io_uring_cqe* cqe)
+{
+    if (uring->deferred_count == uring->deferred_capacity) {
+        size_t capacity = uring->deferred_capacity > 0 ? uring->deferred_capacity * 2 : 64;
+        struct io_uring_cqe* deferred = realloc(uring->deferred, capacity * sizeof(*deferred));
+        CHECK(deferred != NULL, "Ws_uring_defer : completion alloc error");
+        uring->deferred = deferred;
+        uring->deferred_capacity = capacity;
+    }
+    uring->deferred[uring->deferred_count++] = *cqe;
+}
+
+/**
+ * Reap the completions available, recording the sends of conn and deferring the rest
+ */
+void
+Ws_uring_reap_sends(Ws_Uring* uring, Ws_Connection* conn)
+{
+    while (*uring->cq_head != __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE)) {
+        unsigned head = *uring->cq_head;
+        struct io_uring_cqe cqe = uring->cqes[head & *uring->cq_mask];
+        __atomic_store_n(uring->cq_head, head + 1, __ATOMIC_RELEASE);
+        if (cqe.user_data != ((__u64)(uintptr_t)conn | WS_URING_OP_SEND)) {
+            Ws_uring_defer(uring, &cqe);
+            continue;
+        }
+        conn->in_flight--;
+        if (cqe.res > 0) {
+            conn->output_sent += cqe.res;
+            Ws_connection_arm_timeout(uring->worker, conn, WS_TIMEOUT_WRITE);
+        } else {
+            conn->send_failed = true;
+        }
+    }
+}
+
+/**
+ * Send the queued output until at most limit bytes are left, waiting on the ring
+ *  No send is left in flight on return, the handler can then append to the output
+ */
+int
+Ws_uring_sink_drain(void* ctx, size_t limit)
+{
+    Ws_Connection* conn = ctx;
+    Ws_Uring* uring = current_uring;
+    while (conn->in_flight > 0 || (!conn->send_failed && conn->output.count - conn->output_sent > limit)) {
+        if (conn->in_flight == 0) {
+            if (!Ws_uring_reserve(uring, 1)) {
+                conn->send_failed = true;
+                break;
+            }
+            Ws_connection_arm_timeout(uring->worker, conn, WS_TIMEOUT_WRITE);
+            struct io_uring_sqe* sqe = Ws_uring_queue_link(uring, conn, WS_URING_OP_SEND, true);
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = conn->fd;
+            sqe->addr = (__u64)(uintptr_t)(conn->output.string + conn->output_sent);
+            sqe->len = conn->output.count - conn->output_sent;
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        }
+        // The send in flight must complete, a stopping server fails it
+        if (stop_server) shutdown(conn->fd, SHUT_RDWR);
+        int timeout = Ws_uring_expire(uring);
+        int ret = Ws_uring_submit(uring, 1, timeout);
+        if (ret < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN && errno != ETIME) {
+            shutdown(conn->fd, SHUT_RDWR);
+        }
+        Ws_uring_reap_sends(uring, conn);
+    }
+    if (conn->send_failed) return -1;
+
+    // Bytes sent are dropped, the output only holds what is left
+    conn->output.count -= conn->output_sent;
+    memmove(conn->output.string, conn->output.string + conn->output_sent, conn->output.count);
+    conn->output_sent = 0;
+    return 0;
+}
+
+/**
+ * Queue what is sent on conn's socket in its output until Ws_set_sink(NULL)
+ *  A streamed response is sent while it is written, from the handler's drains
+ */
+void
+Ws_uring_set_sink(Ws_Sink* sink, Ws_Connection* conn)
+{
+    *sink = (Ws_Sink){
+        .fd = conn->fd,
+        .ctx = conn,
+        .write = Ws_uring_sink_write,
+        .send_file = Ws_uring_sink_send_file,
+        .drain = Ws_uring_sink_drain
+    };
+    Ws_set_sink(sink);
+}
+
+/**
+ * Frame the first request buffered on conn
+ *  A streamed route can answer while its body is framed, through the sink
+ */
+Ws_Request_State
+Ws_uring_parse(Ws_Server* server, Ws_Connection* conn, size_t* len)
+{
+    Ws_Sink sink;
+    Ws_uring_set_sink(&sink, conn);
+    Ws_Request_State state = Ws_connection_parse(server, conn, len);
+    Ws_set_sink(NULL);
+    return state;
+}
+
+/**
+ * Run the first len bytes buffered on conn through the server pipeline,
+ *  a request refused while it was framed is answered instead
+ */
+void
+Ws_uring_process(Ws_Uring* uring, Ws_Server* server, Ws_Connection* conn, Ws_Request_State state, size_t len)
+{
+    Ws_Sink sink;
+    Ws_uring_set_sink(&sink, conn);
+    if (state >= WS_REQUEST_TOO_LARGE) Ws_connection_reject(server, conn, state);
+    else conn->keep_alive = Ws_connection_serve(server, conn, len, state == WS_REQUEST_COMPLETE);
+    Ws_set_sink(NULL);
+
+    Ws_uring_respond(uring, conn);
+}
+
+void
+Ws_uring_on_accept(Ws_Uring* uring, int res, unsigned flags)
+{
+    if (res >= 0) {
+        Ws_Connection* conn = Ws_connection_create(res);
+        if (conn == NULL) {
+            ERROR("Ws_uring_on_accept : connection alloc error");
+            close(res);
+        } else {
+            uring->connection_count++;
+            uring->worker->stats.connections++;
+            Ws_uring_recv(uring, conn);
+        }
+    } else if (res == -EINVAL && uring->accept_multishot) {
+        // Kernel older than 5.19, fall back to one accept per submission
+        uring->accept_multishot = false;
+    } else if (res != -ECANCELED) {
+        ERROR("Ws_uring_on_accept : accept error: %s", strerror(-res));
+    }
+
+    if (!(flags & IORING_CQE_F_MORE)) {
+        uring->accept_armed = false;
+        uring->accept_cancelling = false;
+    }
+    if (uring->connection_count >= uring->worker->max_connections) {
+        if (uring->accept_armed && !uring->accept_cancelling) Ws_uring_cancel_accept(uring);
+    } else if (!uring->accept_armed) {
+        Ws_uring_arm_accept(uring);
+    }
+}
+
+void
+Ws_uring_on_recv(Ws_Uring* uring, Ws_Server* server, Ws_Connection* conn, int res, unsigned flags)
+{
+    if (flags & IORING_CQE_F_BUFFER) {
+        int bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        if (res > 0) {
+            // Bytes past max_req_size are dropped, the request is refused below
+            size_t room = Ws_connection_reserve(server, conn, res);
+            size_t len = (size_t)res < room ? (size_t)res : room;
+            memcpy(conn->buffer + conn->count, uring->buffers + (size_t)bid * WS_BUFFER_MAX_LENGHT, len);
+            conn->count += len;
+        }
+        Ws_uring_provide_buffers(uring, bid, 1);
+    }
+
+    if (conn->timeout == WS_TIMEOUT_EXPIRED) {
+        Ws_uring_close(uring, conn);
+        return;
+    }
+    if (res == -ENOBUFS) {
+        // Every buffer was in use, the ones released above make the retry succeed
+        Ws_uring_recv(uring, conn);
+        return;
+    }
+    if (res < 0 || (res == 0 && conn->count == 0)) {
+        Ws_uring_close(uring, conn);
+        return;
+    }
+    size_t len;
+    Ws_Request_State state = Ws_uring_parse(server, conn, &len);
+    if (state != WS_REQUEST_INCOMPLETE) {
+        Ws_uring_process(uring, server, conn, state, len);
+    } else if (res == 0) {
+        // The peer closed its side, serve what was sent before closing
+        Ws_uring_process(uring, server, conn, state, conn->count);
+    } else {
+        Ws_uring_recv(uring, conn);
+    }
+}
+
+/**
+ * Move a kept-alive connection on once its response is sent:
+ *  answer the next pipelined request or wait for one
+ */
+void
+Ws_uring_on_sent(Ws_Uring* uring, Ws_Server* server, Ws_Connection* conn)
+{
+    if (!conn->keep_alive || stop_server) {
+        Ws_uring_close(uring, conn);
+        return;
+    }
+    Ws_connection_reset_output(conn);
+
+    size_t len;
+    Ws_Request_State state = Ws_uring_parse(server, conn, &len);
+    if (state != WS_REQUEST_INCOMPLETE) Ws_uring_process(uring, server, conn, state, len);
+    else Ws_uring_recv(uring, conn);
+}
+
+/**
+ * Record the bytes moved by a link of a response chain
+ *  Once the whole chain completed, the rest of a response sent short is
+ *  queued again, a failed link or a passed deadline close the connection
+ */
+void
+Ws_uring_on_link(Ws_Uring* uring, Ws_Server* server, Ws_Connection* conn, Ws_Uring_Op op, int res)
+{
+    conn->in_flight--;
+    if (res > 0) {
+        if (op == WS_URING_OP_SEND) conn->output_sent += res;
+        else if (op == WS_URING_OP_SPLICE_IN) conn->file_piped += res;
+        else conn->file_sent += res;
+        // Every link sent leaves a write_timeout for the next one
+        if (conn->timeout == WS_TIMEOUT_WRITE) Ws_connection_arm_timeout(uring->worker, conn, WS_TIMEOUT_WRITE);
+    } else if (res != -ECANCELED) {
+        // An error, or nothing moved: the file got shorter than its size
+        conn->send_failed = true;
+    }
+    if (conn->in_flight > 0) return;
+
+    if (conn->send_failed || conn->timeout == WS_TIMEOUT_EXPIRED) {
+        Ws_uring_close(uring, conn);
+    } else if (conn->output_sent < conn->output.count
+        || (conn->file_fd != -1 && conn->file_sent < conn->file_size)) {
+        Ws_uring_respond(uring, conn);
+    } else {
+        Ws_uring_on_sent(uring, server, conn);
+    }
+}
+
+void
+Ws_uring_on_closed(Ws_Uring* uring, Ws_Connection* conn)
+{
+    Ws_connection_free(conn);
+    uring->connection_count--;
+    if (!uring->accept_armed && uring->connection_count < uring->worker->max_connections) {
+        Ws_uring_arm_accept(uring);
+    }
+}
+
+/**
+ * Dispatch a completion
+ */
+void
+Ws_uring_complete(Ws_Uring* uring, Ws_Server* server, __u64 user_data, int res, unsigned flags)
+{
+    Ws_Uring_Op op = user_data & WS_URING_OP_MASK;
+    Ws_Connection* conn = (Ws_Connection*)(uintptr_t)(user_data & ~(__u64)WS_URING_OP_MASK);
+
+    switch (op) {
+        case WS_URING_OP_ACCEPT:
+            Ws_uring_on_accept(uring, res, flags);
+            break;
+        case WS_URING_OP_RECV:
+            Ws_uring_on_recv(uring, server, conn, res, flags);
+            break;
+        case WS_URING_OP_SEND:
+        case WS_URING_OP_SPLICE_IN:
+        case WS_URING_OP_SPLICE_OUT:
+            Ws_uring_on_link(uring, server, conn, op, res);
+            break;
+        case WS_URING_OP_CLOSE:
+            Ws_uring_on_closed(uring, conn);
+            break;
+        case WS_URING_OP_WATCH:
+            if (res < 0 && res != -EINTR) break;
+            Ws_file_cache_refresh(&uring->worker->files, &server->router);
+            Ws_uring_arm_watch(uring);
+            break;
+        case WS_URING_OP_IGNORE:
+        default:
+            break;
+    }
+}
+
+/**
+ * Handle every available completion
+ */
+void
+Ws_uring_reap(Ws_Uring* uring, Ws_Server* server)
+{
+    // Those kept while a handler drained its stream come first, handling one can defer more
+    for (size_t i = 0; i < uring->deferred_count; i++) {
+        struct io_uring_cqe cqe = uring->deferred[i];
+        Ws_uring_complete(uring, server, cqe.user_data, cqe.res, cqe.flags);
+    }
+    uring->deferred_count = 0;
+
+    // A drain moves the head too, it is read again for every completion
+    while (*uring->cq_head != __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE)) {
+        unsigned head = *uring->cq_head;
+        struct io_uring_cqe* cqe = &uring->cqes[head & *uring->cq_mask];
+        __u64 user_data = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        __atomic_store_n(uring->cq_head, head + 1, __ATOMIC_RELEASE);
+        Ws_uring_complete(uring, server, user_data, res, flags);
+    }
+}
+
+/**
+ * Shut down the connections whose deadline passed, the operation they
+ *  have in flight then fails and closes them
+ *  Returns the wait timeout until the next deadline
+ */
+int
+Ws_uring_expire(Ws_Uring* uring)
+{
+    Ws_Timer_Wheel* timers = &uring->worker->timers;
+    long now = Ws_now_ms();
+    Ws_Timer* timer;
+    while ((timer = Ws_timer_expire(timers, now)) != NULL) {
+        Ws_Connection* conn = timer->data;
+        conn->timeout = WS_TIMEOUT_EXPIRED;
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+    return Ws_timer_wheel_timeout(timers, now);
+}
+
+int
+Ws_uring_run(Ws_Server* server, Ws_Worker* worker)
+{
+    Ws_Uring uring = {0};
+    uring.worker = worker;
+    int ret = Ws_uring_init(&uring);
+    CHECK(ret == 0, "Ws_uring_run : io_uring setup error");
+    current_uring = &uring;
+
+    Ws_uring_provide_buffers(&uring, 0, WS_URING_BUFFER_COUNT);
+    Ws_uring_arm_accept(&uring);
+    Ws_uring_arm_watch(&uring);
+
+    while (!stop_server) {
+        // One syscall submits everything queued by the last batch and waits
+        // for the next, or for the nearest connection deadline.
+        // Completions deferred by a drain are handled without waiting
+        int timeout = Ws_uring_expire(&uring);
+        ret = Ws_uring_submit(&uring, uring.deferred_count > 0 ? 0 : 1, timeout);
+        if (ret < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN && errno != ETIME) {
+            ERROR("Ws_uring_run : io_uring_enter error: %s", strerror(errno));
+            break;
+        }
+        Ws_uring_reap(&uring, server);
+    }
+
+    current_uring = NULL;
+    Ws_uring_free(&uring);
+    return EXIT_SUCCESS;
+}
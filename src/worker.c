@@ -0,0 +1,267 @@
+#define _GNU_SOURCE
+#include "worker.h"
+#include "reactor.h"
+#include "uring.h"
+#include "jutils.h"
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Worker of the calling thread, set while it runs its event loop
+_Thread_local Ws_Worker* current_worker = NULL;
+
+Ws_Worker*
+Ws_current_worker(void)
+{
+    return current_worker;
+}
+
+void
+Ws_worker_init(Ws_Worker* worker, Ws_Server* server, int index, int sock_fd)
+{
+    worker->index = index;
+    worker->cpu = -1;
+    worker->sock_fd = sock_fd;
+    worker->max_connections = server->max_connections;
+    worker->stats = (Ws_Worker_Stats){0};
+    worker->arenas = (Ju_Arena_Pool){0};
+    Ws_timer_wheel_init(&worker->timers, Ws_now_ms());
+    worker->timeouts[WS_TIMEOUT_NONE] = 0;
+    worker->timeouts[WS_TIMEOUT_HEADER] = server->header_timeout * 1000L;
+    worker->timeouts[WS_TIMEOUT_BODY] = server->body_timeout * 1000L;
+    worker->timeouts[WS_TIMEOUT_IDLE] = server->keepalive_timeout * 1000L;
+    worker->timeouts[WS_TIMEOUT_WRITE] = server->write_timeout * 1000L;
+    Ws_file_cache_init(&worker->files, &server->router);
+    current_worker = worker;
+}
+
+void
+Ws_worker_free(Ws_Worker* worker)
+{
+    INFO("Worker %d stopped: %lu connections, %lu requests",
+        worker->index, worker->stats.connections, worker->stats.requests);
+    Ws_file_cache_free(&worker->files);
+    Ju_arena_pool_free(&worker->arenas);
+    if (current_worker == worker) current_worker = NULL;
+}
+
+/**
+ * Pin the calling thread to its CPU, if any, and run the event loop of worker index
+ */
+int
+Ws_worker_serve(Ws_Server* server, int index)
+{
+    int cpu = server->cpu_count > 0 ? server->cpu_list[index % server->cpu_count] : -1;
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        // 0 is the calling thread, not the whole process
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            WARN("Worker %d not pinned to CPU %d: %s", index, cpu, strerror(errno));
+            cpu = -1;
+        }
+    }
+
+    // Allocated once pinned so that its pages come from the local NUMA node,
+    // and on its own cache lines
+    size_t size = (sizeof(Ws_Worker) + WS_CACHE_LINE_SIZE - 1) / WS_CACHE_LINE_SIZE * WS_CACHE_LINE_SIZE;
+    Ws_Worker* worker = aligned_alloc(WS_CACHE_LINE_SIZE, size);
+    CHECK(worker != NULL, "Ws_worker_serve : worker alloc error");
+    Ws_worker_init(worker, server, index, server->worker_fds[index]);
+    worker->cpu = cpu;
+    // max_conn is a server wide limit, share it between workers,
+    // the first ones take a slot of the remainder each
+    int share = server->max_connections / server->worker_count
+        + (index < server->max_connections % server->worker_count);
+    worker->max_connections = share > 0 ? share : 1;
+
+    int ret;
+    switch (server->engine) {
+        case WS_ENGINE_URING:
+            ret = Ws_uring_run(server, worker);
+            break;
+        case WS_ENGINE_EPOLL:
+        case WS_ENGINE_FORK:
+        case WS_ENGINE_INVALID:
+        default:
+            ret = Ws_reactor_run(server, worker);
+            break;
+    }
+
+    Ws_worker_free(worker);
+    free(worker);
+    return ret;
+}
+
+/**
+ * Entry point of a worker process, never returns
+ */
+void
+Ws_worker_main(Ws_Server* server, int index)
+{
+    // Keep only this worker's listener
+    for (int i = 0; i < server->worker_count; i++) {
+        if (i != index) close(server->worker_fds[i]);
+    }
+    exit(Ws_worker_serve(server, index));
+}
+
+/**
+ * Fork the worker at index
+ */
+pid_t
+Ws_spawn_worker(Ws_Server* server, int index)
+{
+    // Do not duplicate buffered logs in the child
+    fflush(stdout);
+    pid_t pid = fork();
+    CHECK(pid >= 0, "Ws_spawn_worker : fork error");
+    if (pid == 0) {
+        Ws_worker_main(server, index);
+    }
+    server->worker_pids[index] = pid;
+    return pid;
+}
+
+/**
+ * Returns the index of the worker with the given pid, -1 if unknown
+ */
+int
+Ws_find_worker(Ws_Server* server, pid_t pid)
+{
+    for (int i = 0; i < server->worker_count; i++) {
+        if (server->worker_pids[i] == pid) return i;
+    }
+    return -1;
+}
+
+/**
+ * Entry point of a worker thread
+ */
+void*
+Ws_worker_thread(void* arg)
+{
+    Ws_Worker_Thread* thread = arg;
+    thread->ret = Ws_worker_serve(thread->server, thread->index);
+    return NULL;
+}
+
+/**
+ * Signal handler waking a worker thread up from a blocking wait
+ */
+void
+Ws_wake_handler(int signum)
+{
+    (void)signum;
+}
+
+/**
+ * Run every worker as a thread of this process until SIGINT
+ */
+int
+Ws_threads_run(Ws_Server* server)
+{
+    Ws_Worker_Thread* threads = calloc(server->worker_count, sizeof(Ws_Worker_Thread));
+    CHECK(threads != NULL, "Ws_threads_run : threads alloc error");
+
+    // SIGINT is left to this thread, which wakes the workers up with SIGUSR1.
+    // The workers inherit the mask with SIGINT blocked
+    Ws_handle_signal(SIGUSR1, Ws_wake_handler);
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+    for (int i = 0; i < server->worker_count; i++) {
+        threads[i].server = server;
+        threads[i].index = i;
+        int ret = pthread_create(&threads[i].id, NULL, Ws_worker_thread, &threads[i]);
+        CHECK(ret == 0, "Ws_threads_run : pthread_create error");
+    }
+    INFO("Started %d worker threads", server->worker_count);
+
+    // SIGINT is only delivered inside sigsuspend, it can't be missed between the check and the wait
+    while (!stop_server) sigsuspend(&previous);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    int ret = EXIT_SUCCESS;
+    for (int i = 0; i < server->worker_count; i++) {
+        // A worker signaled right before it blocks keeps waiting, signal it until it exits
+        struct timespec deadline;
+        do {
+            pthread_kill(threads[i].id, SIGUSR1);
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += WS_WORKER_WAKE_INTERVAL_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+        } while (pthread_timedjoin_np(threads[i].id, NULL, &deadline) == ETIMEDOUT);
+        if (threads[i].ret != EXIT_SUCCESS) ret = threads[i].ret;
+    }
+
+    free(threads);
+    return ret;
+}
+
+int
+Ws_workers_run(Ws_Server* server)
+{
+    if (server->worker_mode == WS_WORKER_THREAD) return Ws_threads_run(server);
+
+    int status;
+
+    server->worker_pids = calloc(server->worker_count, sizeof(pid_t));
+    CHECK(server->worker_pids != NULL, "Ws_workers_run : pids alloc error");
+
+    for (int i = 0; i < server->worker_count; i++) {
+        Ws_spawn_worker(server, i);
+    }
+    INFO("Started %d workers", server->worker_count);
+
+    int ret = EXIT_SUCCESS;
+    while (!stop_server) {
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            ERROR("Ws_workers_run : waitpid error");
+            ret = EXIT_FAILURE;
+            break;
+        }
+
+        int index = Ws_find_worker(server, pid);
+        if (index < 0 || stop_server) continue;
+        server->worker_pids[index] = 0;
+
+        // A worker only exits with EXIT_FAILURE through CHECK, retrying would fail again
+        if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE) {
+            ERROR("Worker %d failed, stopping server", index);
+            ret = EXIT_FAILURE;
+            break;
+        }
+
+        if (WIFSIGNALED(status)) {
+            WARN("Worker %d (pid %d) killed by signal %d, respawning", index, pid, WTERMSIG(status));
+        } else {
+            WARN("Worker %d (pid %d) exited, respawning", index, pid);
+        }
+        Ws_spawn_worker(server, index);
+    }
+
+    // Workers share the process group and usually got SIGINT already,
+    // forward it in case only the supervisor was signaled
+    for (int i = 0; i < server->worker_count; i++) {
+        if (server->worker_pids[i] > 0) kill(server->worker_pids[i], SIGINT);
+    }
+    while (wait(&status) > 0);
+
+    free(server->worker_pids);
+    server->worker_pids = NULL;
+    return ret;
+}
@@ -0,0 +1,126 @@
+#include "connection.h"
+#include "http.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+int failures = 0;
+
+/**
+ * Parse the head of raw and compare the result with the expected one
+ */
+void
+check_head(const char* raw, Http_Error expected, const char* expected_path)
+{
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", raw);
+    Http_Request req = {0};
+    char* body;
+    Http_Error err = Http_parse_head(&req, buf, strlen(buf), &body);
+    if (err != expected) {
+        fprintf(stderr, "ERROR(%s:%d): %d instead of %d for %.*s\n", __FILE__, __LINE__,
+            err, expected, (int)strcspn(raw, "\r"), raw);
+        failures++;
+        return;
+    }
+    if (expected_path != NULL && strcmp(req.path, expected_path) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): path %s instead of %s\n", __FILE__, __LINE__, req.path, expected_path);
+        failures++;
+    }
+}
+
+/**
+ * Process raw as a request read on a socket and compare the status line answered
+ */
+void
+check_answer(const char* raw, const char* expected_status, bool expected_keep_alive)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        failures++;
+        return;
+    }
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", raw);
+    Ws_Server server = {0};
+    Http_Request req = { .client_fd = fds[0] };
+    bool keep_alive = Ws_process_request(&server, &req, buf, strlen(buf), true);
+    char answer[512] = {0};
+    ssize_t ret = read(fds[1], answer, sizeof(answer) - 1);
+    if (ret <= 0 || strncmp(answer, expected_status, strlen(expected_status)) != 0 || keep_alive != expected_keep_alive) {
+        fprintf(stderr, "ERROR(%s:%d): answered %.*s (keep-alive %d) for %.*s\n", __FILE__, __LINE__,
+            (int)strcspn(answer, "\r"), answer, keep_alive, (int)strcspn(raw, "\r"), raw);
+        failures++;
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * Frame raw as the first request buffered on a connection
+ */
+void
+check_framing(const char* raw, Ws_Request_State expected, size_t expected_length)
+{
+    Ws_Server server = { .max_request_size = 4096 };
+    Ws_Connection* conn = Ws_connection_create(-1);
+    conn->count = strlen(raw);
+    memcpy(conn->buffer, raw, conn->count);
+    size_t len = 0;
+    Ws_Request_State state = Ws_connection_parse(&server, conn, &len);
+    if (state != expected || (state == WS_REQUEST_COMPLETE && len != expected_length)) {
+        fprintf(stderr, "ERROR(%s:%d): state %d of length %zu instead of %d for %s\n", __FILE__, __LINE__,
+            state, len, expected, raw);
+        failures++;
+    }
+    Ws_connection_free(conn);
+}
+
+int main(void) {
+    puts("Running test for request lines with colons in their target");
+    check_head("GET /a:b HTTP/1.1\r\nHost: x\r\n\r\n", HTTP_OK, "/a:b");
+    check_head("GET /t?x=12:30 HTTP/1.1\r\nHost: localhost:3000\r\n\r\n", HTTP_OK, "/t?x=12:30");
+    check_head("GET http://example.com:8080/ HTTP/1.1\r\n\r\n", HTTP_OK, "http://example.com:8080/");
+    // Past the first 64 bytes block of the scanner
+    check_head("GET /events?from=2026-10-17T04:17:42Z&to=2026-10-17T05:17:42Z&tz=+02:00 HTTP/1.1\r\n"
+        "Host: x\r\n\r\n", HTTP_OK, "/events?from=2026-10-17T04:17:42Z&to=2026-10-17T05:17:42Z&tz=+02:00");
+
+    puts("Running test for malformed request lines");
+    check_head("GET:/ HTTP/1.1\r\n\r\n", HTTP_ERR_MALFORMED_REQ, NULL);
+    check_head("GET /\r\n\r\n", HTTP_ERR_MALFORMED_REQ, NULL);
+    check_head("GET / HTTP/1.1 x\r\n\r\n", HTTP_ERR_MALFORMED_REQ, NULL);
+    check_head("GET / HTTP/1.1\r\nHost x\r\n\r\n", HTTP_ERR_MALFORMED_REQ, NULL);
+    check_head("GET / HTTP:1.1\r\n\r\n", HTTP_UNSUPPORTED_VERSION, NULL);
+    check_head("GET / HTTP/2.0\r\n\r\n", HTTP_UNSUPPORTED_VERSION, NULL);
+    check_head("GET /old HTTP/1.0\r\nHost: x\r\n\r\n", HTTP_OK, "/old");
+
+    puts("Running test for answers to requests that can't be parsed");
+    check_answer("GET / HTTP/2.0\r\nHost: x\r\n\r\n", "HTTP/1.1 505 ", false);
+    check_answer("GET / HTTP/1.1\r\nHost x\r\n\r\n", "HTTP/1.1 400 ", false);
+    check_answer("BREW / HTTP/1.1\r\nHost: x\r\n\r\n", "HTTP/1.1 400 ", false);
+    // Routed, with no route to find, and closed unless HTTP/1.1
+    check_answer("GET / HTTP/1.1\r\nHost: x\r\n\r\n", "HTTP/1.1 404 ", true);
+    check_answer("GET / HTTP/1.0\r\nHost: x\r\n\r\n", "HTTP/1.1 404 ", false);
+
+    puts("Running test for request bodies framing");
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 2\r\n\r\nabGET", WS_REQUEST_COMPLETE, 40);
+    check_framing("POST / HTTP/1.1\r\ncontent-length:2 \r\nContent-Length: 2\r\n\r\nab", WS_REQUEST_COMPLETE, 59);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nab", WS_REQUEST_INCOMPLETE, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n", WS_REQUEST_TOO_LARGE, 0);
+    // A body the server and a proxy in front of it could frame differently
+    check_framing("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nab\r\n0\r\n\r\n",
+        WS_REQUEST_UNSUPPORTED_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\ntransfer-encoding:identity\r\n\r\n", WS_REQUEST_UNSUPPORTED_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 2\r\nTransfer-Encoding: chunked\r\n\r\nab",
+        WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nTransfer-Encoding : chunked\r\n\r\n", WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\nabc", WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n", WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: 1 2\r\n\r\n", WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n", WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length:\r\n\r\n", WS_REQUEST_BAD_FRAMING, 0);
+    check_framing("POST / HTTP/1.1\r\nContent-Length : 2\r\n\r\nab", WS_REQUEST_BAD_FRAMING, 0);
+    return failures > 0;
+}
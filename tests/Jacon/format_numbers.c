@@ -0,0 +1,161 @@
+#include "jacon.h"
+#include "jacon_number.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int failures = 0;
+
+void
+check_double(double value, const char* expected)
+{
+    char out[JACON_NUMBER_MAX_LENGTH + 1];
+    out[Jacon_format_double(out, value)] = '\0';
+    if (strcmp(out, expected) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %.17g written as %s instead of %s\n", __FILE__, __LINE__, value, out, expected);
+        failures++;
+    }
+}
+
+void
+check_float(float value, const char* expected)
+{
+    char out[JACON_NUMBER_MAX_LENGTH + 1];
+    out[Jacon_format_float(out, value)] = '\0';
+    if (strcmp(out, expected) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %.9g written as %s instead of %s\n", __FILE__, __LINE__, value, out, expected);
+        failures++;
+    }
+}
+
+/**
+ * Significant digits of a number written in plain or exponent notation
+ */
+int
+significant_digits(const char* str)
+{
+    int digits = 0;
+    int zeros = 0;
+    bool leading = true;
+    for (; *str != '\0' && *str != 'e'; str++) {
+        if (*str < '0' || *str > '9') continue;
+        if (*str == '0') {
+            // Leading zeros don't count, trailing ones only before another digit
+            if (!leading) zeros++;
+            continue;
+        }
+        leading = false;
+        digits += zeros + 1;
+        zeros = 0;
+    }
+    return digits > 0 ? digits : 1;
+}
+
+/**
+ * Check that value is written with as few digits as reading it back needs
+ */
+void
+check_shortest(double value)
+{
+    char out[JACON_NUMBER_MAX_LENGTH + 1];
+    out[Jacon_format_double(out, value)] = '\0';
+    double back = strtod(out, NULL);
+    if (memcmp(&back, &value, sizeof(back)) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %.17g written as %s, read back as %.17g\n", __FILE__, __LINE__, value, out, back);
+        failures++;
+        return;
+    }
+    // The fewest digits printf needs to round trip
+    int shortest = 1;
+    for (; shortest < 17; shortest++) {
+        char str[40];
+        snprintf(str, sizeof(str), "%.*e", shortest - 1, value);
+        if (strtod(str, NULL) == value) break;
+    }
+    if (significant_digits(out) > shortest) {
+        fprintf(stderr, "ERROR(%s:%d): %.17g written as %s, %d digits are enough\n", __FILE__, __LINE__,
+            value, out, shortest);
+        failures++;
+    }
+}
+
+void
+check_float_round_trip(float value)
+{
+    char out[JACON_NUMBER_MAX_LENGTH + 1];
+    out[Jacon_format_float(out, value)] = '\0';
+    float back = strtof(out, NULL);
+    if (memcmp(&back, &value, sizeof(back)) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %.9g written as %s, read back as %.9g\n", __FILE__, __LINE__, value, out, back);
+        failures++;
+    }
+}
+
+uint64_t
+next_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(void) {
+    puts("Running test for number notation");
+    check_double(0, "0.0");
+    check_double(-0.0, "-0.0");
+    check_double(1, "1.0");
+    check_double(-1, "-1.0");
+    check_double(0.1, "0.1");
+    check_double(0.30000000000000004, "0.30000000000000004");
+    check_double(123456.789, "123456.789");
+    check_double(1e20, "100000000000000000000.0");
+    check_double(1e21, "1e21");
+    check_double(1.5e21, "1.5e21");
+    check_double(1e-6, "0.000001");
+    check_double(2.5e-5, "0.000025");
+    check_double(1e-7, "1e-7");
+    check_double(1.2345e-7, "1.2345e-7");
+    check_double(5e-324, "5e-324");
+    check_double(1.7976931348623157e308, "1.7976931348623157e308");
+    check_double(INFINITY, "null");
+    check_double(NAN, "null");
+    check_float(0.1f, "0.1");
+    check_float(1.0f, "1.0");
+    check_float(16777216.0f, "16777216.0");
+    check_float(3.4028235e38f, "3.4028235e38");
+    check_float(1e-45f, "1e-45");
+
+    puts("Running test for shortest round-trip output");
+    const double values[] = { 0.1, 0.2, 0.7, 1.0 / 3, 2.0 / 3, 5e-324, 2.2250738585072014e-308,
+        2.2250738585072009e-308, 9007199254740993.0, 4.35, 1e23, 8.41e21, 5.764607523034235e39 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) check_shortest(values[i]);
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 200000 && failures < 10; i++) {
+        uint64_t bits = next_random(&state);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        if (isfinite(value)) check_shortest(value);
+        // Decimals as written by people
+        check_shortest((double)(bits % 10000000) / 1000);
+        uint32_t fbits = (uint32_t)(bits >> 32);
+        float fvalue;
+        memcpy(&fvalue, &fbits, sizeof(fvalue));
+        if (isfinite(fvalue)) check_float_round_trip(fvalue);
+    }
+
+    puts("Running test for numbers serialized in documents");
+    Jacon_content content = {0};
+    Jacon_init_content(&content);
+    const char* input = "[0.1,1e21,-2.5e-7,3.0,1.7976931348623157e308,-9223372036854775808,18446744073709551615]";
+    char* str = NULL;
+    if (Jacon_deserialize(&content, input) != JACON_OK || Jacon_serialize_unformatted(content.root, NULL, &str) != JACON_OK
+        || strcmp(str, input) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %s serialized as %s\n", __FILE__, __LINE__, input, str != NULL ? str : "(null)");
+        failures++;
+    }
+    free(str);
+    Jacon_free_content(&content);
+    return failures > 0;
+}
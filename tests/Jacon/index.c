@@ -0,0 +1,133 @@
+#include "jacon.h"
+#include "jacon_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_SIZE 512
+
+int failures = 0;
+
+uint64_t
+next_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * Structural characters of a valid input, a character at a time
+ */
+size_t
+reference_index(const char* input, size_t len, uint32_t* offsets)
+{
+    size_t count = 0;
+    bool in_string = false;
+    bool scalar = false;
+    for (size_t i = 0; i < len; i++) {
+        char c = input[i];
+        if (in_string) {
+            if (c == '\\') i++;
+            else if (c == '"') {
+                offsets[count++] = i;
+                in_string = false;
+            }
+            continue;
+        }
+        bool op = strchr("{}[]:,", c) != NULL;
+        bool whitespace = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        if (c == '"') {
+            offsets[count++] = i;
+            in_string = true;
+        } else if (op || (!whitespace && !scalar)) {
+            offsets[count++] = i;
+        }
+        scalar = !op && !whitespace && c != '"';
+    }
+    return count;
+}
+
+/**
+ * Members whose strings are runs of backslashes and quotes, so that escapes cross blocks
+ */
+size_t
+make_input(char* input, uint64_t* state)
+{
+    size_t len = 0;
+    input[len++] = '{';
+    for (int member = 0; len < INPUT_SIZE - 160; member++) {
+        if (member > 0) input[len++] = ',';
+        len += snprintf(input + len, INPUT_SIZE - len, "\"k%d\":%s\"", member, next_random(state) & 1 ? " " : "");
+        int chars = next_random(state) % 40;
+        for (int i = 0; i < chars; i++) {
+            switch (next_random(state) % 6) {
+                case 0: input[len++] = '\\'; input[len++] = '\\'; break;
+                case 1: input[len++] = '\\'; input[len++] = '"'; break;
+                case 2: input[len++] = '{'; break;
+                case 3: input[len++] = ','; break;
+                default: input[len++] = 'a'; break;
+            }
+        }
+        input[len++] = '"';
+        if (next_random(state) & 1) len += snprintf(input + len, INPUT_SIZE - len, ",\"n%d\":[-1.5e3,true,null]", member);
+    }
+    input[len++] = '}';
+    input[len] = '\0';
+    return len;
+}
+
+void
+check_classifier(const char* name)
+{
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    char input[INPUT_SIZE];
+    uint32_t expected[INPUT_SIZE];
+    for (int i = 0; i < 2000; i++) {
+        size_t len = make_input(input, &state);
+        size_t expected_count = reference_index(input, len, expected);
+        Jacon_Index index = {0};
+        Jacon_Error ret = Jacon_index_build(&index, input, len);
+        if (ret != JACON_OK || index.count != expected_count
+            || memcmp(index.offsets, expected, expected_count * sizeof(uint32_t)) != 0) {
+            fprintf(stderr, "ERROR(%s:%d): %s classifier indexed %zu of %zu structurals (%d) in %s\n",
+                __FILE__, __LINE__, name, index.count, expected_count, ret, input);
+            failures++;
+            Jacon_index_free(&index);
+            return;
+        }
+        Jacon_index_free(&index);
+    }
+
+    const char* unclosed = "{\"a\": \"\\\"}";
+    Jacon_Index index = {0};
+    if (Jacon_index_build(&index, unclosed, strlen(unclosed)) != JACON_ERR_CHAR_NOT_FOUND) {
+        fprintf(stderr, "ERROR(%s:%d): %s classifier closed an escaped quote\n", __FILE__, __LINE__, name);
+        failures++;
+    }
+    Jacon_index_free(&index);
+    const char* control = "[\"a\tb\"]";
+    if (Jacon_index_build(&index, control, strlen(control)) != JACON_ERR_INVALID_ESCAPE_SEQUENCE) {
+        fprintf(stderr, "ERROR(%s:%d): %s classifier let a tab in a string\n", __FILE__, __LINE__, name);
+        failures++;
+    }
+    Jacon_index_free(&index);
+}
+
+int main(void) {
+    printf("Running test for structural indexing, %s selected\n", Jacon_index_init());
+    Jacon_index_block = Jacon_index_block_scalar;
+    check_classifier("scalar");
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        Jacon_index_block = Jacon_index_block_sse42;
+        check_classifier("sse4.2");
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        Jacon_index_block = Jacon_index_block_avx2;
+        check_classifier("avx2");
+    }
+#endif
+    return failures > 0;
+}
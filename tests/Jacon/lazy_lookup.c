@@ -0,0 +1,94 @@
+#include "jacon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int failures = 0;
+
+void
+expect_string(Jacon_content* content, const char* path, const char* expected, int line)
+{
+    char* value = NULL;
+    Jacon_Error err = Jacon_get_string_by_name(content, path, &value);
+    if (err != JACON_OK || strcmp(value, expected) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %s is %s (%d) instead of %s\n", __FILE__, line, path,
+            value != NULL ? value : "(null)", err, expected);
+        failures++;
+    }
+    free(value);
+}
+
+void
+expect_int(Jacon_content* content, const char* path, int expected, int line)
+{
+    int value = 0;
+    Jacon_Error err = Jacon_get_int_by_name(content, path, &value);
+    if (err != JACON_OK || value != expected) {
+        fprintf(stderr, "ERROR(%s:%d): %s is %d (%d) instead of %d\n", __FILE__, line, path, value, err, expected);
+        failures++;
+    }
+}
+
+void
+expect_error(Jacon_content* content, const char* path, Jacon_Error expected, int line)
+{
+    Jacon_Node node;
+    Jacon_Error err = Jacon_find(content, path, &node);
+    if (err != expected) {
+        fprintf(stderr, "ERROR(%s:%d): looking %s up returned %d instead of %d\n", __FILE__, line, path, err, expected);
+        failures++;
+    }
+}
+
+int main(void) {
+    Jacon_content content = {0};
+    Jacon_init_content(&content);
+    const char* input = "{\"name\": \"first\", \"name_1\": \"second\", \"user\": {\"name\": \"inner\","
+        " \"tags\": [\"a\", \"b\"], \"age\": 7}, \"empty\": \"\", \"dup\": {\"x\": 1, \"x\": 2}, \"last\": 3}";
+    if (Jacon_deserialize_lazy(&content, input) != JACON_OK) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected invalid input\n", __FILE__, __LINE__);
+        return 1;
+    }
+
+    puts("Running test for lazy lookups");
+    expect_string(&content, "name", "first", __LINE__);
+    expect_string(&content, "name_1", "second", __LINE__);
+    expect_string(&content, "user.name", "inner", __LINE__);
+    expect_int(&content, "user.age", 7, __LINE__);
+    expect_string(&content, "empty", "", __LINE__);
+    expect_int(&content, "last", 3, __LINE__);
+
+    puts("Running test for repeated lazy lookups of names and strings terminated in place");
+    // The first lookups replaced the closing quotes of these names and strings
+    for (int i = 0; i < 3; i++) {
+        expect_string(&content, "name", "first", __LINE__);
+        expect_string(&content, "name_1", "second", __LINE__);
+        expect_string(&content, "user.name", "inner", __LINE__);
+        expect_string(&content, "empty", "", __LINE__);
+        expect_int(&content, "last", 3, __LINE__);
+    }
+
+    // Values built around strings already terminated
+    Jacon_Node user;
+    if (Jacon_find(&content, "user", &user) != JACON_OK || user.type != JACON_VALUE_OBJECT || user.child_count != 3
+        || strcmp(user.name, "user") != 0 || strcmp(user.childs[0].name, "name") != 0
+        || strcmp(user.childs[0].value.string_val, "inner") != 0 || user.childs[1].child_count != 2) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected user object\n", __FILE__, __LINE__);
+        failures++;
+    }
+    expect_string(&content, "user.name", "inner", __LINE__);
+
+    puts("Running test for lazy lookups of missing values");
+    expect_error(&content, "nam", JACON_ERR_KEY_NOT_FOUND, __LINE__);
+    expect_error(&content, "name_12", JACON_ERR_KEY_NOT_FOUND, __LINE__);
+    expect_error(&content, "user.tags.a", JACON_ERR_KEY_NOT_FOUND, __LINE__);
+    expect_error(&content, "name.first", JACON_ERR_KEY_NOT_FOUND, __LINE__);
+    // Duplicates are reported on the path and in the values built, not elsewhere
+    expect_error(&content, "dup.x", JACON_ERR_DUPLICATE_NAME, __LINE__);
+    expect_error(&content, "dup", JACON_ERR_DUPLICATE_NAME, __LINE__);
+    expect_error(&content, "", JACON_ERR_DUPLICATE_NAME, __LINE__);
+    expect_int(&content, "last", 3, __LINE__);
+
+    Jacon_free_content(&content);
+    return failures > 0;
+}
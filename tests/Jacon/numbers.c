@@ -0,0 +1,151 @@
+#include "jacon.h"
+#include "jacon_number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int failures = 0;
+
+/**
+ * Scan and convert str, which must be a number on its own
+ */
+Jacon_ValueType
+number_value(const char* str, Jacon_Value* value)
+{
+    Jacon_Number number;
+    const char* end = Jacon_scan_number(str, &number);
+    if (end == NULL || *end != '\0') {
+        fprintf(stderr, "ERROR(%s:%d): %s not scanned whole\n", __FILE__, __LINE__, str);
+        failures++;
+        return JACON_VALUE_NULL;
+    }
+    Jacon_ValueType type;
+    Jacon_number_value(str, &number, &type, value);
+    return type;
+}
+
+void
+check_integer(const char* str, Jacon_ValueType expected_type, int64_t expected)
+{
+    Jacon_Value value;
+    Jacon_ValueType type = number_value(str, &value);
+    int64_t got = type == JACON_VALUE_INT ? value.int_val : value.int64_val;
+    if (type != expected_type || got != expected) {
+        fprintf(stderr, "ERROR(%s:%d): %s read as %lld of type %d\n", __FILE__, __LINE__, str, (long long)got, type);
+        failures++;
+    }
+}
+
+void
+check_unsigned(const char* str, uint64_t expected)
+{
+    Jacon_Value value;
+    Jacon_ValueType type = number_value(str, &value);
+    if (type != JACON_VALUE_UINT64 || value.uint64_val != expected) {
+        fprintf(stderr, "ERROR(%s:%d): %s read as %llu of type %d\n", __FILE__, __LINE__, str,
+            (unsigned long long)value.uint64_val, type);
+        failures++;
+    }
+}
+
+/**
+ * Numbers beyond the integers and fractions are read as strtod rounds them
+ */
+void
+check_double(const char* str)
+{
+    Jacon_Value value;
+    Jacon_ValueType type = number_value(str, &value);
+    double expected = strtod(str, NULL);
+    double got = type == JACON_VALUE_FLOAT ? value.float_val : value.double_val;
+    if ((type != JACON_VALUE_FLOAT && type != JACON_VALUE_DOUBLE) || memcmp(&got, &expected, sizeof(got)) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): %s read as %.17g of type %d instead of %.17g\n", __FILE__, __LINE__,
+            str, got, type, expected);
+        failures++;
+    }
+}
+
+void
+check_scan_error(const char* str)
+{
+    Jacon_Number number;
+    const char* end = Jacon_scan_number(str, &number);
+    if (end != NULL && *end == '\0') {
+        fprintf(stderr, "ERROR(%s:%d): %s scanned as a number\n", __FILE__, __LINE__, str);
+        failures++;
+    }
+}
+
+uint64_t
+next_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(void) {
+    puts("Running test for int, int64 and uint64 limits");
+    check_integer("0", JACON_VALUE_INT, 0);
+    check_integer("-0", JACON_VALUE_INT, 0);
+    check_integer("2147483647", JACON_VALUE_INT, 2147483647);
+    check_integer("2147483648", JACON_VALUE_INT64, 2147483648LL);
+    check_integer("-2147483648", JACON_VALUE_INT, -2147483647 - 1);
+    check_integer("-2147483649", JACON_VALUE_INT64, -2147483649LL);
+    check_integer("9223372036854775807", JACON_VALUE_INT64, INT64_MAX);
+    check_integer("-9223372036854775807", JACON_VALUE_INT64, -INT64_MAX);
+    check_integer("-9223372036854775808", JACON_VALUE_INT64, INT64_MIN);
+    check_unsigned("9223372036854775808", 9223372036854775808ULL);
+    check_unsigned("18446744073709551615", UINT64_MAX);
+    // Past the 64-bit integers
+    check_double("18446744073709551616");
+    check_double("-9223372036854775809");
+    check_double("100000000000000000000000");
+    check_double("-0.0");
+
+    puts("Running test for decimal conversions");
+    const char* decimals[] = {
+        "0.1", "0.7", "1.5", "-2.25", "3.14159", "1e22", "1e23", "-1e-7", "9007199254740993.0",
+        "2.2250738585072014e-308", "2.2250738585072011e-308", "4.9e-324", "1.7976931348623157e308",
+        "1e400", "-1e400", "1e-400", "0.1e1", "123456789012345678901234567890", "0.30000000000000004",
+        "7.3177701707893310e+15", "1.00000000000000011102230246251565404236316680908203125",
+    };
+    for (size_t i = 0; i < sizeof(decimals) / sizeof(decimals[0]); i++) check_double(decimals[i]);
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 100000; i++) {
+        char str[64];
+        uint64_t random = next_random(&state);
+        double value;
+        uint64_t bits = next_random(&state);
+        memcpy(&value, &bits, sizeof(value));
+        if (value != value || value - value != 0) continue;
+        // Every digit needed, or a few decimals as written by people
+        if (random & 1) snprintf(str, sizeof(str), "%.16e", value);
+        else snprintf(str, sizeof(str), "%u.%0*u", (unsigned)(random >> 40) % 100000, (int)(random >> 8 & 7) + 1,
+            (unsigned)(random >> 16) % 10000);
+        check_double(str);
+        if (failures > 10) break;
+    }
+
+    puts("Running test for malformed numbers");
+    const char* malformed[] = { "", "-", "01", "-01", "1.", ".5", "1e", "1e+", "+1", "0x10", "1.e5", "--1" };
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) check_scan_error(malformed[i]);
+
+    puts("Running test for 64-bit integers in documents");
+    Jacon_content content = {0};
+    Jacon_init_content(&content);
+    if (Jacon_deserialize(&content, "{\"min\": -9223372036854775808, \"max\": 18446744073709551615}") != JACON_OK) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected invalid input\n", __FILE__, __LINE__);
+        failures++;
+    }
+    int64_t min = 0;
+    uint64_t max = 0;
+    if (Jacon_get_int64_by_name(&content, "min", &min) != JACON_OK || min != INT64_MIN
+        || Jacon_get_uint64_by_name(&content, "max", &max) != JACON_OK || max != UINT64_MAX) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected 64-bit values\n", __FILE__, __LINE__);
+        failures++;
+    }
+    Jacon_free_content(&content);
+    return failures > 0;
+}
@@ -0,0 +1,111 @@
+#include "jacon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Inputs the token array parser accepted
+const char* valid_inputs[] = {
+    "{}", "[]", "1", "-1", "0", "1.5", "-0.25e3", "1E2", "\"s\"", "true", "false", "null",
+    "{\"a\":1}",
+    " { \"a\" : [ 1 , 2 , { \"b\" : null } ] } ",
+    "[[[]]]",
+    "[1,\"x\",true,null,{}]",
+    "{\"a\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\"}",
+    "{\"a\":{\"b\":{\"c\":[1,2]}}}",
+    "\n\t{\"a\" :\r\n1}\n",
+};
+
+// Inputs it refused
+const char* invalid_inputs[] = {
+    "", " ", "{", "}", "[", "]",
+    "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "[1,]", "[,1]", "{,}", "{\"a\" 1}", "{a:1}", "{'a':1}", "{1:2}",
+    "[1 2]", "[\"a\" \"b\"]", "{\"a\":1 \"b\":2}", "[1]]", "{}{}", "{\"a\":1}}", "[1]x",
+    "\"abc", "\"a\\x\"", "\"\\u12\"", "[\"\t\"]",
+    "tru", "nul", "falsey", "NaN",
+    "01", "1.", ".5", "-", "1e", "+1", "[-]", "123abc",
+};
+
+int failures = 0;
+
+Jacon_Error
+deserialize(Jacon_content* content, const char* input, bool lazy)
+{
+    Jacon_init_content(content);
+    return lazy ? Jacon_deserialize_lazy(content, input) : Jacon_deserialize(content, input);
+}
+
+void
+check_inputs(bool lazy)
+{
+    for (size_t i = 0; i < sizeof(valid_inputs) / sizeof(valid_inputs[0]); i++) {
+        Jacon_content content = {0};
+        Jacon_Error err = deserialize(&content, valid_inputs[i], lazy);
+        if (err != JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): unexpected invalid input (%d): %s\n", __FILE__, __LINE__, err, valid_inputs[i]);
+            failures++;
+        }
+        Jacon_free_content(&content);
+    }
+    for (size_t i = 0; i < sizeof(invalid_inputs) / sizeof(invalid_inputs[0]); i++) {
+        Jacon_content content = {0};
+        if (deserialize(&content, invalid_inputs[i], lazy) == JACON_OK) {
+            fprintf(stderr, "ERROR(%s:%d): unexpected valid input: %s\n", __FILE__, __LINE__, invalid_inputs[i]);
+            failures++;
+        }
+        Jacon_free_content(&content);
+    }
+}
+
+/**
+ * Read the values of a document back, eagerly or lazily deserialized
+ */
+void
+check_values(bool lazy)
+{
+    Jacon_content content = {0};
+    const char* input = "{\"user\": {\"name\": \"a\\tb\\u00e9\", \"age\": 42, \"admin\": false},"
+        " \"scores\": [1, 2.5], \"ratio\": -0.25e3}";
+    if (deserialize(&content, input, lazy) != JACON_OK) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected invalid input\n", __FILE__, __LINE__);
+        failures++;
+        return;
+    }
+
+    // Strings are kept as written, escapes included
+    char* name = NULL;
+    if (Jacon_get_string_by_name(&content, "user.name", &name) != JACON_OK || strcmp(name, "a\\tb\\u00e9") != 0) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected user.name\n", __FILE__, __LINE__);
+        failures++;
+    }
+    free(name);
+    int age = 0;
+    if (Jacon_get_int_by_name(&content, "user.age", &age) != JACON_OK || age != 42) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected user.age\n", __FILE__, __LINE__);
+        failures++;
+    }
+    bool admin = true;
+    if (Jacon_get_bool_by_name(&content, "user.admin", &admin) != JACON_OK || admin) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected user.admin\n", __FILE__, __LINE__);
+        failures++;
+    }
+    double ratio = 0;
+    if (Jacon_get_double_by_name(&content, "ratio", &ratio) != JACON_OK || ratio != -250) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected ratio\n", __FILE__, __LINE__);
+        failures++;
+    }
+    if (Jacon_get_int_by_name(&content, "user.missing", &age) != JACON_ERR_KEY_NOT_FOUND) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected user.missing\n", __FILE__, __LINE__);
+        failures++;
+    }
+    Jacon_free_content(&content);
+}
+
+int main(void) {
+    puts("Running test for inputs of the token array parser");
+    check_inputs(false);
+    check_values(false);
+    puts("Running test for inputs of the token array parser (lazy)");
+    check_inputs(true);
+    check_values(true);
+    return failures > 0;
+}
@@ -0,0 +1,167 @@
+#include "jacon.h"
+#include "jacon_stream.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TRACE_SIZE 4096
+
+int failures = 0;
+
+/**
+ * Events of a stream written one after the other, to compare two ways of feeding it
+ */
+typedef struct Trace {
+    char text[TRACE_SIZE];
+    size_t len;
+} Trace;
+
+int
+record_event(void* context, const Jacon_Event* event)
+{
+    Trace* trace = context;
+    char* out = trace->text + trace->len;
+    size_t size = TRACE_SIZE - trace->len;
+    int len = 0;
+    switch (event->type) {
+        case JACON_EVENT_OBJECT_START: len = snprintf(out, size, "{"); break;
+        case JACON_EVENT_OBJECT_END: len = snprintf(out, size, "}"); break;
+        case JACON_EVENT_ARRAY_START: len = snprintf(out, size, "["); break;
+        case JACON_EVENT_ARRAY_END: len = snprintf(out, size, "]"); break;
+        case JACON_EVENT_KEY: len = snprintf(out, size, "k(%s)", event->value.string_val); break;
+        case JACON_EVENT_DOCUMENT_END: len = snprintf(out, size, "$\n"); break;
+        case JACON_EVENT_VALUE:
+            switch (event->value_type) {
+                case JACON_VALUE_STRING: len = snprintf(out, size, "s(%s)", event->value.string_val); break;
+                case JACON_VALUE_INT: len = snprintf(out, size, "i(%d)", event->value.int_val); break;
+                case JACON_VALUE_INT64: len = snprintf(out, size, "l(%lld)", (long long)event->value.int64_val); break;
+                case JACON_VALUE_UINT64: len = snprintf(out, size, "u(%llu)", (unsigned long long)event->value.uint64_val); break;
+                case JACON_VALUE_FLOAT: len = snprintf(out, size, "f(%.9g)", event->value.float_val); break;
+                case JACON_VALUE_DOUBLE: len = snprintf(out, size, "d(%.17g)", event->value.double_val); break;
+                case JACON_VALUE_BOOLEAN: len = snprintf(out, size, "b(%d)", event->value.bool_val); break;
+                case JACON_VALUE_NULL: len = snprintf(out, size, "n"); break;
+                case JACON_VALUE_OBJECT:
+                case JACON_VALUE_ARRAY:
+                    len = snprintf(out, size, "?");
+                    break;
+            }
+            break;
+    }
+    if (len < 0 || (size_t)len >= size) return -1;
+    trace->len += len;
+    return 0;
+}
+
+/**
+ * Stream input fed in parts cut at the given offsets, cuts ends the list
+ */
+Jacon_Error
+stream_parts(const char* input, bool ndjson, const size_t* cuts, size_t cut_count, Trace* trace)
+{
+    trace->len = 0;
+    trace->text[0] = '\0';
+    Jacon_Stream stream;
+    Jacon_stream_init(&stream, record_event, trace);
+    stream.ndjson = ndjson;
+    size_t len = strlen(input);
+    size_t start = 0;
+    Jacon_Error ret = JACON_OK;
+    for (size_t i = 0; i <= cut_count && ret == JACON_OK; i++) {
+        size_t end = i < cut_count ? cuts[i] : len;
+        ret = Jacon_stream_feed(&stream, input + start, end - start);
+        start = end;
+    }
+    if (ret == JACON_OK) ret = Jacon_stream_finish(&stream);
+    Jacon_stream_free(&stream);
+    return ret;
+}
+
+/**
+ * Check that input gives the same events however it is cut in two or three parts,
+ *  or fed a byte at a time
+ */
+void
+check_resumption(const char* input, bool ndjson, const char* expected)
+{
+    size_t len = strlen(input);
+    Trace whole;
+    if (stream_parts(input, ndjson, NULL, 0, &whole) != JACON_OK || strcmp(whole.text, expected) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected events for %s:\n%s\n", __FILE__, __LINE__, input, whole.text);
+        failures++;
+        return;
+    }
+
+    Trace trace;
+    for (size_t i = 0; i <= len; i++) {
+        for (size_t j = i; j <= len; j++) {
+            size_t cuts[] = { i, j };
+            Jacon_Error ret = stream_parts(input, ndjson, cuts, 2, &trace);
+            if (ret != JACON_OK || strcmp(trace.text, whole.text) != 0) {
+                fprintf(stderr, "ERROR(%s:%d): %s cut at %zu and %zu returned %d:\n%s\n",
+                    __FILE__, __LINE__, input, i, j, ret, trace.text);
+                failures++;
+                return;
+            }
+        }
+    }
+
+    size_t cuts[256];
+    for (size_t i = 0; i < len && i < 256; i++) cuts[i] = i + 1;
+    if (len <= 256 && (stream_parts(input, ndjson, cuts, len, &trace) != JACON_OK || strcmp(trace.text, whole.text) != 0)) {
+        fprintf(stderr, "ERROR(%s:%d): %s fed a byte at a time:\n%s\n", __FILE__, __LINE__, input, trace.text);
+        failures++;
+    }
+}
+
+/**
+ * Check that input is refused with expected however it is cut in two
+ */
+void
+check_error(const char* input, bool ndjson, Jacon_Error expected)
+{
+    size_t len = strlen(input);
+    Trace trace;
+    for (size_t i = 0; i <= len; i++) {
+        size_t cuts[] = { i };
+        Jacon_Error ret = stream_parts(input, ndjson, cuts, 1, &trace);
+        if (ret != expected) {
+            fprintf(stderr, "ERROR(%s:%d): %s cut at %zu returned %d instead of %d\n",
+                __FILE__, __LINE__, input, i, ret, expected);
+            failures++;
+            return;
+        }
+    }
+}
+
+int main(void) {
+    puts("Running test for streams resumed mid-string and mid-escape");
+    check_resumption("{\"na\\\"me\": \"a\\\\b\\u00e9\\n\", \"\": \"\"}", false,
+        "{k(na\\\"me)s(a\\\\b\\u00e9\\n)k()s()}$\n");
+    check_resumption("[\"\\ud83d\\ude00\", \"\\/\"]", false, "[s(\\ud83d\\ude00)s(\\/)]$\n");
+
+    puts("Running test for streams resumed mid-number and mid-literal");
+    check_resumption("[-12.5e-3, 0, 2147483648, -9223372036854775808, 18446744073709551615, 1E2, 0.5]", false,
+        "[d(-0.012500000000000001)i(0)l(2147483648)l(-9223372036854775808)u(18446744073709551615)f(100)f(0.5)]$\n");
+    check_resumption("{\"a\": true, \"b\": false, \"c\": null, \"d\": [[], {}]}", false,
+        "{k(a)b(1)k(b)b(0)k(c)nk(d)[[]{}]}$\n");
+    check_resumption("123", false, "i(123)$\n");
+    check_resumption("  \"top\"  ", false, "s(top)$\n");
+
+    puts("Running test for ndjson streams");
+    check_resumption("{\"id\": 1}\n{\"id\": 2}\n[3]\n", true, "{k(id)i(1)}$\n{k(id)i(2)}$\n[i(3)]$\n");
+    check_resumption("1\n\n\"x\"\r\nnull", true, "i(1)$\ns(x)$\nn$\n");
+    check_resumption("", true, "");
+
+    puts("Running test for invalid streams");
+    check_error("{\"a\": \"\\x\"}", false, JACON_ERR_INVALID_ESCAPE_SEQUENCE);
+    check_error("{\"a\": \"\\u12g4\"}", false, JACON_ERR_INVALID_ESCAPE_SEQUENCE);
+    check_error("{\"a\": 1,}", false, JACON_ERR_INVALID_JSON);
+    check_error("[1 2]", false, JACON_ERR_INVALID_JSON);
+    check_error("[01]", false, JACON_ERR_INVALID_JSON);
+    check_error("[tru]", false, JACON_ERR_INVALID_JSON);
+    check_error("{\"a\": \"b", false, JACON_ERR_INVALID_JSON);
+    check_error("[1, 2", false, JACON_ERR_INVALID_JSON);
+    check_error("1 2", false, JACON_ERR_INVALID_JSON);
+    check_error("1 2", true, JACON_ERR_INVALID_JSON);
+    check_error("", false, JACON_ERR_EMPTY_INPUT);
+    return failures > 0;
+}
@@ -0,0 +1,93 @@
+#include "jacon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int failures = 0;
+
+/**
+ * Check that the childs of node and its descendants are ranges of nodes
+ */
+size_t
+check_ranges(const Jacon_Node* node, const Jacon_Node* nodes, size_t node_count)
+{
+    size_t count = 0;
+    if (node->child_count > 0 && (node->child_capacity != 0 || node->childs < nodes
+        || node->childs + node->child_count > nodes + node_count)) {
+        fprintf(stderr, "ERROR(%s:%d): childs of %s out of the content's nodes\n", __FILE__, __LINE__,
+            node->name != NULL ? node->name : "(root)");
+        failures++;
+    }
+    for (size_t i = 0; i < node->child_count; i++) {
+        count += 1 + check_ranges(&node->childs[i], nodes, node_count);
+    }
+    return count;
+}
+
+void
+expect_json(Jacon_Node* node, const char* expected, int line)
+{
+    char* str = NULL;
+    if (Jacon_serialize_unformatted(node, NULL, &str) != JACON_OK || strcmp(str, expected) != 0) {
+        fprintf(stderr, "ERROR(%s:%d): serialized as %s instead of %s\n", __FILE__, line, str != NULL ? str : "(null)", expected);
+        failures++;
+    }
+    free(str);
+}
+
+int main(void) {
+    const char* input = "{\"a\":[1,[2,3],{\"b\":\"c\"}],\"d\":{\"e\":{}},\"f\":[],\"g\":null}";
+
+    puts("Running test for parsed trees laid out in one block");
+    Jacon_content content = {0};
+    Jacon_init_content(&content);
+    if (Jacon_deserialize(&content, input) != JACON_OK) {
+        fprintf(stderr, "ERROR(%s:%d): unexpected invalid input\n", __FILE__, __LINE__);
+        return 1;
+    }
+    size_t count = check_ranges(content.root, content.nodes, content.node_count);
+    if (count != content.node_count || count != 11) {
+        fprintf(stderr, "ERROR(%s:%d): %zu nodes in the tree, %zu in the block\n", __FILE__, __LINE__,
+            count, content.node_count);
+        failures++;
+    }
+    expect_json(content.root, input, __LINE__);
+
+    puts("Running test for heap copies of parsed trees");
+    Jacon_Node* copy = Jacon_duplicate_node(content.root);
+    Jacon_free_content(&content);
+    if (copy == NULL) {
+        fprintf(stderr, "ERROR(%s:%d): duplicate failed\n", __FILE__, __LINE__);
+        return 1;
+    }
+    // The copy owns its childs, outliving the content and growing past its capacity
+    expect_json(copy, input, __LINE__);
+    for (int i = 0; i < 2 * JACON_NODE_DEFAULT_CHILD_CAPACITY; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "n%d", i);
+        Jacon_Node child = Jacon_int_prop(name, i);
+        if (Jacon_append_child(copy, &child) != JACON_OK) failures++;
+    }
+    Jacon_Node nested = Jacon_array();
+    Jacon_Node item = Jacon_string("x");
+    Jacon_append_child(&nested, &item);
+    nested.name = strdup("h");
+    Jacon_append_child(copy, &nested);
+    expect_json(copy, "{\"a\":[1,[2,3],{\"b\":\"c\"}],\"d\":{\"e\":{}},\"f\":[],\"g\":null,"
+        "\"n0\":0,\"n1\":1,\"n2\":2,\"n3\":3,\"n4\":4,\"n5\":5,\"n6\":6,\"n7\":7,\"h\":[\"x\"]}", __LINE__);
+    Jacon_free_node(copy);
+    free(copy);
+
+    puts("Running test for contents released with their arena");
+    Ju_Arena_Pool pool = {0};
+    Ju_Arena arena = { .pool = &pool };
+    for (int i = 0; i < 100; i++) {
+        Jacon_content pooled = { .arena = &arena };
+        Jacon_init_content(&pooled);
+        if (Jacon_deserialize(&pooled, input) != JACON_OK) failures++;
+        else if (i == 99) expect_json(pooled.root, input, __LINE__);
+        Ju_arena_reset(&arena);
+    }
+    Ju_arena_pool_free(&pool);
+    return failures > 0;
+}
@@ -0,0 +1,94 @@
+#include "jacon.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int failures = 0;
+
+void
+expect(Jacon_Error err, Jacon_Error expected, const char* what, int line)
+{
+    if (err != expected) {
+        fprintf(stderr, "ERROR(%s:%d): %s returned %d instead of %d\n", __FILE__, line, what, err, expected);
+        failures++;
+    }
+}
+
+/**
+ * Get the values of input with every getter, eagerly or lazily deserialized
+ */
+void
+check_getters(const char* input, bool lazy)
+{
+    Jacon_content content = {0};
+    Jacon_init_content(&content);
+    Jacon_Error err = lazy ? Jacon_deserialize_lazy(&content, input) : Jacon_deserialize(&content, input);
+    expect(err, JACON_OK, "deserialize", __LINE__);
+
+    // Arrays and numbers are not strings, named objects are not values and neither
+    // are paths through anything else than objects, however the input was parsed
+    char* str = NULL;
+    expect(Jacon_get_string_by_name(&content, "login", &str), JACON_ERR_KEY_NOT_FOUND, "string of object", __LINE__);
+    expect(Jacon_get_string_by_name(&content, "password.a", &str), JACON_ERR_KEY_NOT_FOUND, "through a string", __LINE__);
+    expect(Jacon_get_string_by_name(&content, "tags.0", &str), JACON_ERR_KEY_NOT_FOUND, "through an array", __LINE__);
+    expect(Jacon_get_string_by_name(&content, "none.a", &str), JACON_ERR_KEY_NOT_FOUND, "through null", __LINE__);
+    if (Jacon_exist_by_name(&content, "login", JACON_VALUE_OBJECT)) {
+        fprintf(stderr, "ERROR(%s:%d): object found as a value\n", __FILE__, __LINE__);
+        failures++;
+    }
+    expect(Jacon_get_string_by_name(&content, "tags", &str), JACON_ERR_INVALID_VALUE_TYPE, "string of array", __LINE__);
+    expect(Jacon_get_string_by_name(&content, "count", &str), JACON_ERR_INVALID_VALUE_TYPE, "string of int", __LINE__);
+    expect(Jacon_get_string_by_name(&content, "password", &str), JACON_OK, "string", __LINE__);
+    free(str);
+
+    int i;
+    expect(Jacon_get_int_by_name(&content, "password", &i), JACON_ERR_INVALID_VALUE_TYPE, "int of string", __LINE__);
+    expect(Jacon_get_int_by_name(&content, "big", &i), JACON_ERR_INVALID_VALUE_TYPE, "int of int64", __LINE__);
+    expect(Jacon_get_int_by_name(&content, "ratio", &i), JACON_ERR_INVALID_VALUE_TYPE, "int of float", __LINE__);
+
+    // Ints widen
+    int64_t i64;
+    expect(Jacon_get_int64_by_name(&content, "count", &i64), JACON_OK, "int64 of int", __LINE__);
+    if (i64 != 3) failures++;
+    expect(Jacon_get_int64_by_name(&content, "big", &i64), JACON_OK, "int64", __LINE__);
+    if (i64 != -5000000000LL) failures++;
+    expect(Jacon_get_int64_by_name(&content, "tags", &i64), JACON_ERR_INVALID_VALUE_TYPE, "int64 of array", __LINE__);
+
+    uint64_t u64;
+    expect(Jacon_get_uint64_by_name(&content, "count", &u64), JACON_OK, "uint64 of int", __LINE__);
+    if (u64 != 3) failures++;
+    expect(Jacon_get_uint64_by_name(&content, "big", &u64), JACON_ERR_INVALID_VALUE_TYPE, "uint64 of negative int64", __LINE__);
+    expect(Jacon_get_uint64_by_name(&content, "negative", &u64), JACON_ERR_INVALID_VALUE_TYPE, "uint64 of negative int", __LINE__);
+
+    // Floats widen, doubles don't narrow
+    double d;
+    expect(Jacon_get_double_by_name(&content, "ratio", &d), JACON_OK, "double of float", __LINE__);
+    if (d != 0.5) failures++;
+    float f;
+    expect(Jacon_get_float_by_name(&content, "precise", &f), JACON_ERR_INVALID_VALUE_TYPE, "float of double", __LINE__);
+    expect(Jacon_get_double_by_name(&content, "count", &d), JACON_ERR_INVALID_VALUE_TYPE, "double of int", __LINE__);
+
+    bool b;
+    expect(Jacon_get_bool_by_name(&content, "flag", &b), JACON_OK, "bool", __LINE__);
+    expect(Jacon_get_bool_by_name(&content, "none", &b), JACON_ERR_INVALID_VALUE_TYPE, "bool of null", __LINE__);
+    Jacon_free_content(&content);
+
+    // Single values
+    Jacon_content single = {0};
+    Jacon_init_content(&single);
+    err = lazy ? Jacon_deserialize_lazy(&single, "[1, 2]") : Jacon_deserialize(&single, "[1, 2]");
+    expect(err, JACON_OK, "deserialize", __LINE__);
+    expect(Jacon_get_string(&single, &str), JACON_ERR_INVALID_VALUE_TYPE, "single string of array", __LINE__);
+    expect(Jacon_get_int(&single, &i), JACON_ERR_INVALID_VALUE_TYPE, "single int of array", __LINE__);
+    Jacon_free_content(&single);
+}
+
+int main(void) {
+    const char* input = "{\"login\": {\"a\": \"b\"}, \"password\": \"x\", \"count\": 3, \"negative\": -1,"
+        " \"big\": -5000000000, \"ratio\": 0.5, \"precise\": 0.7, \"tags\": [1], \"flag\": true, \"none\": null}";
+
+    puts("Running test for getters of mismatched types");
+    check_getters(input, false);
+    puts("Running test for getters of mismatched types (lazy)");
+    check_getters(input, true);
+    return failures > 0;
+}